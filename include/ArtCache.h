@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+#include <functional>
+
+// Flash-backed cache of display-ready album art (RGB565, row-wise RLE when that is smaller).
+// Keyed by a hash of the normalized art URL; bounded by a byte budget with LRU eviction.
+class ArtCache {
+public:
+    typedef std::function<bool(uint16_t width, uint16_t height)> SizeCallback;
+    typedef std::function<void(uint16_t row, const uint16_t* pixels)> RowCallback;
+
+    bool begin(size_t budgetBytes = DEFAULT_BUDGET_BYTES);
+
+    // Calls onSize once, then onRow for each row. Returns false on a miss or a damaged entry.
+    bool load(const String& url, const SizeCallback& onSize, const RowCallback& onRow);
+    bool store(const String& url, const uint16_t* pixels, uint16_t width, uint16_t height);
+    void update();  // Persists LRU order changed by hits, at most once a minute
+
+    uint32_t hits() const { return _hits; }
+    uint32_t misses() const { return _misses; }
+
+    static String normalizeUrl(const String& url);
+    static uint32_t hashUrl(const String& url);
+
+private:
+    struct Entry {
+        uint32_t hash;
+        uint32_t bytes;
+        uint32_t lastUse;  // Value of _useClock when last loaded or stored
+    };
+
+    static const size_t DEFAULT_BUDGET_BYTES = 384 * 1024;
+    static const unsigned long INDEX_FLUSH_INTERVAL_MS = 60000;
+
+    std::vector<Entry> _entries;
+    size_t _budgetBytes = DEFAULT_BUDGET_BYTES;
+    size_t _totalBytes = 0;
+    uint32_t _useClock = 0;
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+    bool _ready = false;
+    bool _indexDirty = false;
+    unsigned long _lastIndexFlushMs = 0;
+
+    static String pathFor(uint32_t hash);
+    Entry* findEntry(uint32_t hash);
+    void removeEntry(uint32_t hash);
+    bool saveIndex();
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include <Arduino.h>
+#include <functional>
+#include <vector>
+
+// Area-averaging RGB565 resampler in 16.16 fixed point. Source rows are pushed one at a time as
+// the decoder produces them and finished destination rows come out through the sink, so neither
+// image has to be held in full.
+class ArtResampler {
+public:
+    using RowSink = std::function<void(uint16_t row, const uint16_t* pixels)>;
+
+    // Largest size with the source aspect ratio that fits the box
+    static void fitToBox(uint16_t srcW, uint16_t srcH, uint16_t boxW, uint16_t boxH, uint16_t& dstW, uint16_t& dstH);
+    // log2 of the largest power-of-two reduction that still leaves the source at or above the target size
+    static uint8_t decodeScale(uint16_t srcW, uint16_t srcH, uint16_t dstW, uint16_t dstH, uint8_t maxScale = 3);
+
+    bool begin(uint16_t srcW, uint16_t srcH, uint16_t dstW, uint16_t dstH, RowSink sink);
+    void pushRow(const uint16_t* pixels);
+    bool finished() const { return _dstRow >= _dstH; }
+
+private:
+    uint16_t _srcW = 0, _srcH = 0, _dstW = 0, _dstH = 0;
+    uint32_t _stepX = 0, _stepY = 0;  // Source pixels per destination pixel, 16.16
+    uint32_t _srcRow = 0;
+    uint16_t _dstRow = 0;
+    RowSink _sink;
+    bool _halving = false;            // Exactly 2:1 on both axes; uses the 2x2 kernel on row pairs
+
+    std::vector<uint16_t> _rowSums;   // Horizontally averaged row, R/G/B per pixel in 8.8
+    std::vector<uint32_t> _columns;   // Vertical accumulation for the destination row in progress
+    uint32_t _columnWeight = 0;       // Sum of the vertical weights in _columns, 1/256 of a source row
+    std::vector<uint16_t> _out;
+    std::vector<uint16_t> _pendingRow;  // Even source row waiting for its partner when halving
+
+    void averageRow(const uint16_t* pixels);
+    void emitRow();
+};
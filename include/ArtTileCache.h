@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+
+// Decoded, display-sized RGB565 art tiles held in PSRAM, keyed by art URL, with LRU eviction.
+// A hit is a ready-to-blit buffer; nothing touches the network or flash.
+class ArtTileCache {
+public:
+    struct Tile {
+        String url;
+        uint16_t* pixels;
+        uint16_t width;
+        uint16_t height;
+        uint32_t lastUse;
+    };
+
+    ~ArtTileCache();
+
+    bool begin(size_t budgetBytes = DEFAULT_BUDGET_BYTES);  // False when the board has no PSRAM
+    const Tile* get(const String& url);
+    bool contains(const String& url) const;  // Does not count as a lookup or refresh the LRU order
+    bool put(const String& url, const uint16_t* pixels, uint16_t width, uint16_t height);
+    void clear();
+
+    uint32_t hits() const { return _hits; }
+    uint32_t misses() const { return _misses; }
+    uint32_t evictions() const { return _evictions; }
+    size_t usedBytes() const { return _usedBytes; }
+
+private:
+    static const size_t DEFAULT_BUDGET_BYTES = 1024 * 1024;
+
+    std::vector<Tile> _tiles;
+    size_t _budgetBytes = 0;
+    size_t _usedBytes = 0;
+    uint32_t _useClock = 0;
+    uint32_t _hits = 0;
+    uint32_t _misses = 0;
+    uint32_t _evictions = 0;
+
+    static size_t tileBytes(const Tile& tile) { return (size_t)tile.width * tile.height * sizeof(uint16_t); }
+    Tile* find(const String& url);
+    void evictOldest();
+    void release(size_t index);
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include <functional>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "ArtCache.h"
+#include "ConnectionPool.h"
+
+struct ArtDecodeContext;
+
+// A decoded, display-sized RGB565 image; pixels are heap-allocated and owned by the holder
+struct ArtImage {
+    String url;
+    uint16_t* pixels = nullptr;
+    uint16_t width = 0;
+    uint16_t height = 0;
+};
+
+// Fetches and decodes album art on its own task, pinned away from the UI core. Requests and
+// results are handed over through single-slot atomic pointers, so neither side ever waits.
+// Network JPEG art for display that is slow to download arrives twice: a 1/8-scale preview, then
+// the full-quality image.
+class ArtWorker {
+public:
+    enum class Purpose : uint8_t { Display = 0, Prefetch = 1 };
+
+    // The Now Playing art box; network art is scaled to fit it exactly
+    static const uint16_t BOX_WIDTH = 240;
+    static const uint16_t BOX_HEIGHT = 94;
+
+    struct Result {
+        ArtImage image;
+        Purpose purpose;
+        bool ok;
+        const char* source;  // "flash" or "network"
+        unsigned long requestedMs;
+        unsigned long finishedMs;
+        bool preview;  // Coarse first pass; the full-quality result for the same URL follows
+    };
+
+    explicit ArtWorker(ArtCache& cache) : _cache(cache) {}
+
+    bool begin(BaseType_t core = 0);
+    // A newer request of the same purpose replaces a queued one and cancels one in flight
+    void request(const String& url, Purpose purpose);
+    Result* takeResult();  // Display results first; nullptr when nothing is ready
+    static void release(Result* result);
+    uint32_t cancelled() const { return _cancelled.load(); }
+
+private:
+    struct Job {
+        String url;
+        Purpose purpose;
+        unsigned long requestedMs;
+        unsigned long startAfterMs;
+        uint32_t generation;
+    };
+
+    static const unsigned long SETTLE_MS = 300;
+    static const uint32_t STACK_BYTES = 12288;
+    static const uint32_t IDLE_WAKE_MS = 5000;
+    static const int MAX_FETCH_ATTEMPTS = 4;  // Redirects plus one retry on a stale keep-alive connection
+
+    ArtCache& _cache;
+    ConnectionPool _connections;
+    TaskHandle_t _task = nullptr;
+    std::atomic<Job*> _pending[2] = {{nullptr}, {nullptr}};
+    std::atomic<Result*> _ready[2] = {{nullptr}, {nullptr}};
+    std::atomic<uint32_t> _generation[2] = {{0}, {0}};
+    unsigned long _lastDisplayRequestMs = 0;  // UI side only
+    std::atomic<uint32_t> _cancelled{0};  // Written by the art task, read from the UI
+
+    static void taskEntry(void* arg);
+    void run();
+    bool loadFromFlash(const String& url, ArtImage& image);
+    bool superseded(const Job& job) const;
+    bool fetch(const Job& job, ArtImage& image);
+    bool decode(ConnectionPool::Connection& connection, const Job& job, ArtImage& image);
+    bool decodeJpeg(ArtDecodeContext& context, const Job& job, ArtImage& image);
+    bool decodePng(ArtDecodeContext& context, ArtImage& image);
+};
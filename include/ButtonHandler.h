@@ -15,6 +15,7 @@ public:
     bool upLongPressed();
     bool downLongPressed();
     bool clickLongPressed();
+    unsigned long lastActivityMs() const { return lastDebounceTime; }  // Last time any button changed state
 
 private:
     Adafruit_MCP23X17& _mcp;
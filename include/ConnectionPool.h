@@ -0,0 +1,53 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <vector>
+
+class HTTPClient;
+
+// Keep-alive connections to art hosts, one per scheme/host/port, so consecutive images skip
+// the TCP connect and, for HTTPS, the TLS handshake. Not thread-safe; owned by the art worker.
+class ConnectionPool {
+public:
+    // The HTTPClient lives as long as its socket: destroying one stops the client it last used,
+    // so a fresh HTTPClient per request would close the connection after every image
+    struct Connection {
+        WiFiClient* client;
+        HTTPClient* http;
+    };
+
+    ~ConnectionPool();
+
+    // Connection for the URL's origin, connected if a previous request left it open; nullptr for unsupported schemes
+    Connection* acquire(const String& url);
+    // Keeps the connection for the next request, or closes it when the response was not fully consumed
+    void release(Connection* connection, bool reusable);
+    void closeIdle();  // Drops connections idle past IDLE_CLOSE_MS; servers time them out anyway
+    void closeAll();
+
+    uint32_t handshakes() const { return _handshakes; }
+    uint32_t reuses() const { return _reuses; }
+
+private:
+    struct Entry {
+        String origin;  // "https://host:port"
+        bool secure;
+        Connection* connection;
+        unsigned long lastUse;
+    };
+
+    static const size_t MAX_CONNECTIONS = 3;
+    static const unsigned long IDLE_CLOSE_MS = 30000;
+    // Each TLS session holds roughly 40 KB of mbedTLS buffers; idle ones go first when heap runs low
+    static const size_t TLS_HEAP_RESERVE = 64 * 1024;
+
+    std::vector<Entry> _entries;
+    uint32_t _handshakes = 0;
+    uint32_t _reuses = 0;
+
+    static bool parseOrigin(const String& url, String& origin, bool& secure);
+    Entry* find(const String& origin);
+    Entry* findConnection(const Connection* connection);
+    void remove(size_t index);
+    void evictIdle(const Connection* keep);
+};
@@ -25,7 +25,17 @@ public:
     
 private:
     static const char* CACHE_FILE;
+    static const char* TEMP_FILE;
+    static const char* LEGACY_JSON_FILE;
     bool filesystemReady = false;
+    // CRC of what is on flash, so unchanged saves are skipped
+    uint32_t _lastCrc = 0;
+    uint16_t _lastCount = 0;
+    bool _hasLastCrc = false;
+    uint16_t _writes = 0;
+    uint16_t _skippedWrites = 0;
+
+    bool migrateLegacyJson(std::vector<CachedDevice>& devices);
 };
 
 #endif
@@ -2,6 +2,7 @@
 #include <Arduino.h>
 #include <Sonos.h>
 #include <vector>
+#include <map>
 #include <functional>
 #include "DeviceCache.h"
 
@@ -13,6 +14,9 @@ public:
     
     void begin();
     bool update();
+    // Only the non-blocking part of update(): NOTIFYs and their description fetches. Cache
+    // validation, scans and resolves wait until update() runs again.
+    void updatePresence();
     const std::vector<SonosDevice>& getDevices() const { return _devices; }
     
     void forceRefresh();
@@ -22,7 +26,24 @@ private:
     Sonos& _sonos;
     DeviceCache& _cache;
     std::vector<SonosDevice> _devices;
+    std::map<String, size_t> _deviceIndex;  // uuid -> position in _devices
     DiscoveryCallback _discoveryCallback = nullptr;
     unsigned long _lastDiscoveryTime;
-    const unsigned long DISCOVERY_INTERVAL = 300000; // 5 minutes
+    bool _hasScanned = false;
+    bool _cacheDirty = false;
+    bool _cacheValidated = false;
+    // Presence and scans report speakers one at a time; redraw the list at most this often
+    bool _listChanged = false;
+    unsigned long _lastListPublishMs = 0;
+    uint16_t _listPublishes = 0;
+    const unsigned long LIST_PUBLISH_INTERVAL = 250;
+    // NOTIFYs keep the list current, so M-SEARCH is only a rare fallback while presence is active
+    const unsigned long DISCOVERY_INTERVAL = 1800000; // 30 minutes
+    const unsigned long DISCOVERY_INTERVAL_NO_PRESENCE = 300000; // 5 minutes
+
+    void startDiscovery(const char* reason);
+    void validateCache();
+    int findDevice(const SonosDevice& device) const;
+    void rebuildIndex();
+    void publishListChanges(bool force);
 };
@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+#include <Client.h>
+
+// Pull-style reader for an HTTP response body already past its headers. Undoes chunked
+// transfer encoding and stops at Content-Length, buffering socket reads in a small ring.
+class HttpBodyReader {
+public:
+    HttpBodyReader(Client& client, int contentLength, bool chunked, unsigned long timeoutMs = 5000);
+
+    // Copies up to len body bytes into dest, or skips them when dest is null. Short only at the end or on error.
+    size_t read(uint8_t* dest, size_t len);
+    // Skips whatever body is left, up to maxBytes; true when the body ended cleanly and the connection can be reused
+    bool finish(size_t maxBytes = 16 * 1024);
+    size_t bytesRead() const { return _bytesRead; }
+    bool failed() const { return _failed; }
+
+private:
+    static const size_t RING_SIZE = 2048;
+
+    Client& _client;
+    int _contentLength;  // -1 when unknown
+    bool _chunked;
+    unsigned long _timeoutMs;
+    uint8_t _ring[RING_SIZE];
+    size_t _head = 0;  // Next byte to consume
+    size_t _count = 0;
+    size_t _bytesRead = 0;
+    size_t _chunkLeft = 0;
+    bool _firstChunk = true;
+    bool _ended = false;
+    bool _failed = false;
+
+    bool fill();
+    bool readRawByte(uint8_t& byte);
+    size_t readRaw(uint8_t* dest, size_t len);
+    bool readChunkHeader();
+    bool skipTrailers();
+};
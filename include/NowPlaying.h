@@ -1,15 +1,27 @@
 #pragma once
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
+#include <vector>
 
 class NowPlaying {
 public:
     void drawStatic();
     void drawStatusBar(const char* statusText);
     void drawAlbumArt();
-    void drawAlbumArt(const char* url);
+    void drawAlbumArt(const char* url);  // Immediate from PSRAM; otherwise queued on the art worker
+    bool update();  // Blits finished art from the worker; true when the requested art was drawn
     void drawTrackInfo(const char* song, const char* artist, const char* album);
     void drawProgressBar(int position, int duration);
     void drawVolume(int volume);
     void drawSpeakerInfo(const char* name);
+
+    // Decodes the next track's art off-screen and lays out its text, so the track change is a swap
+    void stageTrack(const char* song, const char* artist, const char* album, const char* artUrl);
+    bool isStaged(const char* song, const char* artUrl) const;
+    bool showStagedTrack(const char* song, const char* artist, const char* album, const char* artUrl);
+
+    // Point-sampled copy of the last decoded art, kept for the warm-start snapshot
+    static const int THUMB_SIZE = 40;
+    bool getArtThumbnail(std::vector<uint16_t>& pixels) const;
+    void drawArtThumbnail(const std::vector<uint16_t>& pixels);
 };
@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+
+// Pixel-format kernels for the art pipeline. Each has a portable scalar version and a SWAR
+// version working on 32-bit words; both give bit-identical results. PIXEL_KERNELS_SWAR picks
+// the one the pipeline calls.
+#ifndef PIXEL_KERNELS_SWAR
+#define PIXEL_KERNELS_SWAR 1
+#endif
+
+// Packed 8-bit R, G, B triplets to RGB565, truncating like the rest of the pipeline
+void packRgb565Scalar(const uint8_t* rgb, uint16_t* out, size_t count);
+void packRgb565Swar(const uint8_t* rgb, uint16_t* out, size_t count);
+
+// 2x2 box average of two RGB565 rows into one row of outCount pixels, rounded to nearest
+void halveRgb565Scalar(const uint16_t* row0, const uint16_t* row1, uint16_t* out, size_t outCount);
+void halveRgb565Swar(const uint16_t* row0, const uint16_t* row1, uint16_t* out, size_t outCount);
+
+inline void packRgb565(const uint8_t* rgb, uint16_t* out, size_t count) {
+#if PIXEL_KERNELS_SWAR
+    packRgb565Swar(rgb, out, count);
+#else
+    packRgb565Scalar(rgb, out, count);
+#endif
+}
+
+inline void halveRgb565(const uint16_t* row0, const uint16_t* row1, uint16_t* out, size_t outCount) {
+#if PIXEL_KERNELS_SWAR
+    halveRgb565Swar(row0, row1, out, outCount);
+#else
+    halveRgb565Scalar(row0, row1, out, outCount);
+#endif
+}
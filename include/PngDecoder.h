@@ -0,0 +1,60 @@
+#pragma once
+#include <Arduino.h>
+#include <functional>
+
+struct tinfl_decompressor_tag;
+
+// Streaming PNG decoder. Chunks are parsed as they are read, IDAT is inflated by the ROM's miniz
+// through a 32 KB window, and each unfiltered scanline comes out as RGB565, so memory is bounded
+// by the image width rather than its size. Non-interlaced images only; alpha is composited onto black.
+class PngDecoder {
+public:
+    using ReadFn = std::function<size_t(uint8_t* dest, size_t len)>;  // Short only at the end of the stream
+    using HeaderFn = std::function<bool(uint16_t width, uint16_t height)>;
+    using RowFn = std::function<void(uint16_t row, const uint16_t* pixels)>;
+
+    static bool isPng(const uint8_t* data, size_t len);  // Checks the 8-byte signature
+
+    explicit PngDecoder(ReadFn read) : _read(read) {}
+    ~PngDecoder();
+
+    // Reads from the signature on; false with error() set when the image is damaged or unsupported
+    bool decode(const HeaderFn& onHeader, const RowFn& onRow);
+    const char* error() const { return _error; }
+
+private:
+    static const uint16_t MAX_DIMENSION = 4096;
+    static const size_t INPUT_BYTES = 1024;
+
+    ReadFn _read;
+    const char* _error = nullptr;
+
+    uint16_t _width = 0, _height = 0;
+    uint8_t _bitDepth = 0, _colorType = 0;
+    uint8_t _bytesPerPixel = 1;  // Filter distance; at least one byte
+    size_t _rowBytes = 0;        // Without the filter-type byte
+    uint8_t _palette[256 * 3] = {};
+    uint8_t _paletteAlpha[256];
+
+    tinfl_decompressor_tag* _inflator = nullptr;
+    uint8_t* _window = nullptr;
+    size_t _windowPos = 0;
+    uint8_t* _input = nullptr;
+    uint8_t* _row = nullptr;
+    uint8_t* _prior = nullptr;
+    uint16_t* _pixels = nullptr;
+    size_t _rowFill = 0;
+    uint16_t _rowIndex = 0;
+    bool _inflateDone = false;
+
+    bool fail(const char* error);
+    bool readExact(uint8_t* dest, size_t len);
+    bool skip(size_t len);
+    bool readHeader(uint32_t length, const HeaderFn& onHeader);
+    bool inflateChunk(uint32_t length, const RowFn& onRow);
+    bool consume(const uint8_t* data, size_t len, const RowFn& onRow);
+    bool unfilterRow();
+    void convertRow();
+    uint8_t sample(const uint8_t* row, uint16_t index) const;
+    void release();
+};
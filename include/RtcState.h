@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+#include "SonosController.h"
+#include "SonosEventManager.h"
+
+// Runtime state worth keeping across deep sleep, so a wake goes straight back to Now Playing
+struct RuntimeState {
+    String deviceUuid;
+    String deviceName;
+    String deviceIP;
+    String coordinatorUuid;
+    String coordinatorIP;
+    String localIP;  // Our address when the SIDs were taken; their callbacks point at it
+    TrackData track;  // Everything but the art URL; art is refetched, normally from the art cache
+    std::vector<SonosEventManager::SubscriptionState> subscriptions;
+};
+
+// Fixed-size image of RuntimeState that lives in RTC slow memory
+struct RtcSnapshot {
+    static const uint8_t MAX_SUBSCRIPTIONS = 4;
+
+    struct Subscription {
+        char ip[16];
+        char service[20];
+        char sid[48];
+        int64_t expiresAt;  // Wall-clock seconds; the RTC keeps counting through deep sleep
+    };
+
+    uint32_t magic;
+    uint16_t version;
+    uint8_t subscriptionCount;
+    uint8_t reserved;
+    char deviceUuid[40];
+    char deviceName[48];
+    char deviceIP[16];
+    char coordinatorUuid[40];
+    char coordinatorIP[16];
+    char localIP[16];
+    char title[64];
+    char artist[48];
+    char album[48];
+    char playbackState[20];
+    int32_t position;
+    int32_t duration;
+    int32_t volume;
+    int64_t savedAt;
+    Subscription subscriptions[MAX_SUBSCRIPTIONS];
+    uint32_t crc;  // CRC32 of everything above
+};
+
+class RtcState {
+public:
+    // Pure conversions, independent of RTC memory and the clock
+    static void pack(const RuntimeState& state, int64_t now, RtcSnapshot& snapshot);
+    // Drops subscriptions that have expired (or are about to) by `now`. False if the snapshot is invalid.
+    static bool unpack(const RtcSnapshot& snapshot, int64_t now, RuntimeState& state);
+
+    static void save(const RuntimeState& state);
+    // Only succeeds after a wake from deep sleep with a valid snapshot
+    static bool restore(RuntimeState& state);
+    static void clear();
+
+private:
+    static const uint32_t EXPIRY_MARGIN_SECONDS = 30;
+};
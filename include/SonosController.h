@@ -21,6 +21,8 @@ public:
     bool refreshPosition(const String& ip, bool refreshDuration = true);
     void tick();
     const TrackData& getTrackData() const { return _currentTrack; }
+    void setTrackData(const TrackData& data) { _currentTrack = data; }  // Seeds the screen from a warm-start snapshot
+    const TrackData& getNextTrack() const { return _nextTrack; }  // From NextTrackMetaData; empty title when unknown
 
     void play(const String& ip);
     void pause(const String& ip);
@@ -36,6 +38,7 @@ public:
 private:
     Sonos& _sonos;
     TrackData _currentTrack;
+    TrackData _nextTrack;
     unsigned long _lastTickMs = 0;
     unsigned long _positionRemainderMs = 0;
 };
@@ -11,6 +11,14 @@ struct SonosEvent {
 
 class SonosEventManager {
 public:
+    // A live subscription as carried across deep sleep
+    struct SubscriptionState {
+        String ip;
+        String service;
+        String sid;
+        uint32_t secondsLeft;
+    };
+
     typedef std::function<void(const String& ip, const String& service, const String& lastChange)> EventCallback;
 
     SonosEventManager(int port = 8080);
@@ -21,6 +29,12 @@ public:
     // Subscribe to a service (e.g., "AVTransport", "RenderingControl")
     bool subscribe(const String& deviceIP, const String& service);
     void unsubscribe(const String& deviceIP, const String& service);
+    // Re-subscribes everything held against oldIP at the speaker's new address
+    void updateDeviceAddress(const String& oldIP, const String& newIP);
+
+    std::vector<SubscriptionState> getSubscriptions() const;
+    // Adopts a SID taken before sleep; it is renewed on the normal schedule instead of resubscribed
+    void restoreSubscription(const SubscriptionState& state);
     
     void setEventCallback(EventCallback callback) { _eventCallback = callback; }
 
@@ -38,6 +52,9 @@ private:
     std::vector<Subscription> _subscriptions;
     
     EventCallback _eventCallback = nullptr;
+
+    static const unsigned long SUBSCRIPTION_SECONDS = 300;
+    static const unsigned long RENEW_AFTER_MS = 270000;  // 30 s before the subscription lapses
     
     void handleClient();
     bool sendSubscribeRequest(Subscription& sub, bool isRenewal = false);
@@ -1,7 +1,20 @@
 #pragma once
 #include <Arduino.h>
 #include <Adafruit_GFX.h>
+#include <vector>
+
+// One line of text placed by layoutCenteredWrapped, ready to print
+struct TextLine {
+    String text;
+    int16_t x;
+    int16_t y;
+    uint8_t textSize;
+    uint16_t color;
+};
 
 extern int16_t centerX(const char* text, uint8_t textSize);
+extern int16_t layoutCenteredWrapped(const char* text, int16_t y, uint16_t w, uint8_t textSize, uint16_t color,
+                                     std::vector<TextLine>& lines);
+extern void printLines(Adafruit_GFX& gfx, const std::vector<TextLine>& lines);
 extern int16_t printCenteredWrapped(Adafruit_GFX& gfx, const char* text, int16_t y, uint16_t w, uint8_t textSize);
 
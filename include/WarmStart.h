@@ -0,0 +1,31 @@
+#pragma once
+#include <Arduino.h>
+#include <vector>
+#include "SonosController.h"
+
+// What the Now Playing screen showed last, so the next boot can draw it before Wi-Fi is up
+struct WarmStartSnapshot {
+    String deviceUuid;
+    String deviceName;
+    String deviceIP;
+    TrackData track;
+    std::vector<uint16_t> thumbnail;  // NowPlaying::THUMB_SIZE squared RGB565 pixels; empty when there was no art
+};
+
+class WarmStart {
+public:
+    bool load(WarmStartSnapshot& snapshot);
+    bool save(const WarmStartSnapshot& snapshot);
+    void clear();
+
+    // Flash writes are rate limited; callers mark changes and save when shouldSave() says so
+    void markDirty() { _dirty = true; }
+    bool shouldSave() const { return _dirty && (_lastSaveMs == 0 || millis() - _lastSaveMs >= MIN_SAVE_INTERVAL_MS); }
+
+private:
+    static const char* SNAPSHOT_FILE;
+    static const char* TEMP_FILE;
+    static const unsigned long MIN_SAVE_INTERVAL_MS = 15000;
+    bool _dirty = false;
+    unsigned long _lastSaveMs = 0;
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <Arduino.h>
+
+// The access point of the last successful connection, for a directed reconnect
+struct WiFiConnectionInfo {
+    uint8_t bssid[6];
+    int32_t channel = 0;
+};
+
+class WiFiCache {
+public:
+    bool load(WiFiConnectionInfo& info);
+    bool save(const WiFiConnectionInfo& info);  // Skips the flash write when nothing changed
+    void clear();
+
+private:
+    static const char* CACHE_FILE;
+    uint32_t _lastCrc = 0;
+    bool _hasLastCrc = false;
+};
@@ -1,5 +1,22 @@
 #include "Sonos.h"
 #include "SonosXmlParser.h"
+#include "SonosSsdpParser.h"
+#include "SonosParallelHttp.h"
+
+namespace {
+
+void addZoneMember(std::vector<SonosZoneMember>& members, const SonosXmlParser::ZoneGroupStateParser::Member& member) {
+    SonosZoneMember zoneMember;
+    zoneMember.uuid = member.uuid;
+    SonosSsdpParser::HeaderView location;
+    location.data = member.location.c_str();
+    location.len = member.location.length();
+    zoneMember.ip = SonosSsdpParser::hostFromLocation(location).toString();
+    zoneMember.coordinatorUuid = member.coordinator;
+    members.push_back(zoneMember);
+}
+
+}  // namespace
 
 // Static constants
 const char* Sonos::SSDP_MULTICAST_IP = "239.255.255.250";
@@ -9,8 +26,8 @@ const char* Sonos::SSDP_SEARCH_REQUEST =
     "M-SEARCH * HTTP/1.1\r\n"
     "HOST: 239.255.255.250:1900\r\n"
     "MAN: \"ssdp:discover\"\r\n"
-    "MX: 1\r\n"
-    "ST: urn:schemas-upnp-org:device:ZonePlayer:1\r\n"
+    "MX: %u\r\n"
+    "ST: %s\r\n"
     "USER-AGENT: ESP32/1.0 UPnP/1.0 Sonos/1.0\r\n\r\n";
 
 const char* Sonos::SOAP_ENVELOPE_TEMPLATE =
@@ -61,6 +78,26 @@ const char* Sonos::GET_TRANSPORT_INFO_TEMPLATE =
     "<u:GetTransportInfo xmlns:u=\"urn:schemas-upnp-org:service:AVTransport:1\">"
     "<InstanceID>0</InstanceID></u:GetTransportInfo>";
 
+const char* Sonos::GET_ZONE_GROUP_STATE_TEMPLATE =
+    "<u:GetZoneGroupState xmlns:u=\"urn:schemas-upnp-org:service:ZoneGroupTopology:1\">"
+    "</u:GetZoneGroupState>";
+
+const char* Sonos::GROUP_VOLUME_SET_TEMPLATE =
+    "<u:SetGroupVolume xmlns:u=\"urn:schemas-upnp-org:service:GroupRenderingControl:1\">"
+    "<InstanceID>0</InstanceID><DesiredVolume>%d</DesiredVolume></u:SetGroupVolume>";
+
+const char* Sonos::GROUP_VOLUME_GET_TEMPLATE =
+    "<u:GetGroupVolume xmlns:u=\"urn:schemas-upnp-org:service:GroupRenderingControl:1\">"
+    "<InstanceID>0</InstanceID></u:GetGroupVolume>";
+
+const char* Sonos::GROUP_VOLUME_ADJUST_TEMPLATE =
+    "<u:SetRelativeGroupVolume xmlns:u=\"urn:schemas-upnp-org:service:GroupRenderingControl:1\">"
+    "<InstanceID>0</InstanceID><Adjustment>%d</Adjustment></u:SetRelativeGroupVolume>";
+
+const char* Sonos::GROUP_MUTE_SET_TEMPLATE =
+    "<u:SetGroupMute xmlns:u=\"urn:schemas-upnp-org:service:GroupRenderingControl:1\">"
+    "<InstanceID>0</InstanceID><DesiredMute>%d</DesiredMute></u:SetGroupMute>";
+
 Sonos::Sonos() {}
 Sonos::Sonos(const SonosConfig& config) : _config(config) {}
 
@@ -77,6 +114,15 @@ SonosResult Sonos::begin() {
         return SonosResult::ERROR_NETWORK;
     }
 
+    if (_config.enablePresenceListener) {
+        IPAddress multicastIP;
+        multicastIP.fromString(SSDP_MULTICAST_IP);
+        _presenceActive = _notifyUdp.beginMulticast(multicastIP, SSDP_PORT);
+        if (!_presenceActive) {
+            logMessage(LogLevel::WARN, "discovery", "Failed to join SSDP multicast group; presence tracking disabled");
+        }
+    }
+
     _http.setTimeout(_config.soapTimeoutMs);
     _http.setReuse(true);
     _initialized = true;
@@ -87,6 +133,11 @@ SonosResult Sonos::begin() {
 void Sonos::end() {
     if (!_initialized) return;
     _udp.stop();
+    if (_presenceActive) _notifyUdp.stop();
+    _presenceActive = false;
+    _presenceQueue.clear();
+    _presenceBatch.http.stop();
+    _presenceBatch.items.clear();
     _http.end();
     _devices.clear();
     _initialized = false;
@@ -95,98 +146,705 @@ void Sonos::end() {
 
 // Device discovery implementation
 SonosResult Sonos::discoverDevices() {
+    std::vector<String> targets;
+    targets.push_back(SONOS_DEVICE_TYPE);
+
+    // Every cached/known speaker answering lets the scan end before the MX window closes
+    std::vector<String> expected;
+    for (const auto& device : _devices) {
+        if (device.uuid.length() > 0) expected.push_back(device.uuid);
+    }
+    return startDiscovery(targets, expected, false);
+}
+
+SonosResult Sonos::discoverDevices(const std::vector<String>& uuids) {
+    if (uuids.empty()) return SonosResult::ERROR_INVALID_PARAM;
+    return startDiscovery(uuids, uuids, true);
+}
+
+SonosResult Sonos::startDiscovery(const std::vector<String>& searchTargets, const std::vector<String>& expectedUuids, bool targeted) {
     if (!_initialized) {
         return SonosResult::ERROR_INVALID_DEVICE;
     }
 
-    logMessage(LogLevel::INFO, "discovery", "Starting device discovery");
+    logMessage(LogLevel::INFO, "discovery", targeted ? "Starting targeted discovery for " + String(searchTargets.size()) + " devices"
+                                                     : String("Starting device discovery"));
 
-    // Send SSDP multicast request
+    _searchTargets = searchTargets;
+    if (!sendSearches()) {
+        logMessage(LogLevel::ERROR, "discovery", "Failed to send SSDP request");
+        return SonosResult::ERROR_NETWORK;
+    }
+
+    _isDiscovering = true;
+    _targetedDiscovery = targeted;
+    _discoveryStartTime = millis();
+    _lastSearchMs = _discoveryStartTime;
+    _lastNewResponseMs = _discoveryStartTime;
+    _newDevices.clear();
+    _newDeviceIndex.clear();
+    _pendingDescriptions.clear();
+    _discoveryStats = SonosDiscoveryStats();
+    _discoveryStats.searchesSent = 1;
+    _discoveryStats.minFreeHeap = ESP.getFreeHeap();
+    _expectedUuids = expectedUuids;
+    _expectedRemaining = _expectedUuids.size();
+
+    return SonosResult::SUCCESS;
+}
+
+bool Sonos::sendSearches() {
     IPAddress multicastIP;
     multicastIP.fromString(SSDP_MULTICAST_IP);
 
-    _udp.beginPacket(multicastIP, SSDP_PORT);
-    _udp.write((const uint8_t*)SSDP_SEARCH_REQUEST, strlen(SSDP_SEARCH_REQUEST));
-    bool sent = _udp.endPacket();
+    bool allSent = true;
+    char request[256];
+    for (const auto& target : _searchTargets) {
+        snprintf(request, sizeof(request), SSDP_SEARCH_REQUEST, (unsigned)_config.searchMx, target.c_str());
+        _udp.beginPacket(multicastIP, SSDP_PORT);
+        _udp.write((const uint8_t*)request, strlen(request));
+        allSent = _udp.endPacket() && allSent;
+    }
+    return allSent;
+}
 
-    if (!sent) {
-        logMessage(LogLevel::ERROR, "discovery", "Failed to send SSDP request");
-        return SonosResult::ERROR_NETWORK;
+bool Sonos::isExpectedUuid(const String& uuid) const {
+    for (const auto& expected : _expectedUuids) {
+        if (expected == uuid) return true;
     }
+    return false;
+}
+
+SonosResult Sonos::sweepSubnet() {
+    if (!_initialized) return SonosResult::ERROR_INVALID_DEVICE;
+    if (_isDiscovering) return SonosResult::ERROR_INVALID_PARAM;
 
     _isDiscovering = true;
+    _targetedDiscovery = false;
     _discoveryStartTime = millis();
     _newDevices.clear();
-
+    _newDeviceIndex.clear();
+    _pendingDescriptions.clear();
+    _discoveryStats = SonosDiscoveryStats();
+    _discoveryStats.minFreeHeap = ESP.getFreeHeap();
+    _expectedUuids.clear();
+    _expectedRemaining = 0;
+
+    if (!startSubnetSweep()) {
+        _isDiscovering = false;
+        return SonosResult::ERROR_INVALID_PARAM;
+    }
     return SonosResult::SUCCESS;
 }
 
 void Sonos::updateDiscovery() {
     if (!_isDiscovering) return;
 
-    if (millis() - _discoveryStartTime > _config.discoveryTimeoutMs) {
-        _isDiscovering = false;
+    if (_sweepActive) {
+        updateSubnetSweep();
+        return;
+    }
+
+    unsigned long now = millis();
+    if (now - _discoveryStartTime > _config.discoveryTimeoutMs) {
+        completeMulticastPhase(false);
+        return;
+    }
+
+    // Staggered burst: each resend doubles the gap so a lost datagram rarely costs a speaker
+    if (_discoveryStats.searchesSent < _config.searchBurstCount) {
+        unsigned long gap = (unsigned long)_config.searchBurstSpacingMs << (_discoveryStats.searchesSent - 1);
+        if (now - _lastSearchMs >= gap) {
+            sendSearches();
+            _discoveryStats.searchesSent++;
+            _lastSearchMs = now;
+        }
+    }
+
+    // Drain before any description fetch: lwIP holds only a handful of datagrams per socket,
+    // and with a burst of searches out every speaker answers several times
+    const int kDrainLimit = 64;
+    int drained = 0;
+    for (; drained < kDrainLimit; drained++) {
+        int packetSize = _udp.parsePacket();
+        if (packetSize <= 0) break;
+        _discoveryStats.packets++;
+        if (packetSize >= (int)sizeof(_packetBuffer)) _discoveryStats.packetsTruncated++;
+        int len = _udp.read(_packetBuffer, sizeof(_packetBuffer) - 1);
+        if (len > 0) {
+            _packetBuffer[len] = '\0';
+            handleDiscoveryPacket(len);
+        }
+    }
+    if (drained == kDrainLimit) _discoveryStats.drainLimitHits++;
+    if (!_pendingDescriptions.empty()) fetchPendingDescriptions();
+
+    uint32_t freeHeap = ESP.getFreeHeap();
+    if (freeHeap < _discoveryStats.minFreeHeap) _discoveryStats.minFreeHeap = freeHeap;
+
+    now = millis();
+    bool burstDone = _discoveryStats.searchesSent >= _config.searchBurstCount;
+    unsigned long mxMs = (unsigned long)_config.searchMx * 1000UL;
+    unsigned long quietMs = mxMs / 2 + 250;
+    bool quiet = now - _lastNewResponseMs >= quietMs;
+    bool allExpectedAnswered = !_expectedUuids.empty() && _expectedRemaining == 0;
+    bool mxWindowClosed = now - _lastSearchMs >= mxMs + 250;
+    if (burstDone && quiet && (allExpectedAnswered || mxWindowClosed)) {
+        completeMulticastPhase(true);
+    }
+}
+
+void Sonos::completeMulticastPhase(bool endedEarly) {
+    if (!_pendingDescriptions.empty()) fetchPendingDescriptions();
+    if (_config.enableSubnetSweep && !_targetedDiscovery && _newDevices.empty()) {
+        logMessage(LogLevel::INFO, "discovery", "No SSDP responses; falling back to subnet sweep");
+        if (startSubnetSweep()) return;
+    }
+    finishDiscovery(endedEarly);
+}
+
+bool Sonos::startSubnetSweep() {
+    uint32_t network = 0;
+    uint8_t prefix = 24;
+    IPAddress local = WiFi.localIP();
+    uint32_t localHost = ((uint32_t)local[0] << 24) | ((uint32_t)local[1] << 16) | ((uint32_t)local[2] << 8) | local[3];
+
+    if (_config.sweepCidr.length() > 0) {
+        if (!parseCidr(_config.sweepCidr, network, prefix)) {
+            logMessage(LogLevel::ERROR, "discovery", "Invalid sweep CIDR '" + _config.sweepCidr + "'");
+            return false;
+        }
+    } else {
+        network = localHost & 0xFFFFFF00UL;
+    }
+
+    // Cap the sweep at a /20 (4094 hosts); anything larger takes minutes at any sane concurrency
+    if (prefix < 20 || prefix > 30) {
+        logMessage(LogLevel::ERROR, "discovery", "Sweep prefix /" + String(prefix) + " outside /20../30");
+        return false;
+    }
+
+    uint32_t mask = 0xFFFFFFFFUL << (32 - prefix);
+    network &= mask;
+    _sweepNextHost = network + 1;
+    _sweepLastHost = (network | ~mask) - 1;
+    _sweepSkipHost = localHost;
+    _sweepStartMs = millis();
+    _sweepActive = true;
+
+    logMessage(LogLevel::INFO, "discovery", "Sweeping " + String(_sweepLastHost - _sweepNextHost + 1) + " hosts with concurrency " +
+               String(_config.sweepConcurrency) + " and " + String(_config.sweepConnectTimeoutMs) + " ms timeout");
+    return true;
+}
+
+void Sonos::updateSubnetSweep() {
+    // One batch per call keeps each loop() pass bounded by sweepConnectTimeoutMs
+    std::vector<SonosParallelHttp::Request> probes;
+    size_t batch = _config.sweepConcurrency > 0 ? _config.sweepConcurrency : 1;
+    while (probes.size() < batch && _sweepNextHost <= _sweepLastHost) {
+        uint32_t host = _sweepNextHost++;
+        if (host == _sweepSkipHost) continue;
+        SonosParallelHttp::Request probe;
+        probe.ip = IPAddress((host >> 24) & 0xFF, (host >> 16) & 0xFF, (host >> 8) & 0xFF, host & 0xFF);
+        probes.push_back(probe);
+    }
+
+    if (!probes.empty()) {
+        SonosParallelHttp::run(probes, _config.sweepConnectTimeoutMs, _config.sweepConnectTimeoutMs + 50, batch);
+        _discoveryStats.hostsProbed += probes.size();
+
+        for (const auto& probe : probes) {
+            if (!probe.connected) continue;
+            _discoveryStats.sweepHits++;
+
+            SonosDevice device;
+            device.ip = probe.ip.toString();
+            device.lastSeenMs = millis();
+            device.reachability = SonosReachability::REACHABLE;
+            queueDescriptionFetch(device, 1400, "/xml/device_description.xml");
+        }
+        if (!_pendingDescriptions.empty()) fetchPendingDescriptions();
+    }
+
+    if (_sweepNextHost > _sweepLastHost) {
+        _sweepActive = false;
+        _discoveryStats.sweepMs = millis() - _sweepStartMs;
+        logMessage(LogLevel::INFO, "discovery", "Subnet sweep probed " + String(_discoveryStats.hostsProbed) + " hosts in " +
+                   String(_discoveryStats.sweepMs) + " ms at concurrency " + String(batch) + " (" +
+                   String(_discoveryStats.sweepHits) + " hits, " + String(_newDevices.size()) + " Sonos devices)");
+        finishDiscovery(true);
+    }
+}
+
+bool Sonos::parseCidr(const String& cidr, uint32_t& network, uint8_t& prefix) {
+    int slash = cidr.indexOf('/');
+    IPAddress base;
+    if (!base.fromString(slash >= 0 ? cidr.substring(0, slash) : cidr)) return false;
+
+    int parsedPrefix = 24;
+    if (slash >= 0) {
+        String parseError;
+        if (!SonosXmlParser::parseInt(cidr.substring(slash + 1), parsedPrefix, parseError)) return false;
+        if (parsedPrefix < 0 || parsedPrefix > 32) return false;
+    }
+
+    network = ((uint32_t)base[0] << 24) | ((uint32_t)base[1] << 16) | ((uint32_t)base[2] << 8) | base[3];
+    prefix = static_cast<uint8_t>(parsedPrefix);
+    return true;
+}
+
+void Sonos::finishDiscovery(bool endedEarly) {
+    unsigned long now = millis();
+    _isDiscovering = false;
+
+    if (_targetedDiscovery) {
+        for (const auto& found : _newDevices) upsertDevice(_devices, found);
+    } else {
+        std::vector<SonosDevice> moved;
+        for (const auto& previous : _devices) {
+            auto indexed = _newDeviceIndex.find(previous.uuid);
+            bool seenInScan = indexed != _newDeviceIndex.end();
+            if (seenInScan && _newDevices[indexed->second].ip != previous.ip) moved.push_back(previous);
+            // Devices that missed this scan but still hold an unexpired presence lease stay listed
+            if (!seenInScan && previous.maxAgeMs > 0 && !presenceExpired(previous, now)) _newDevices.push_back(previous);
+        }
         _devices = _newDevices;
-        logMessage(LogLevel::INFO, "discovery", "Discovery complete. Found " + String(_devices.size()) + " devices");
+        for (const auto& previous : moved) {
+            SonosDevice* updated = getDeviceByUuid(previous.uuid);
+            if (updated != nullptr) reportAddressChange(previous, *updated);
+        }
+    }
+    // Everything found is in _devices now; drop the scan list so its index cannot go stale
+    _newDevices.clear();
+    _newDeviceIndex.clear();
+
+    _discoveryStats.durationMs = now - _discoveryStartTime;
+    _discoveryStats.devicesFound = _devices.size();
+    _discoveryStats.endedEarly = endedEarly;
+    logMessage(LogLevel::INFO, "discovery", String(_targetedDiscovery ? "Targeted discovery" : "Discovery") + " complete in " + String(_discoveryStats.durationMs) + " ms" +
+               (endedEarly ? " (early)" : " (timeout)") + ". Found " + String(_discoveryStats.devicesFound) + " devices (" +
+               String(_discoveryStats.searchesSent) + " searches, " + String(_discoveryStats.responses) +
+               " responses, descriptions fetched=" + String(_discoveryStats.descriptionsFetched) +
+               " skipped=" + String(_discoveryStats.descriptionsSkipped) + ", description bytes read=" +
+               String(_discoveryStats.descriptionBytesRead) + " of " + String(_discoveryStats.descriptionBytesTotal) + ", expected missing=" + String(_expectedRemaining) + ")");
+    logMessage(LogLevel::DEBUG, "discovery", "Scan load: packets=" + String(_discoveryStats.packets) + " truncated=" +
+               String(_discoveryStats.packetsTruncated) + " drain limit hits=" + String(_discoveryStats.drainLimitHits) +
+               " min free heap=" + String(_discoveryStats.minFreeHeap));
+}
+
+void Sonos::handleDiscoveryPacket(size_t len) {
+    SonosSsdpParser::SsdpPacket packet;
+    if (!SonosSsdpParser::parsePacket(_packetBuffer, len, packet)) return;
+
+    // Targeted searches use ST: uuid:RINCON_..., so those answers carry no ZonePlayer type
+    String uuid = SonosSsdpParser::uuidFromUsn(packet.usn).toString();
+    bool isZonePlayer = packet.st.contains("ZonePlayer") || packet.usn.contains("ZonePlayer");
+    if (!isZonePlayer && !(_targetedDiscovery && isExpectedUuid(uuid))) return;
+    _discoveryStats.responses++;
+
+    String deviceIP = SonosSsdpParser::hostFromLocation(packet.location).toString();
+    if (!isValidIP(deviceIP)) return;
+
+    // A known UUID whose boot and config IDs are unchanged has the same description; only the IP may move.
+    const SonosDevice* known = uuid.length() > 0 ? findKnownDevice(uuid) : nullptr;
+    if (known != nullptr) {
+        bool bootChanged = packet.bootId >= 0 && known->bootId >= 0 && packet.bootId != known->bootId;
+        bool configChanged = packet.configId >= 0 && known->configId >= 0 && packet.configId != known->configId;
+        if (!bootChanged && !configChanged) {
+            SonosDevice device = *known;
+            device.ip = deviceIP;
+            applyPresence(device, packet);
+            _discoveryStats.descriptionsSkipped++;
+            addDiscoveredDevice(device);
+            return;
+        }
+        logMessage(LogLevel::DEBUG, "discovery", "Boot/config ID changed for " + uuid + "; refetching description");
+    }
+
+    // Each speaker answers every burst with several STs; one queued fetch per device is enough
+    for (const auto& pending : _pendingDescriptions) {
+        if (pending.device.ip == deviceIP) return;
+    }
+
+    SonosDevice device;
+    device.uuid = uuid;
+    device.ip = deviceIP;
+    applyPresence(device, packet);
+    queueDescriptionFetch(device, SonosSsdpParser::portFromLocation(packet.location),
+                          SonosSsdpParser::pathFromLocation(packet.location).toString());
+}
+
+void Sonos::queueDescriptionFetch(const SonosDevice& device, uint16_t port, const String& path) {
+    PendingDescription pending;
+    pending.device = device;
+    pending.port = port;
+    pending.path = path.length() > 0 ? path : String("/xml/device_description.xml");
+    _pendingDescriptions.push_back(pending);
+}
+
+void Sonos::fetchPendingDescriptions() {
+    DescriptionBatch batch;
+    batch.items.swap(_pendingDescriptions);
+
+    unsigned long start = millis();
+    startDescriptionBatch(batch, _config.probeConcurrency);
+    while (!batch.http.poll(10)) {
+    }
+    unsigned long elapsed = millis() - start;
+
+    size_t parsed = 0;
+    for (size_t i = 0; i < batch.items.size(); i++) {
+        _discoveryStats.descriptionBytesRead += batch.bytesRead[i];
+        if (batch.requests[i].contentLength > 0) _discoveryStats.descriptionBytesTotal += batch.requests[i].contentLength;
+        SonosDevice device;
+        if (!takeDescription(batch, i, device)) continue;
+        _discoveryStats.descriptionsFetched++;
+        parsed++;
+        addDiscoveredDevice(device);
+    }
+
+    logMessage(LogLevel::DEBUG, "discovery", "Fetched " + String(parsed) + " of " + String(batch.items.size()) +
+               " descriptions in " + String(elapsed) + " ms");
+}
+
+void Sonos::startDescriptionBatch(DescriptionBatch& batch, size_t maxConcurrent) {
+    static const char* const kDescriptionTags[] = {"roomName", "UDN", "internalSpeakerSize"};
+
+    batch.extractors.clear();
+    batch.requests.clear();
+    batch.bytesRead.assign(batch.items.size(), 0);
+    batch.extractors.reserve(batch.items.size());
+    batch.requests.reserve(batch.items.size());
+
+    DescriptionBatch* owner = &batch;
+    for (size_t i = 0; i < batch.items.size(); i++) {
+        const PendingDescription& item = batch.items[i];
+        batch.extractors.emplace_back(kDescriptionTags, 3, "serviceList");
+        SonosParallelHttp::Request request;
+        request.ip.fromString(item.device.ip);
+        request.port = item.port;
+        // HTTP/1.0 so the body is never chunk-encoded; the extractor sees plain XML
+        request.request = "GET " + item.path + " HTTP/1.0\r\nHost: " + item.device.ip + ":" + String(item.port) + "\r\n\r\n";
+        request.onBody = [owner, i](const char* data, size_t len) {
+            SonosXmlParser::StreamingTagExtractor& extractor = owner->extractors[i];
+            extractor.feed(data, len);
+            owner->bytesRead[i] += len;
+            return !extractor.allFound() && !extractor.stopped();
+        };
+        batch.requests.push_back(request);
+    }
+    batch.http.start(batch.requests, _config.descriptionTimeoutMs, _config.descriptionTimeoutMs, maxConcurrent);
+}
+
+bool Sonos::takeDescription(DescriptionBatch& batch, size_t index, SonosDevice& device) {
+    device = batch.items[index].device;
+    const SonosParallelHttp::Request& request = batch.requests[index];
+    if (request.statusCode != HTTP_CODE_OK) {
+        logMessage(LogLevel::WARN, "discovery", "Description fetch failed. HTTP code=" + String(request.statusCode) +
+                   " for " + device.ip + batch.items[index].path);
+        return false;
+    }
+    String ssdpUuid = device.uuid;
+    if (!parseDeviceDescription(batch.extractors[index], device)) return false;
+    if (device.uuid.length() == 0) device.uuid = ssdpUuid;
+    return true;
+}
+
+size_t Sonos::validateDevices(std::vector<SonosDevice>& devices) {
+    std::vector<SonosParallelHttp::Request> requests;
+    std::vector<size_t> owners;
+    requests.reserve(devices.size());
+    owners.reserve(devices.size());
+
+    size_t failed = 0;
+    for (size_t i = 0; i < devices.size(); i++) {
+        IPAddress ip;
+        if (!ip.fromString(devices[i].ip)) {
+            devices[i].reachability = SonosReachability::STALE;
+            failed++;
+            continue;
+        }
+        SonosParallelHttp::Request request;
+        request.ip = ip;
+        request.request = SonosParallelHttp::buildGet(ip, 1400, "/xml/device_description.xml");
+        // <UDN> sits near the top of the description; the rest is not needed to confirm identity
+        request.maxResponseBytes = 2048;
+        requests.push_back(request);
+        owners.push_back(i);
+    }
+
+    unsigned long start = millis();
+    SonosParallelHttp::run(requests, _config.probeTimeoutMs, _config.probeDeadlineMs, _config.probeConcurrency);
+    unsigned long elapsed = millis() - start;
+
+    for (size_t r = 0; r < requests.size(); r++) {
+        SonosDevice& device = devices[owners[r]];
+        const SonosParallelHttp::Request& request = requests[r];
+        SonosReachability state = SonosReachability::STALE;
+        if (request.statusCode == HTTP_CODE_OK) {
+            SonosXmlParser::XmlLookupResult udn = SonosXmlParser::findTagValue(request.response, "UDN");
+            if (udn.success) {
+                state = udn.value == device.uuid ? SonosReachability::REACHABLE : SonosReachability::MOVED;
+            }
+        }
+        device.reachability = state;
+        if (state != SonosReachability::REACHABLE) {
+            failed++;
+            logMessage(LogLevel::WARN, "discovery", "Cached device " + device.name + " at " + device.ip +
+                       (state == SonosReachability::MOVED ? " now answers with a different UUID" : " did not answer"));
+        }
+        for (auto& known : _devices) {
+            if (known.uuid == device.uuid) known.reachability = state;
+        }
+    }
+
+    logMessage(LogLevel::INFO, "discovery", "Validated " + String(devices.size()) + " cached devices in " + String(elapsed) +
+               " ms (" + String(devices.size() - failed) + " reachable, " + String(failed) + " failed)");
+    return failed;
+}
+
+void Sonos::updatePresence() {
+    if (!_presenceActive) return;
+
+    // Drain a bounded number of NOTIFYs per call; each speaker announces several NTs at once
+    for (int i = 0; i < 8; i++) {
+        int packetSize = _notifyUdp.parsePacket();
+        if (packetSize <= 0) break;
+        int len = _notifyUdp.read(_packetBuffer, sizeof(_packetBuffer) - 1);
+        if (len <= 0) continue;
+        _packetBuffer[len] = '\0';
+        handleNotifyPacket(len);
+    }
+    updatePresenceFetches();
+
+    unsigned long now = millis();
+    if (now - _lastExpiryCheckMs >= 1000) {
+        _lastExpiryCheckMs = now;
+        expirePresence();
+    }
+}
+
+void Sonos::handleNotifyPacket(size_t len) {
+    SonosSsdpParser::SsdpPacket packet;
+    if (!SonosSsdpParser::parsePacket(_packetBuffer, len, packet)) return;
+    if (!packet.isNotify || !packet.nt.contains("ZonePlayer")) return;
+
+    String uuid = SonosSsdpParser::uuidFromUsn(packet.usn).toString();
+    if (uuid.length() == 0) return;
+
+    if (packet.nts.startsWith("ssdp:byebye")) {
+        for (auto it = _presenceQueue.begin(); it != _presenceQueue.end(); ++it) {
+            if (it->device.uuid == uuid) {
+                _presenceQueue.erase(it);
+                break;
+            }
+        }
+        removeDevice(uuid, "byebye");
+        return;
+    }
+    if (!packet.nts.startsWith("ssdp:alive")) return;
+
+    String deviceIP = SonosSsdpParser::hostFromLocation(packet.location).toString();
+    if (!isValidIP(deviceIP)) return;
+
+    const SonosDevice* known = findKnownDevice(uuid);
+    bool bootChanged = known && packet.bootId >= 0 && known->bootId >= 0 && packet.bootId != known->bootId;
+    bool configChanged = known && packet.configId >= 0 && known->configId >= 0 && packet.configId != known->configId;
+    if (known != nullptr && !bootChanged && !configChanged) {
+        SonosDevice device = *known;
+        device.ip = deviceIP;
+        applyPresence(device, packet);
+        publishPresence(device);
         return;
     }
 
-    int packetSize = _udp.parsePacket();
-    if (packetSize > 0) {
-        String response = _udp.readString();
-
-        if (response.indexOf("ZonePlayer") != -1) {
-            int locationStart = response.indexOf("LOCATION: ") + 10;
-            int locationEnd = response.indexOf("\r\n", locationStart);
-            if (locationStart > 9 && locationEnd > locationStart) {
-                String locationUrl = response.substring(locationStart, locationEnd);
-
-                int ipStart = locationUrl.indexOf("//") + 2;
-                int ipEnd = locationUrl.indexOf(":", ipStart);
-                String deviceIP = locationUrl.substring(ipStart, ipEnd);
-
-                if (isValidIP(deviceIP)) {
-                    _http.begin(locationUrl);
-                    int httpCode = _http.GET();
-
-                    if (httpCode == HTTP_CODE_OK) {
-                        String xmlResponse = _http.getString();
-                        SonosDevice device;
-
-                        if (parseDeviceDescription(xmlResponse, device)) {
-                            device.ip = deviceIP;
-
-                            bool deviceExists = false;
-                            for (auto& existingDevice : _newDevices) {
-                                if (existingDevice.ip == device.ip) {
-                                    existingDevice = device;
-                                    deviceExists = true;
-                                    break;
-                                }
-                            }
-
-                            if (!deviceExists) {
-                                _newDevices.push_back(device);
-                                logMessage(LogLevel::INFO, "discovery", "Discovered device: " + device.name + " at " + device.ip);
-                                if (_deviceFoundCallback) _deviceFoundCallback(device);
-                            }
-                        }
-                    }
-                    _http.end();
-                }
+    // A new or rebooted speaker needs its description; that is a round trip, so it never runs from here
+    for (const auto& pending : _presenceQueue) {
+        if (pending.device.ip == deviceIP) return;
+    }
+    if (_presenceBatch.http.active()) {
+        for (const auto& pending : _presenceBatch.items) {
+            if (pending.device.ip == deviceIP) return;
+        }
+    }
+    PendingDescription pending;
+    pending.device.uuid = uuid;
+    pending.device.ip = deviceIP;
+    applyPresence(pending.device, packet);
+    pending.port = SonosSsdpParser::portFromLocation(packet.location);
+    pending.path = SonosSsdpParser::pathFromLocation(packet.location).toString();
+    if (pending.path.length() == 0) pending.path = "/xml/device_description.xml";
+    _presenceQueue.push_back(pending);
+}
+
+void Sonos::updatePresenceFetches() {
+    if (_presenceBatch.http.active()) {
+        if (!_presenceBatch.http.poll(0)) return;
+        for (size_t i = 0; i < _presenceBatch.items.size(); i++) {
+            SonosDevice device;
+            if (takeDescription(_presenceBatch, i, device)) publishPresence(device);
+        }
+        _presenceBatch.items.clear();
+    }
+    if (_presenceQueue.empty()) return;
+
+    _presenceBatch.items.swap(_presenceQueue);
+    startDescriptionBatch(_presenceBatch, _config.presenceFetchConcurrency);
+}
+
+void Sonos::publishPresence(const SonosDevice& device) {
+    if (_isDiscovering) {
+        // Let the active scan own the callback; it publishes its list when it completes
+        upsertDevice(_devices, device);
+        addDiscoveredDevice(device);
+        return;
+    }
+
+    if (upsertDevice(_devices, device)) {
+        logMessage(LogLevel::INFO, "discovery", "Presence: " + device.name + " alive at " + device.ip);
+        if (_deviceFoundCallback) _deviceFoundCallback(device);
+    }
+}
+
+bool Sonos::upsertDevice(std::vector<SonosDevice>& devices, const SonosDevice& device) {
+    for (auto& existing : devices) {
+        bool sameDevice = device.uuid.length() > 0 ? existing.uuid == device.uuid : existing.ip == device.ip;
+        if (sameDevice) {
+            bool changed = existing.ip != device.ip || existing.name != device.name || existing.reachability != device.reachability;
+            SonosDevice previous = existing;
+            existing = device;
+            if (&devices == &_devices && previous.ip.length() > 0 && previous.ip != device.ip) {
+                reportAddressChange(previous, existing);
             }
+            return changed;
+        }
+    }
+    devices.push_back(device);
+    return true;
+}
+
+void Sonos::reportAddressChange(const SonosDevice& previous, const SonosDevice& updated) {
+    SonosDevice* device = getDeviceByUuid(updated.uuid);
+    if (device != nullptr) device->consecutiveFailures = 0;
+    logMessage(LogLevel::INFO, "discovery", updated.name + " moved from " + previous.ip + " to " + updated.ip);
+    if (_deviceMovedCallback) _deviceMovedCallback(updated, previous.ip);
+}
+
+void Sonos::recordRequestResult(const String& deviceIP, bool networkFailure) {
+    SonosDevice* device = getDeviceByIP(deviceIP);
+    if (device == nullptr) return;
+    if (!networkFailure) {
+        device->consecutiveFailures = 0;
+        return;
+    }
+
+    if (device->consecutiveFailures < 255) device->consecutiveFailures++;
+    if (device->uuid.length() == 0 || _config.resolveAfterFailures == 0 ||
+        device->consecutiveFailures % _config.resolveAfterFailures != 0) {
+        return;
+    }
+    for (const auto& pending : _pendingResolves) {
+        if (pending == device->uuid) return;
+    }
+    logMessage(LogLevel::WARN, "discovery", device->name + " unreachable at " + deviceIP + " after " +
+               String(device->consecutiveFailures) + " failures; re-resolving by UUID");
+    _pendingResolves.push_back(device->uuid);
+}
+
+SonosResult Sonos::resolvePendingDevices() {
+    if (_pendingResolves.empty()) return SonosResult::SUCCESS;
+    if (_isDiscovering) return SonosResult::ERROR_INVALID_PARAM;
+
+    std::vector<String> uuids;
+    uuids.swap(_pendingResolves);
+    return discoverDevices(uuids);
+}
+
+void Sonos::removeDevice(const String& uuid, const char* reason) {
+    auto indexed = _newDeviceIndex.find(uuid);
+    if (indexed != _newDeviceIndex.end()) {
+        size_t position = indexed->second;
+        _newDevices.erase(_newDevices.begin() + position);
+        _newDeviceIndex.erase(indexed);
+        for (auto& entry : _newDeviceIndex) {
+            if (entry.second > position) entry.second--;
         }
     }
+    for (auto it = _devices.begin(); it != _devices.end(); ++it) {
+        if (it->uuid == uuid) {
+            SonosDevice lost = *it;
+            _devices.erase(it);
+            logMessage(LogLevel::INFO, "discovery", "Presence: " + lost.name + " gone (" + reason + ")");
+            if (_deviceLostCallback) _deviceLostCallback(lost);
+            return;
+        }
+    }
+}
+
+void Sonos::expirePresence() {
+    unsigned long now = millis();
+    for (size_t i = 0; i < _devices.size();) {
+        if (presenceExpired(_devices[i], now)) {
+            removeDevice(_devices[i].uuid, "max-age expired");
+        } else {
+            i++;
+        }
+    }
+}
+
+void Sonos::applyPresence(SonosDevice& device, const SonosSsdpParser::SsdpPacket& packet) {
+    if (packet.bootId >= 0) device.bootId = packet.bootId;
+    if (packet.configId >= 0) device.configId = packet.configId;
+    device.lastSeenMs = millis();
+    device.reachability = SonosReachability::REACHABLE;
+    if (packet.maxAge > 0) device.maxAgeMs = static_cast<unsigned long>(packet.maxAge) * 1000UL;
+}
+
+bool Sonos::presenceExpired(const SonosDevice& device, unsigned long now) {
+    return device.maxAgeMs > 0 && now - device.lastSeenMs > device.maxAgeMs;
+}
+
+const SonosDevice* Sonos::findKnownDevice(const String& uuid) const {
+    auto indexed = _newDeviceIndex.find(uuid);
+    if (indexed != _newDeviceIndex.end()) return &_newDevices[indexed->second];
+    for (const auto& device : _devices) {
+        if (device.uuid == uuid) return &device;
+    }
+    return nullptr;
+}
+
+void Sonos::addDiscoveredDevice(const SonosDevice& device) {
+    if (device.uuid.length() > 0) {
+        auto indexed = _newDeviceIndex.find(device.uuid);
+        if (indexed != _newDeviceIndex.end()) {
+            _newDevices[indexed->second] = device;
+            return;
+        }
+        _newDeviceIndex[device.uuid] = _newDevices.size();
+        _newDevices.push_back(device);
+    } else {
+        size_t countBefore = _newDevices.size();
+        upsertDevice(_newDevices, device);
+        if (_newDevices.size() == countBefore) return;
+    }
+
+    _lastNewResponseMs = millis();
+    if (_expectedRemaining > 0 && isExpectedUuid(device.uuid)) _expectedRemaining--;
+
+    logMessage(LogLevel::INFO, "discovery", "Discovered device: " + device.name + " at " + device.ip);
+    if (_deviceFoundCallback) _deviceFoundCallback(device);
 }
 
-bool Sonos::parseDeviceDescription(const String& xml, SonosDevice& device) {
-    if (!getXmlValue(xml, "roomName", device.name, "device description", true)) {
+bool Sonos::parseDeviceDescription(const SonosXmlParser::StreamingTagExtractor& extractor, SonosDevice& device) {
+    if (!extractor.found(0) || extractor.value(0).length() == 0) {
+        logMessage(LogLevel::ERROR, "xml", "Lookup failed in device description: Tag <roomName> not found");
         return false;
     }
-    getXmlValue(xml, "UDN", device.uuid, "device description", false);
+    device.name = extractor.value(0);
+    device.uuid = extractor.found(1) ? extractor.value(1) : "";
 
-    String speakerSize;
-    if (getXmlValue(xml, "internalSpeakerSize", speakerSize, "device description", false)) {
+    if (extractor.found(2)) {
+        const String& speakerSize = extractor.value(2);
         int parsedSize = 0;
         String parseError;
         bool parsed = SonosXmlParser::parseInt(speakerSize, parsedSize, parseError);
@@ -199,7 +857,7 @@ bool Sonos::parseDeviceDescription(const String& xml, SonosDevice& device) {
         }
     }
 
-    return device.name.length() > 0;
+    return true;
 }
 
 bool Sonos::getXmlValue(const String& xml, const String& tag, String& value, const char* context, bool required) {
@@ -264,26 +922,29 @@ SonosResult Sonos::getVolume(const String& deviceIP, int& volume) {
                                         VOLUME_GET_TEMPLATE, response);
 
     if (result == SonosResult::SUCCESS) {
-        String volumeStr;
-        if (getXmlValue(response, "CurrentVolume", volumeStr, "GetVolume response", true)) {
-            String parseError;
-            bool parsed = SonosXmlParser::parseInt(volumeStr, volume, parseError);
-            if (parsed && (volume < 0 || volume > 100)) {
-                parseError = "out of expected range 0..100";
-            }
-            if (!parsed || volume < 0 || volume > 100) {
-                logMessage(LogLevel::ERROR, "xml", "Invalid <CurrentVolume> value '" + volumeStr + "' (" + parseError + ")");
-                return SonosResult::ERROR_SOAP_FAULT;
-            }
-            logMessage(LogLevel::DEBUG, "control", "Current volume: " + String(volume) + " on " + deviceIP);
-        } else {
-            return SonosResult::ERROR_SOAP_FAULT;
-        }
+        if (!parseVolume(response, "CurrentVolume", "GetVolume response", volume)) return SonosResult::ERROR_SOAP_FAULT;
+        logMessage(LogLevel::DEBUG, "control", "Current volume: " + String(volume) + " on " + deviceIP);
     }
 
     return result;
 }
 
+bool Sonos::parseVolume(const String& response, const char* tag, const char* context, int& volume) {
+    String volumeStr;
+    if (!getXmlValue(response, tag, volumeStr, context, true)) return false;
+
+    String parseError;
+    bool parsed = SonosXmlParser::parseInt(volumeStr, volume, parseError);
+    if (parsed && (volume < 0 || volume > 100)) {
+        parseError = "out of expected range 0..100";
+    }
+    if (!parsed || volume < 0 || volume > 100) {
+        logMessage(LogLevel::ERROR, "xml", "Invalid <" + String(tag) + "> value '" + volumeStr + "' (" + parseError + ")");
+        return false;
+    }
+    return true;
+}
+
 SonosResult Sonos::increaseVolume(const String& deviceIP, int increment) {
     int currentVolume;
     SonosResult result = getVolume(deviceIP, currentVolume);
@@ -312,6 +973,124 @@ SonosResult Sonos::setMute(const String& deviceIP, bool mute) {
     return sendSoapRequest(deviceIP, "RenderingControl", "SetMute", body, response);
 }
 
+SonosResult Sonos::setGroupVolume(const String& deviceIP, int volume) {
+    if (!_initialized) return SonosResult::ERROR_INVALID_DEVICE;
+    if (volume < 0 || volume > 100) return SonosResult::ERROR_INVALID_PARAM;
+
+    char body[200];
+    snprintf(body, sizeof(body), GROUP_VOLUME_SET_TEMPLATE, volume);
+
+    String response;
+    SonosResult result = sendSoapRequest(deviceIP, "GroupRenderingControl", "SetGroupVolume", body, response);
+    if (result == SonosResult::SUCCESS) logMessage(LogLevel::INFO, "control", "Group volume set to " + String(volume) + " via " + deviceIP);
+    return result;
+}
+
+SonosResult Sonos::getGroupVolume(const String& deviceIP, int& volume) {
+    if (!_initialized) return SonosResult::ERROR_INVALID_DEVICE;
+
+    String response;
+    SonosResult result = sendSoapRequest(deviceIP, "GroupRenderingControl", "GetGroupVolume", GROUP_VOLUME_GET_TEMPLATE, response);
+    if (result == SonosResult::SUCCESS && !parseVolume(response, "CurrentVolume", "GetGroupVolume response", volume)) {
+        return SonosResult::ERROR_SOAP_FAULT;
+    }
+    return result;
+}
+
+SonosResult Sonos::adjustGroupVolume(const String& deviceIP, int adjustment, int& newVolume) {
+    if (!_initialized) return SonosResult::ERROR_INVALID_DEVICE;
+
+    char body[220];
+    snprintf(body, sizeof(body), GROUP_VOLUME_ADJUST_TEMPLATE, adjustment);
+
+    String response;
+    SonosResult result = sendSoapRequest(deviceIP, "GroupRenderingControl", "SetRelativeGroupVolume", body, response);
+    if (result == SonosResult::SUCCESS && !parseVolume(response, "NewVolume", "SetRelativeGroupVolume response", newVolume)) {
+        return SonosResult::ERROR_SOAP_FAULT;
+    }
+    return result;
+}
+
+SonosResult Sonos::setGroupMute(const String& deviceIP, bool mute) {
+    if (!_initialized) return SonosResult::ERROR_INVALID_DEVICE;
+
+    char body[200];
+    snprintf(body, sizeof(body), GROUP_MUTE_SET_TEMPLATE, mute ? 1 : 0);
+
+    String response;
+    return sendSoapRequest(deviceIP, "GroupRenderingControl", "SetGroupMute", body, response);
+}
+
+size_t Sonos::fanOut(const std::vector<String>& deviceIPs, const String& service, const String& action, const String& body,
+                     uint32_t deadlineMs, std::vector<SonosResult>* results) {
+    if (results != nullptr) results->assign(deviceIPs.size(), SonosResult::ERROR_INVALID_PARAM);
+    if (!_initialized) return 0;
+
+    bool toCoordinator = service == "AVTransport" || service == "GroupRenderingControl";
+    String envelope = formatSoapRequest(service, action, body);
+    String headers = "Content-Type: text/xml; charset=utf-8\r\n"
+                     "SOAPAction: \"urn:schemas-upnp-org:service:" + service + ":1#" + action + "\"\r\n";
+    String path = controlPath(service);
+
+    std::vector<String> targets;
+    std::vector<int> targetOf(deviceIPs.size(), -1);
+    std::vector<SonosParallelHttp::Request> requests;
+    for (size_t i = 0; i < deviceIPs.size(); i++) {
+        if (!isValidIP(deviceIPs[i])) continue;
+        String target = toCoordinator ? getCoordinatorIP(deviceIPs[i]) : deviceIPs[i];
+        size_t t = 0;
+        while (t < targets.size() && targets[t] != target) t++;
+        targetOf[i] = t;
+        if (t < targets.size()) continue;
+
+        targets.push_back(target);
+        SonosParallelHttp::Request request;
+        request.ip.fromString(target);
+        request.request = SonosParallelHttp::buildPost(request.ip, 1400, path, headers, envelope);
+        request.maxResponseBytes = 16;  // The status line is all that is checked
+        requests.push_back(request);
+    }
+
+    unsigned long start = millis();
+    SonosParallelHttp::run(requests, _config.fanOutTimeoutMs, deadlineMs, _config.probeConcurrency);
+    unsigned long elapsed = millis() - start;
+
+    std::vector<SonosResult> targetResults(targets.size(), SonosResult::ERROR_NETWORK);
+    size_t succeeded = 0;
+    for (size_t t = 0; t < targets.size(); t++) {
+        int status = requests[t].statusCode;
+        if (status == HTTP_CODE_OK) {
+            targetResults[t] = SonosResult::SUCCESS;
+            succeeded++;
+        } else if (status == HTTP_CODE_INTERNAL_SERVER_ERROR) {
+            targetResults[t] = SonosResult::ERROR_SOAP_FAULT;
+        } else if (status < 0 && requests[t].connected) {
+            targetResults[t] = SonosResult::ERROR_TIMEOUT;
+        }
+        recordRequestResult(targets[t], status < 0);
+    }
+    if (results != nullptr) {
+        for (size_t i = 0; i < deviceIPs.size(); i++) {
+            if (targetOf[i] >= 0) (*results)[i] = targetResults[targetOf[i]];
+        }
+    }
+
+    logMessage(LogLevel::INFO, "control", action + " fanned out to " + String(targets.size()) + " speakers in " + String(elapsed) +
+               " ms (" + String(succeeded) + " ok, " + String(targets.size() - succeeded) + " failed)");
+    return succeeded;
+}
+
+size_t Sonos::pauseAll(const std::vector<String>& deviceIPs, uint32_t deadlineMs) {
+    return fanOut(deviceIPs, "AVTransport", "Pause", TRANSPORT_PAUSE_TEMPLATE, deadlineMs);
+}
+
+size_t Sonos::setVolumeAll(const std::vector<String>& deviceIPs, int volume, uint32_t deadlineMs) {
+    if (volume < 0 || volume > 100) return 0;
+    char body[200];
+    snprintf(body, sizeof(body), VOLUME_SET_TEMPLATE, volume);
+    return fanOut(deviceIPs, "RenderingControl", "SetVolume", body, deadlineMs);
+}
+
 SonosResult Sonos::play(const String& deviceIP) {
     if (!_initialized) return SonosResult::ERROR_INVALID_DEVICE;
     String response;
@@ -356,23 +1135,11 @@ SonosResult Sonos::sendSoapRequest(const String& deviceIP, const String& service
                                   const String& action, const String& body, String& response) {
     if (!isValidIP(deviceIP)) return SonosResult::ERROR_INVALID_PARAM;
 
-    String soapBody = formatSoapRequest(service, action, body);
-    String url = "http://" + deviceIP + ":1400/MediaRenderer/" + service + "/Control";
-
-    if (_config.enableVerboseLogging) {
-        logMessage(LogLevel::DEBUG, "soap", "REQUEST url=" + url + " action=" + action);
-        logMessage(LogLevel::DEBUG, "soap", "REQUEST body=" + summarizeXml(soapBody, 600));
-    }
-
-    _http.begin(url);
-    _http.addHeader("Content-Type", "text/xml; charset=utf-8");
-    _http.addHeader("SOAPAction", "\"urn:schemas-upnp-org:service:" + service + ":1#" + action + "\"");
-
-    int httpCode = -1;
-    for (int retry = 0; retry < _config.maxRetries && httpCode != HTTP_CODE_OK; retry++) {
-        httpCode = _http.POST(soapBody);
-        if (httpCode != HTTP_CODE_OK) delay(100 * (retry + 1));
-    }
+    // Grouped members reject transport commands and report x-rincon: queries; go to the coordinator
+    bool toCoordinator = service == "AVTransport" || service == "GroupRenderingControl";
+    String targetIP = toCoordinator ? getCoordinatorIP(deviceIP) : deviceIP;
+    String url;
+    int httpCode = postSoap(targetIP, service, action, body, url);
 
     if (httpCode == HTTP_CODE_OK) {
         response = _http.getString();
@@ -380,6 +1147,7 @@ SonosResult Sonos::sendSoapRequest(const String& deviceIP, const String& service
             logMessage(LogLevel::DEBUG, "soap", "RESPONSE body=" + summarizeXml(response, 600));
         }
         _http.end();
+        recordRequestResult(targetIP, false);
         return SonosResult::SUCCESS;
     } else if (httpCode == HTTP_CODE_INTERNAL_SERVER_ERROR) {
         response = _http.getString();
@@ -387,12 +1155,174 @@ SonosResult Sonos::sendSoapRequest(const String& deviceIP, const String& service
             logMessage(LogLevel::WARN, "soap", "ERROR RESPONSE body=" + summarizeXml(response, 600));
         }
         _http.end();
+        recordRequestResult(targetIP, false);
         return SonosResult::ERROR_SOAP_FAULT;
     } else {
         _http.end();
         logMessage(LogLevel::ERROR, "soap", "HTTP error: " + String(httpCode) + " for " + url);
+        recordRequestResult(targetIP, true);
+        return SonosResult::ERROR_NETWORK;
+    }
+}
+
+SonosResult Sonos::sendSoapRequest(const String& deviceIP, const String& service, const String& action,
+                                  const String& body, const std::function<void(const char*, size_t)>& onData) {
+    if (!isValidIP(deviceIP)) return SonosResult::ERROR_INVALID_PARAM;
+
+    // HTTP/1.0 keeps the body unchunked and makes the speaker close when it is done, so a reply
+    // without Content-Length ends at once instead of after soapTimeoutMs on a kept-alive socket
+    _http.useHTTP10(true);
+    String url;
+    int httpCode = postSoap(deviceIP, service, action, body, url);
+    bool complete = httpCode == HTTP_CODE_OK && streamResponseBody(onData);
+    _http.end();
+    _http.useHTTP10(false);
+    _http.setReuse(true);
+
+    if (httpCode != HTTP_CODE_OK) {
+        logMessage(LogLevel::ERROR, "soap", "HTTP error: " + String(httpCode) + " for " + url);
+        recordRequestResult(deviceIP, httpCode != HTTP_CODE_INTERNAL_SERVER_ERROR);
+        return httpCode == HTTP_CODE_INTERNAL_SERVER_ERROR ? SonosResult::ERROR_SOAP_FAULT : SonosResult::ERROR_NETWORK;
+    }
+    if (!complete) {
+        logMessage(LogLevel::ERROR, "soap", "Response body cut short for " + url);
+        recordRequestResult(deviceIP, true);
         return SonosResult::ERROR_NETWORK;
     }
+    recordRequestResult(deviceIP, false);
+    return SonosResult::SUCCESS;
+}
+
+// True once the whole body went to onData: Content-Length bytes, or everything up to the close without one
+bool Sonos::streamResponseBody(const std::function<void(const char*, size_t)>& onData) {
+    int remaining = _http.getSize();
+    WiFiClient* stream = _http.getStreamPtr();
+    if (stream == nullptr) return false;
+    char buffer[256];
+    unsigned long lastData = millis();
+    while (remaining != 0 && millis() - lastData < _config.soapTimeoutMs) {
+        int available = stream->available();
+        if (available <= 0) {
+            if (!stream->connected()) return remaining < 0;
+            delay(1);
+            continue;
+        }
+        int toRead = min((int)sizeof(buffer), available);
+        if (remaining > 0) toRead = min(toRead, remaining);
+        int n = stream->read((uint8_t*)buffer, toRead);
+        if (n <= 0) break;
+        onData(buffer, n);
+        if (remaining > 0) remaining -= n;
+        lastData = millis();
+    }
+    if (remaining == 0) return true;
+    stream->stop();
+    return false;
+}
+
+int Sonos::postSoap(const String& deviceIP, const String& service, const String& action, const String& body, String& url) {
+    String soapBody = formatSoapRequest(service, action, body);
+    url = "http://" + deviceIP + ":1400" + controlPath(service);
+
+    if (_config.enableVerboseLogging) {
+        logMessage(LogLevel::DEBUG, "soap", "REQUEST url=" + url + " action=" + action);
+        logMessage(LogLevel::DEBUG, "soap", "REQUEST body=" + summarizeXml(soapBody, 600));
+    }
+
+    _http.begin(url);
+    _http.addHeader("Content-Type", "text/xml; charset=utf-8");
+    _http.addHeader("SOAPAction", "\"urn:schemas-upnp-org:service:" + service + ":1#" + action + "\"");
+
+    int httpCode = -1;
+    for (int retry = 0; retry < _config.maxRetries && httpCode != HTTP_CODE_OK; retry++) {
+        httpCode = _http.POST(soapBody);
+        if (httpCode != HTTP_CODE_OK) delay(100 * (retry + 1));
+    }
+    return httpCode;
+}
+
+String Sonos::controlPath(const String& service) {
+    if (service == "AVTransport" || service == "RenderingControl" || service == "GroupRenderingControl" ||
+        service == "ConnectionManager" || service == "Queue") {
+        return "/MediaRenderer/" + service + "/Control";
+    }
+    if (service == "ContentDirectory") return "/MediaServer/ContentDirectory/Control";
+    return "/" + service + "/Control";  // ZoneGroupTopology, DeviceProperties, AlarmClock, ...
+}
+
+SonosResult Sonos::refreshTopology(const String& deviceIP) {
+    if (!_initialized) return SonosResult::ERROR_INVALID_DEVICE;
+
+    std::vector<SonosZoneMember> members;
+    SonosXmlParser::ZoneGroupStateParser parser([&members](const SonosXmlParser::ZoneGroupStateParser::Member& member) {
+        addZoneMember(members, member);
+    });
+
+    unsigned long start = millis();
+    SonosResult result = sendSoapRequest(deviceIP, "ZoneGroupTopology", "GetZoneGroupState", GET_ZONE_GROUP_STATE_TEMPLATE,
+                                         [&parser](const char* data, size_t len) { parser.feed(data, len); });
+    // A cut-off body would drop every member listed after the cut; keep the old topology instead
+    if (result != SonosResult::SUCCESS) return result;
+    if (members.empty()) {
+        logMessage(LogLevel::WARN, "topology", "GetZoneGroupState from " + deviceIP + " listed no members");
+        return SonosResult::ERROR_SOAP_FAULT;
+    }
+
+    setZoneMembers(members);
+    logMessage(LogLevel::INFO, "topology", "Topology from " + deviceIP + ": " + String(_zoneMembers.size()) + " members in " +
+               String(millis() - start) + " ms");
+    return SonosResult::SUCCESS;
+}
+
+size_t Sonos::applyZoneGroupState(const String& xml) {
+    std::vector<SonosZoneMember> members;
+    SonosXmlParser::ZoneGroupStateParser parser([&members](const SonosXmlParser::ZoneGroupStateParser::Member& member) {
+        addZoneMember(members, member);
+    });
+    parser.feed(xml.c_str(), xml.length());
+    if (!members.empty()) setZoneMembers(members);
+    return members.size();
+}
+
+void Sonos::setZoneMembers(std::vector<SonosZoneMember>& members) {
+    _zoneMembers.swap(members);
+
+    std::map<String, String> ipByUuid;
+    for (const auto& member : _zoneMembers) ipByUuid[member.uuid] = member.ip;
+
+    _coordinatorByIP.clear();
+    size_t grouped = 0;
+    for (const auto& member : _zoneMembers) {
+        auto coordinator = ipByUuid.find(member.coordinatorUuid);
+        if (coordinator == ipByUuid.end() || member.ip.length() == 0) continue;
+        _coordinatorByIP[member.ip] = coordinator->second;
+        if (coordinator->second != member.ip) grouped++;
+    }
+    logMessage(LogLevel::DEBUG, "topology", String(_zoneMembers.size()) + " members, " + String(grouped) + " following another coordinator");
+}
+
+std::vector<String> Sonos::getGroupMemberIPs(const String& deviceIP) const {
+    std::vector<String> ips;
+    String coordinatorUuid;
+    for (const auto& member : _zoneMembers) {
+        if (member.ip == deviceIP) coordinatorUuid = member.coordinatorUuid;
+    }
+    if (coordinatorUuid.length() > 0) {
+        for (const auto& member : _zoneMembers) {
+            if (member.coordinatorUuid == coordinatorUuid) ips.push_back(member.ip);
+        }
+    }
+    if (ips.empty()) ips.push_back(deviceIP);
+    return ips;
+}
+
+bool Sonos::isGrouped(const String& deviceIP) const {
+    return getGroupMemberIPs(deviceIP).size() > 1;
+}
+
+String Sonos::getCoordinatorIP(const String& deviceIP) const {
+    auto coordinator = _coordinatorByIP.find(deviceIP);
+    return coordinator != _coordinatorByIP.end() ? coordinator->second : deviceIP;
 }
 
 String Sonos::formatSoapRequest(const String& service, const String& action, const String& body) {
@@ -437,6 +1367,16 @@ SonosDevice* Sonos::getDeviceByIP(const String& ip) {
     return nullptr;
 }
 
+SonosDevice* Sonos::getDeviceByUuid(const String& uuid) {
+    if (uuid.length() == 0) return nullptr;
+    for (auto& device : _devices) {
+        if (device.uuid == uuid) {
+            return &device;
+        }
+    }
+    return nullptr;
+}
+
 String Sonos::getErrorString(SonosResult result) {
     switch (result) {
         case SonosResult::SUCCESS: return "Success";
@@ -461,8 +1401,10 @@ SonosResult Sonos::getTrackInfo(const String& deviceIP, String& title, String& a
         String trackUri;
         getXmlValue(response, "TrackURI", trackUri, "GetPositionInfo response", false);
         if (trackUri.startsWith("x-rincon:")) {
+            // Only reached when the topology cache is missing or stale; refresh it so later calls route directly
             String masterUuid = trackUri.substring(9);
             logMessage(LogLevel::INFO, "playback", "Redirecting to coordinator: " + masterUuid);
+            refreshTopology(deviceIP);
 
             for (const auto& dev : _devices) {
                 if (dev.uuid.indexOf(masterUuid) != -1) {
@@ -6,8 +6,12 @@
 #include <WiFiUdp.h>
 #include <HTTPClient.h>
 #include <vector>
+#include <map>
 #include <functional>
 #include "../../include/AppLogger.h"
+#include "SonosSsdpParser.h"
+#include "SonosXmlParser.h"
+#include "SonosParallelHttp.h"
 
 enum class SonosResult {
     SUCCESS = 0,
@@ -19,10 +23,48 @@ enum class SonosResult {
     ERROR_INVALID_PARAM = -6
 };
 
+enum class SonosReachability : uint8_t {
+    UNKNOWN = 0,
+    REACHABLE,  // Answered at its recorded IP with the expected UUID
+    STALE,      // Nothing answered at its recorded IP
+    MOVED       // A different speaker answered at its recorded IP
+};
+
 struct SonosDevice {
     String name;
     String ip;
     String uuid;
+    int32_t bootId = -1;    // BOOTID.UPNP.ORG from the last SSDP response, -1 if unknown
+    int32_t configId = -1;  // CONFIGID.UPNP.ORG from the last SSDP response, -1 if unknown
+    unsigned long lastSeenMs = 0;
+    unsigned long maxAgeMs = 0;  // Presence lease from CACHE-CONTROL; 0 means no lease (e.g. loaded from cache)
+    SonosReachability reachability = SonosReachability::UNKNOWN;
+    uint8_t consecutiveFailures = 0;  // Network-level SOAP failures since the last success
+};
+
+struct SonosDiscoveryStats {
+    unsigned long durationMs = 0;
+    uint16_t devicesFound = 0;
+    uint8_t searchesSent = 0;
+    bool endedEarly = false;
+    uint16_t responses = 0;
+    uint16_t descriptionsFetched = 0;
+    uint16_t descriptionsSkipped = 0;
+    uint32_t descriptionBytesRead = 0;
+    uint32_t descriptionBytesTotal = 0;  // Sum of Content-Length for the fetched descriptions
+    uint16_t hostsProbed = 0;   // Subnet sweep only
+    uint16_t sweepHits = 0;     // Hosts with port 1400 open
+    unsigned long sweepMs = 0;
+    uint16_t packets = 0;           // SSDP datagrams read during the scan
+    uint16_t packetsTruncated = 0;  // Datagrams larger than the packet buffer
+    uint16_t drainLimitHits = 0;    // Passes that left datagrams queued; the socket may have overrun
+    uint32_t minFreeHeap = 0;       // Lowest free heap sampled while the scan ran
+};
+
+struct SonosZoneMember {
+    String uuid;  // RINCON_... (the device UDN without its "uuid:" prefix)
+    String ip;
+    String coordinatorUuid;
 };
 
 struct SonosConfig {
@@ -30,6 +72,22 @@ struct SonosConfig {
     uint16_t soapTimeoutMs = 10000;
     uint8_t maxRetries = 3;
     uint16_t discoveryPort = 1901;
+    uint8_t searchMx = 1;                 // MX sent in M-SEARCH; speakers reply within this many seconds
+    uint8_t searchBurstCount = 3;         // M-SEARCHes per scan
+    uint16_t searchBurstSpacingMs = 150;  // Gap before the second M-SEARCH; doubles for each later one
+    bool enablePresenceListener = true;
+    uint16_t probeTimeoutMs = 300;   // Per-device timeout when validating cached devices
+    uint16_t probeDeadlineMs = 800;  // Overall budget for a validation pass
+    uint8_t probeConcurrency = 8;    // Bounded by CONFIG_LWIP_MAX_SOCKETS; also used for description fetches
+    uint16_t descriptionTimeoutMs = 2000;  // Per-device budget when fetching descriptions in parallel
+    uint8_t presenceFetchConcurrency = 2;  // Sockets for descriptions of speakers first heard by NOTIFY
+    uint16_t fanOutTimeoutMs = 1500;       // Per-speaker budget for parallel SOAP fan-out
+    uint8_t resolveAfterFailures = 2;  // Consecutive network failures before re-resolving a device by UUID
+    // Unicast fallback for networks that drop SSDP multicast: TCP-probe port 1400 across a subnet
+    bool enableSubnetSweep = false;      // Sweep automatically when a multicast scan finds nothing
+    String sweepCidr = "";               // e.g. "192.168.1.0/24"; empty means the local /24
+    uint8_t sweepConcurrency = 8;        // Bounded by CONFIG_LWIP_MAX_SOCKETS
+    uint16_t sweepConnectTimeoutMs = 250;
     bool enableLogging = false;
     bool enableVerboseLogging = false;
 };
@@ -37,13 +95,51 @@ struct SonosConfig {
 class Sonos {
 private:
     WiFiUDP _udp;
+    WiFiUDP _notifyUdp;
     HTTPClient _http;
     std::vector<SonosDevice> _devices;
     SonosConfig _config;
     bool _initialized = false;
     bool _isDiscovering = false;
+    bool _presenceActive = false;
+    unsigned long _lastExpiryCheckMs = 0;
     unsigned long _discoveryStartTime = 0;
+    unsigned long _lastSearchMs = 0;
+    unsigned long _lastNewResponseMs = 0;
+    std::vector<String> _searchTargets;
+    std::vector<String> _expectedUuids;
+    size_t _expectedRemaining = 0;
+    bool _targetedDiscovery = false;
+    std::vector<String> _pendingResolves;
+    bool _sweepActive = false;
+    uint32_t _sweepNextHost = 0;  // Host byte order
+    uint32_t _sweepLastHost = 0;
+    uint32_t _sweepSkipHost = 0;
+    unsigned long _sweepStartMs = 0;
     std::vector<SonosDevice> _newDevices;
+    std::map<String, size_t> _newDeviceIndex;  // uuid -> position in _newDevices
+    // Descriptions are fetched in parallel batches after each read pass, not one per packet
+    struct PendingDescription {
+        SonosDevice device;
+        uint16_t port;
+        String path;
+    };
+    std::vector<PendingDescription> _pendingDescriptions;
+    // Body callbacks point into the batch, so it must stay in place until its fetches finish
+    struct DescriptionBatch {
+        std::vector<PendingDescription> items;
+        std::vector<SonosXmlParser::StreamingTagExtractor> extractors;
+        std::vector<SonosParallelHttp::Request> requests;
+        std::vector<size_t> bytesRead;
+        SonosParallelHttp http;
+    };
+    // Speakers first heard by NOTIFY; updatePresence() fetches their descriptions without blocking
+    std::vector<PendingDescription> _presenceQueue;
+    DescriptionBatch _presenceBatch;
+    std::vector<SonosZoneMember> _zoneMembers;
+    std::map<String, String> _coordinatorByIP;  // member IP -> group coordinator IP
+    SonosDiscoveryStats _discoveryStats;
+    char _packetBuffer[1024];
     
     // SSDP/UPnP constants
     static const char* SSDP_MULTICAST_IP;
@@ -63,13 +159,50 @@ private:
     static const char* TRANSPORT_PREVIOUS_TEMPLATE;
     static const char* GET_POSITION_INFO_TEMPLATE;
     static const char* GET_TRANSPORT_INFO_TEMPLATE;
+    static const char* GET_ZONE_GROUP_STATE_TEMPLATE;
+    static const char* GROUP_VOLUME_SET_TEMPLATE;
+    static const char* GROUP_VOLUME_GET_TEMPLATE;
+    static const char* GROUP_VOLUME_ADJUST_TEMPLATE;
+    static const char* GROUP_MUTE_SET_TEMPLATE;
     
-    bool parseDeviceDescription(const String& xml, SonosDevice& device);
+    bool parseDeviceDescription(const SonosXmlParser::StreamingTagExtractor& extractor, SonosDevice& device);
+    void queueDescriptionFetch(const SonosDevice& device, uint16_t port, const String& path);
+    void fetchPendingDescriptions();
+    void startDescriptionBatch(DescriptionBatch& batch, size_t maxConcurrent);
+    bool takeDescription(DescriptionBatch& batch, size_t index, SonosDevice& device);
+    void updatePresenceFetches();
+    void publishPresence(const SonosDevice& device);
+    SonosResult startDiscovery(const std::vector<String>& searchTargets, const std::vector<String>& expectedUuids, bool targeted);
+    bool sendSearches();
+    bool isExpectedUuid(const String& uuid) const;
+    void finishDiscovery(bool endedEarly);
+    void completeMulticastPhase(bool endedEarly);
+    bool startSubnetSweep();
+    void updateSubnetSweep();
+    static bool parseCidr(const String& cidr, uint32_t& network, uint8_t& prefix);
+    void handleDiscoveryPacket(size_t len);
+    void handleNotifyPacket(size_t len);
+    const SonosDevice* findKnownDevice(const String& uuid) const;
+    void addDiscoveredDevice(const SonosDevice& device);
+    bool upsertDevice(std::vector<SonosDevice>& devices, const SonosDevice& device);
+    void removeDevice(const String& uuid, const char* reason);
+    void reportAddressChange(const SonosDevice& previous, const SonosDevice& updated);
+    void recordRequestResult(const String& deviceIP, bool networkFailure);
+    void expirePresence();
+    static void applyPresence(SonosDevice& device, const SonosSsdpParser::SsdpPacket& packet);
+    static bool presenceExpired(const SonosDevice& device, unsigned long now);
     bool getXmlValue(const String& xml, const String& tag, String& value, const char* context, bool required = true);
     bool parseTimeToSeconds(const String& value, int& seconds, const char* context);
     String summarizeXml(const String& xml, int maxLen = 200);
     SonosResult sendSoapRequest(const String& deviceIP, const String& service, 
                                const String& action, const String& body, String& response);
+    // Streams the response body to onData instead of buffering it
+    SonosResult sendSoapRequest(const String& deviceIP, const String& service, const String& action,
+                               const String& body, const std::function<void(const char*, size_t)>& onData);
+    bool streamResponseBody(const std::function<void(const char*, size_t)>& onData);
+    int postSoap(const String& deviceIP, const String& service, const String& action, const String& body, String& url);
+    static String controlPath(const String& service);
+    bool parseVolume(const String& response, const char* tag, const char* context, int& volume);
     String formatSoapRequest(const String& service, const String& action, const String& body);
     bool isValidIP(const String& ip);
     void logMessage(LogLevel level, const char* channel, const String& message);
@@ -84,20 +217,56 @@ public:
     
     // Discovery
     SonosResult discoverDevices();
+    SonosResult discoverDevices(const std::vector<String>& uuids);  // Targeted search; merges results into the device list
+    SonosResult sweepSubnet();  // Unicast sweep of sweepCidr (or the local /24) without M-SEARCH
     void updateDiscovery();
     bool isDiscovering() const { return _isDiscovering; }
+    const SonosDiscoveryStats& getLastDiscoveryStats() const { return _discoveryStats; }
+
+    // Concurrently probes each device's description and updates its reachability. Returns the number that failed.
+    size_t validateDevices(std::vector<SonosDevice>& devices);
+
+    // Passive presence: ssdp:alive/byebye NOTIFYs on 239.255.255.250:1900
+    void updatePresence();
+    bool isPresenceActive() const { return _presenceActive; }
     std::vector<SonosDevice> getDiscoveredDevices() const;
     void setDevices(const std::vector<SonosDevice>& devices) { _devices = devices; }
     SonosDevice* getDeviceByName(const String& name);
     SonosDevice* getDeviceByIP(const String& ip);
+    SonosDevice* getDeviceByUuid(const String& uuid);
+    // Devices whose requests kept failing at the network level; resolvePendingDevices() searches for them by UUID
+    bool hasPendingResolves() const { return !_pendingResolves.empty(); }
+    SonosResult resolvePendingDevices();
     int getDeviceCount() const { return _devices.size(); }
     
+    // Zone group topology; AVTransport calls are routed straight to the group coordinator
+    SonosResult refreshTopology(const String& deviceIP);
+    size_t applyZoneGroupState(const String& xml);  // Body of a ZoneGroupTopology event
+    String getCoordinatorIP(const String& deviceIP) const;  // deviceIP itself when not grouped or unknown
+    std::vector<String> getGroupMemberIPs(const String& deviceIP) const;  // Includes deviceIP
+    bool isGrouped(const String& deviceIP) const;
+    const std::vector<SonosZoneMember>& getZoneMembers() const { return _zoneMembers; }
+    void setZoneMembers(std::vector<SonosZoneMember>& members);  // Also seeds the cache from a saved copy
+
     // Control
     SonosResult setVolume(const String& deviceIP, int volume);
     SonosResult getVolume(const String& deviceIP, int& volume);
     SonosResult increaseVolume(const String& deviceIP, int increment = 5);
     SonosResult decreaseVolume(const String& deviceIP, int decrement = 5);
     SonosResult setMute(const String& deviceIP, bool mute);
+
+    // Whole-group volume through GroupRenderingControl; one call on the coordinator
+    SonosResult setGroupVolume(const String& deviceIP, int volume);
+    SonosResult getGroupVolume(const String& deviceIP, int& volume);
+    SonosResult adjustGroupVolume(const String& deviceIP, int adjustment, int& newVolume);
+    SonosResult setGroupMute(const String& deviceIP, bool mute);
+
+    // Sends one action to many speakers concurrently, bounded by deadlineMs overall. AVTransport and
+    // GroupRenderingControl actions go once to each distinct coordinator. Returns the number that succeeded.
+    size_t fanOut(const std::vector<String>& deviceIPs, const String& service, const String& action, const String& body,
+                  uint32_t deadlineMs, std::vector<SonosResult>* results = nullptr);
+    size_t pauseAll(const std::vector<String>& deviceIPs, uint32_t deadlineMs = 2000);
+    size_t setVolumeAll(const std::vector<String>& deviceIPs, int volume, uint32_t deadlineMs = 2000);
     
     SonosResult play(const String& deviceIP);
     SonosResult pause(const String& deviceIP);
@@ -116,13 +285,19 @@ public:
     
     // Callbacks
     typedef std::function<void(const SonosDevice&)> DeviceFoundCallback;
+    typedef std::function<void(const SonosDevice&)> DeviceLostCallback;
+    typedef std::function<void(const SonosDevice& device, const String& oldIP)> DeviceMovedCallback;
     typedef std::function<void(const String&)> LogCallback;
     
     void setDeviceFoundCallback(DeviceFoundCallback callback) { _deviceFoundCallback = callback; }
+    void setDeviceLostCallback(DeviceLostCallback callback) { _deviceLostCallback = callback; }
+    void setDeviceMovedCallback(DeviceMovedCallback callback) { _deviceMovedCallback = callback; }
     void setLogCallback(LogCallback callback) { _logCallback = callback; }
     
 private:
     DeviceFoundCallback _deviceFoundCallback = nullptr;
+    DeviceLostCallback _deviceLostCallback = nullptr;
+    DeviceMovedCallback _deviceMovedCallback = nullptr;
     LogCallback _logCallback = nullptr;
 };
 
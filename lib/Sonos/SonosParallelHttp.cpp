@@ -0,0 +1,244 @@
+#include "SonosParallelHttp.h"
+#include <lwip/sockets.h>
+#include <errno.h>
+
+namespace {
+
+// Header lines longer than this keep only their start; status and Content-Length fit well inside
+const size_t MAX_LINE = 96;
+
+int parseStatusCode(const char* data, size_t len) {
+    // "HTTP/1.1 200 OK"
+    if (len < 12 || memcmp(data, "HTTP/1.", 7) != 0) return -1;
+    int code = 0;
+    for (size_t i = 9; i < 12; i++) {
+        if (!isdigit(static_cast<unsigned char>(data[i]))) return -1;
+        code = code * 10 + (data[i] - '0');
+    }
+    return code;
+}
+
+}  // namespace
+
+bool SonosParallelHttp::openSocket(const Request& request, size_t index, Slot& slot) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(request.port);
+    addr.sin_addr.s_addr = static_cast<uint32_t>(request.ip);
+
+    int res = connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    if (res < 0 && errno != EINPROGRESS) {
+        close(fd);
+        return false;
+    }
+
+    slot.fd = fd;
+    slot.index = index;
+    slot.sent = 0;
+    slot.connecting = true;
+    slot.line = "";
+    slot.statusSeen = false;
+    slot.inBody = false;
+    slot.startMs = millis();
+    return true;
+}
+
+// Parses the status line and headers a line at a time, so a status line split across reads is still
+// seen whole. Returns the offset of the first body byte in data, or len if the headers have not ended yet
+size_t SonosParallelHttp::readHeaders(Slot& slot, Request& request, const char* data, size_t len) {
+    size_t i = 0;
+    while (i < len && !slot.inBody) {
+        char c = data[i++];
+        if (c != '\n') {
+            if (c != '\r' && slot.line.length() < MAX_LINE) slot.line += c;
+            continue;
+        }
+        if (!slot.statusSeen) {
+            slot.statusSeen = true;
+            request.statusCode = parseStatusCode(slot.line.c_str(), slot.line.length());
+        } else if (slot.line.length() == 0) {
+            slot.inBody = true;
+        } else if (slot.line.length() > 15 && strncasecmp(slot.line.c_str(), "Content-Length:", 15) == 0) {
+            request.contentLength = atol(slot.line.c_str() + 15);
+        }
+        slot.line = "";
+    }
+    return i;
+}
+
+size_t SonosParallelHttp::run(std::vector<Request>& requests, uint32_t perRequestTimeoutMs, uint32_t deadlineMs,
+                              size_t maxConcurrent) {
+    SonosParallelHttp http;
+    http.start(requests, perRequestTimeoutMs, deadlineMs, maxConcurrent);
+    while (!http.poll(10)) {
+    }
+    return http.completed();
+}
+
+SonosParallelHttp::~SonosParallelHttp() {
+    stop();
+}
+
+void SonosParallelHttp::stop() {
+    for (const auto& slot : _active) close(slot.fd);
+    _active.clear();
+    _requests = nullptr;
+}
+
+void SonosParallelHttp::start(std::vector<Request>& requests, uint32_t perRequestTimeoutMs, uint32_t deadlineMs,
+                              size_t maxConcurrent) {
+    stop();
+    _requests = &requests;
+    _next = 0;
+    _completed = 0;
+    _perRequestTimeoutMs = perRequestTimeoutMs;
+    _deadlineMs = deadlineMs;
+    _maxConcurrent = maxConcurrent > 0 ? maxConcurrent : 1;
+    _active.reserve(_maxConcurrent);
+    _startMs = millis();
+}
+
+void SonosParallelHttp::finish(size_t slotPos, bool ok) {
+    Slot& slot = _active[slotPos];
+    Request& request = (*_requests)[slot.index];
+    request.complete = ok;
+    request.elapsedMs = millis() - slot.startMs;
+    close(slot.fd);
+    if (ok) _completed++;
+    _active[slotPos] = _active.back();
+    _active.pop_back();
+}
+
+bool SonosParallelHttp::poll(uint32_t waitMs) {
+    if (_requests == nullptr) return true;
+    std::vector<Request>& requests = *_requests;
+    char buffer[512];
+
+    unsigned long now = millis();
+    bool pastDeadline = now - _startMs >= _deadlineMs;
+
+    while (!pastDeadline && _active.size() < _maxConcurrent && _next < requests.size()) {
+        Slot slot;
+        if (openSocket(requests[_next], _next, slot)) _active.push_back(slot);
+        _next++;
+    }
+
+    // Sockets just opened are stamped after the deadline check; a stale now would wrap and expire them
+    now = millis();
+    for (size_t i = 0; i < _active.size();) {
+        if (pastDeadline || now - _active[i].startMs >= _perRequestTimeoutMs) {
+            finish(i, false);
+        } else {
+            i++;
+        }
+    }
+
+    if (_active.empty()) {
+        if (pastDeadline || _next >= requests.size()) {
+            _requests = nullptr;
+            return true;
+        }
+        return false;
+    }
+
+    fd_set readSet;
+    fd_set writeSet;
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+    int maxFd = -1;
+    for (const auto& slot : _active) {
+        const Request& request = requests[slot.index];
+        if (slot.connecting || slot.sent < request.request.length()) FD_SET(slot.fd, &writeSet);
+        else FD_SET(slot.fd, &readSet);
+        if (slot.fd > maxFd) maxFd = slot.fd;
+    }
+
+    struct timeval tv;
+    tv.tv_sec = waitMs / 1000;
+    tv.tv_usec = (waitMs % 1000) * 1000;
+    if (select(maxFd + 1, &readSet, &writeSet, nullptr, &tv) <= 0) return false;
+
+    for (size_t i = 0; i < _active.size();) {
+        Slot& slot = _active[i];
+        Request& request = requests[slot.index];
+        bool done = false;
+        bool ok = false;
+
+        if (FD_ISSET(slot.fd, &writeSet)) {
+            if (slot.connecting) {
+                int sockErr = 0;
+                socklen_t errLen = sizeof(sockErr);
+                getsockopt(slot.fd, SOL_SOCKET, SO_ERROR, &sockErr, &errLen);
+                if (sockErr != 0) {
+                    done = true;
+                } else {
+                    slot.connecting = false;
+                    request.connected = true;
+                    if (request.request.length() == 0) {
+                        done = true;
+                        ok = true;
+                    }
+                }
+            }
+            if (!done && !slot.connecting && slot.sent < request.request.length()) {
+                int n = send(slot.fd, request.request.c_str() + slot.sent, request.request.length() - slot.sent, 0);
+                if (n > 0) slot.sent += n;
+                else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) done = true;
+            }
+        } else if (FD_ISSET(slot.fd, &readSet)) {
+            int n = recv(slot.fd, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                size_t bodyStart = slot.inBody ? 0 : readHeaders(slot, request, buffer, n);
+                size_t kept = request.response.length();
+                if (kept < request.maxResponseBytes) {
+                    request.response.concat(buffer, min(static_cast<size_t>(n), request.maxResponseBytes - kept));
+                }
+                if (request.onBody) {
+                    if (slot.inBody && request.statusCode != 200) {
+                        // An error page is not the body the caller asked for
+                        done = true;
+                        ok = request.statusCode > 0;
+                    } else if (slot.inBody && bodyStart < static_cast<size_t>(n) &&
+                               !request.onBody(buffer + bodyStart, n - bodyStart)) {
+                        done = true;
+                        ok = true;
+                    }
+                } else if (slot.statusSeen && request.response.length() >= request.maxResponseBytes) {
+                    done = true;
+                    ok = request.statusCode > 0;
+                }
+            } else if (n == 0) {
+                done = true;
+                ok = request.statusCode > 0;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                done = true;
+                ok = request.statusCode > 0;
+            }
+        }
+
+        if (done) finish(i, ok);
+        else i++;
+    }
+    return false;
+}
+
+String SonosParallelHttp::buildGet(const IPAddress& ip, uint16_t port, const char* path) {
+    return String("GET ") + path + " HTTP/1.1\r\n"
+           "Host: " + ip.toString() + ":" + String(port) + "\r\n"
+           "Connection: close\r\n\r\n";
+}
+
+String SonosParallelHttp::buildPost(const IPAddress& ip, uint16_t port, const String& path, const String& extraHeaders,
+                                    const String& body) {
+    return "POST " + path + " HTTP/1.1\r\n"
+           "Host: " + ip.toString() + ":" + String(port) + "\r\n" +
+           extraHeaders +
+           "Content-Length: " + String(body.length()) + "\r\n"
+           "Connection: close\r\n\r\n" + body;
+}
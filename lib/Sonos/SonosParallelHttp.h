@@ -0,0 +1,81 @@
+#ifndef SONOS_PARALLEL_HTTP_H
+#define SONOS_PARALLEL_HTTP_H
+
+#include <Arduino.h>
+#include <vector>
+#include <functional>
+
+// Runs many small HTTP exchanges concurrently on non-blocking lwIP sockets from the calling task.
+// Keep maxConcurrent below CONFIG_LWIP_MAX_SOCKETS minus the sockets the app already holds
+// (SSDP, NOTIFY listener, event server, HTTPClient).
+class SonosParallelHttp {
+public:
+    struct Request {
+        IPAddress ip;
+        uint16_t port = 1400;
+        String request;               // Raw HTTP request; empty means connect-only probe
+        size_t maxResponseBytes = 0;  // Response bytes to keep; reading stops once reached
+        // Receives body bytes (headers stripped) of a 200 response as they arrive; return false to stop reading
+        std::function<bool(const char* data, size_t len)> onBody;
+
+        // Results
+        bool connected = false;
+        bool complete = false;
+        int statusCode = -1;
+        long contentLength = -1;      // From the response headers; -1 if absent
+        String response;
+        unsigned long elapsedMs = 0;
+    };
+
+    static const size_t DEFAULT_MAX_CONCURRENT = 8;
+
+    // Returns the number of requests that completed before their timeout or the overall deadline.
+    static size_t run(std::vector<Request>& requests, uint32_t perRequestTimeoutMs, uint32_t deadlineMs,
+                      size_t maxConcurrent = DEFAULT_MAX_CONCURRENT);
+
+    // Incremental form of run() for callers that must not block: start(), then poll() from loop()
+    // until it returns true. requests must stay in place until then.
+    SonosParallelHttp() = default;
+    SonosParallelHttp(const SonosParallelHttp&) = delete;
+    SonosParallelHttp& operator=(const SonosParallelHttp&) = delete;
+    ~SonosParallelHttp();
+    void start(std::vector<Request>& requests, uint32_t perRequestTimeoutMs, uint32_t deadlineMs,
+               size_t maxConcurrent = DEFAULT_MAX_CONCURRENT);
+    // Services the sockets, waiting up to waitMs for activity; true once every request has finished
+    bool poll(uint32_t waitMs);
+    // Abandons whatever is still in flight; unfinished requests stay incomplete
+    void stop();
+    bool active() const { return _requests != nullptr; }
+    size_t completed() const { return _completed; }
+
+    static String buildGet(const IPAddress& ip, uint16_t port, const char* path);
+    // extraHeaders are complete "Name: value\r\n" lines
+    static String buildPost(const IPAddress& ip, uint16_t port, const String& path, const String& extraHeaders, const String& body);
+
+private:
+    struct Slot {
+        int fd = -1;
+        size_t index = 0;
+        size_t sent = 0;
+        bool connecting = true;
+        String line;              // Header line in progress; parsed once its LF arrives
+        bool statusSeen = false;
+        bool inBody = false;
+        unsigned long startMs = 0;
+    };
+
+    std::vector<Request>* _requests = nullptr;
+    std::vector<Slot> _active;
+    size_t _next = 0;
+    size_t _completed = 0;
+    uint32_t _perRequestTimeoutMs = 0;
+    uint32_t _deadlineMs = 0;
+    size_t _maxConcurrent = DEFAULT_MAX_CONCURRENT;
+    unsigned long _startMs = 0;
+
+    void finish(size_t slotPos, bool ok);
+    static bool openSocket(const Request& request, size_t index, Slot& slot);
+    static size_t readHeaders(Slot& slot, Request& request, const char* data, size_t len);
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include "SonosSsdpParser.h"
+#include <ctype.h>
+#include <strings.h>
+
+namespace SonosSsdpParser {
+
+namespace {
+
+bool headerNameIs(const char* name, size_t nameLen, const char* expected) {
+    size_t expectedLen = strlen(expected);
+    if (nameLen != expectedLen) return false;
+    for (size_t i = 0; i < nameLen; i++) {
+        if (toupper(static_cast<unsigned char>(name[i])) != expected[i]) return false;
+    }
+    return true;
+}
+
+int32_t parseNonNegative(const HeaderView& view) {
+    if (view.empty()) return -1;
+    int64_t value = 0;
+    for (size_t i = 0; i < view.len; i++) {
+        char c = view.data[i];
+        if (!isdigit(static_cast<unsigned char>(c))) return -1;
+        value = (value * 10) + (c - '0');
+        if (value > 2147483647LL) return -1;
+    }
+    return static_cast<int32_t>(value);
+}
+
+int32_t parseMaxAge(const HeaderView& cacheControl) {
+    static const char kDirective[] = "max-age";
+    const size_t directiveLen = sizeof(kDirective) - 1;
+    for (size_t i = 0; i + directiveLen <= cacheControl.len; i++) {
+        if (strncasecmp(cacheControl.data + i, kDirective, directiveLen) != 0) continue;
+        size_t pos = i + directiveLen;
+        while (pos < cacheControl.len && (cacheControl.data[pos] == ' ' || cacheControl.data[pos] == '=')) pos++;
+        size_t digitsEnd = pos;
+        while (digitsEnd < cacheControl.len && isdigit(static_cast<unsigned char>(cacheControl.data[digitsEnd]))) digitsEnd++;
+        HeaderView digits;
+        digits.data = cacheControl.data + pos;
+        digits.len = digitsEnd - pos;
+        return parseNonNegative(digits);
+    }
+    return -1;
+}
+
+}  // namespace
+
+bool HeaderView::contains(const char* needle) const {
+    size_t needleLen = strlen(needle);
+    if (needleLen == 0 || needleLen > len) return needleLen == 0;
+    for (size_t i = 0; i + needleLen <= len; i++) {
+        if (memcmp(data + i, needle, needleLen) == 0) return true;
+    }
+    return false;
+}
+
+bool HeaderView::startsWith(const char* prefix) const {
+    size_t prefixLen = strlen(prefix);
+    return prefixLen <= len && memcmp(data, prefix, prefixLen) == 0;
+}
+
+String HeaderView::toString() const {
+    String out;
+    if (data && len > 0) out.concat(data, len);
+    return out;
+}
+
+bool parsePacket(const char* buffer, size_t len, SsdpPacket& packet) {
+    packet = SsdpPacket();
+    if (buffer == nullptr || len == 0) return false;
+
+    const char* end = buffer + len;
+    packet.isNotify = len >= 6 && memcmp(buffer, "NOTIFY", 6) == 0;
+    const char* line = static_cast<const char*>(memchr(buffer, '\n', len));
+    if (line == nullptr) return false;
+    line++;  // Skip the status/request line
+
+    while (line < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if (lineEnd == nullptr) lineEnd = end;
+
+        const char* valueEnd = lineEnd;
+        if (valueEnd > line && valueEnd[-1] == '\r') valueEnd--;
+        if (valueEnd == line) break;  // Blank line terminates the header block
+
+        const char* colon = static_cast<const char*>(memchr(line, ':', valueEnd - line));
+        if (colon != nullptr) {
+            const char* nameEnd = colon;
+            while (nameEnd > line && isspace(static_cast<unsigned char>(nameEnd[-1]))) nameEnd--;
+            const char* valueStart = colon + 1;
+            while (valueStart < valueEnd && isspace(static_cast<unsigned char>(*valueStart))) valueStart++;
+            const char* trimmedEnd = valueEnd;
+            while (trimmedEnd > valueStart && isspace(static_cast<unsigned char>(trimmedEnd[-1]))) trimmedEnd--;
+
+            HeaderView value;
+            value.data = valueStart;
+            value.len = trimmedEnd - valueStart;
+
+            size_t nameLen = nameEnd - line;
+            if (headerNameIs(line, nameLen, "LOCATION")) packet.location = value;
+            else if (headerNameIs(line, nameLen, "USN")) packet.usn = value;
+            else if (headerNameIs(line, nameLen, "ST")) packet.st = value;
+            else if (headerNameIs(line, nameLen, "NT")) packet.nt = value;
+            else if (headerNameIs(line, nameLen, "NTS")) packet.nts = value;
+            else if (headerNameIs(line, nameLen, "CACHE-CONTROL")) packet.maxAge = parseMaxAge(value);
+            else if (headerNameIs(line, nameLen, "BOOTID.UPNP.ORG")) packet.bootId = parseNonNegative(value);
+            else if (headerNameIs(line, nameLen, "CONFIGID.UPNP.ORG")) packet.configId = parseNonNegative(value);
+        }
+
+        line = lineEnd + 1;
+    }
+
+    // ssdp:byebye carries no LOCATION, only the USN
+    return !packet.location.empty() || !packet.usn.empty();
+}
+
+HeaderView uuidFromUsn(const HeaderView& usn) {
+    HeaderView uuid;
+    if (!usn.startsWith("uuid:")) return uuid;
+    uuid.data = usn.data;
+    uuid.len = usn.len;
+    for (size_t i = 0; i + 1 < usn.len; i++) {
+        if (usn.data[i] == ':' && usn.data[i + 1] == ':') {
+            uuid.len = i;
+            break;
+        }
+    }
+    return uuid;
+}
+
+HeaderView hostFromLocation(const HeaderView& location) {
+    HeaderView host;
+    const char* end = location.data + location.len;
+    const char* cursor = location.data;
+    for (size_t i = 0; i + 2 < location.len; i++) {
+        if (location.data[i] == '/' && location.data[i + 1] == '/') {
+            cursor = location.data + i + 2;
+            break;
+        }
+    }
+    if (cursor == location.data) return host;
+
+    const char* hostEnd = cursor;
+    while (hostEnd < end && *hostEnd != ':' && *hostEnd != '/') hostEnd++;
+    host.data = cursor;
+    host.len = hostEnd - cursor;
+    return host;
+}
+
+uint16_t portFromLocation(const HeaderView& location) {
+    HeaderView host = hostFromLocation(location);
+    if (host.empty()) return 80;
+    const char* end = location.data + location.len;
+    const char* cursor = host.data + host.len;
+    if (cursor >= end || *cursor != ':') return 80;
+
+    uint32_t port = 0;
+    for (cursor++; cursor < end && isdigit(static_cast<unsigned char>(*cursor)); cursor++) {
+        port = port * 10 + (*cursor - '0');
+        if (port > 65535) return 80;
+    }
+    return port > 0 ? static_cast<uint16_t>(port) : 80;
+}
+
+HeaderView pathFromLocation(const HeaderView& location) {
+    HeaderView path;
+    HeaderView host = hostFromLocation(location);
+    if (host.empty()) return path;
+    const char* end = location.data + location.len;
+    const char* cursor = host.data + host.len;
+    while (cursor < end && *cursor != '/') cursor++;
+    path.data = cursor;
+    path.len = end - cursor;
+    return path;
+}
+
+bool equals(const HeaderView& view, const String& value) {
+    return view.len == value.length() && (view.len == 0 || memcmp(view.data, value.c_str(), view.len) == 0);
+}
+
+}  // namespace SonosSsdpParser
@@ -0,0 +1,44 @@
+#ifndef SONOS_SSDP_PARSER_H
+#define SONOS_SSDP_PARSER_H
+
+#include <Arduino.h>
+
+namespace SonosSsdpParser {
+
+// Non-owning view into a received datagram. Valid only while the packet buffer is.
+struct HeaderView {
+    const char* data = nullptr;
+    size_t len = 0;
+
+    bool empty() const { return len == 0; }
+    bool contains(const char* needle) const;
+    bool startsWith(const char* prefix) const;
+    String toString() const;
+};
+
+struct SsdpPacket {
+    bool isNotify = false;  // NOTIFY announcement rather than an M-SEARCH response
+    HeaderView location;
+    HeaderView usn;
+    HeaderView st;
+    HeaderView nt;
+    HeaderView nts;
+    int32_t maxAge = -1;  // CACHE-CONTROL max-age in seconds, -1 if absent
+    int32_t bootId = -1;
+    int32_t configId = -1;
+};
+
+bool parsePacket(const char* buffer, size_t len, SsdpPacket& packet);
+
+// "uuid:RINCON_xxx::urn:..." -> "uuid:RINCON_xxx" (matches the description's UDN).
+HeaderView uuidFromUsn(const HeaderView& usn);
+// "http://192.168.1.20:1400/xml/..." -> "192.168.1.20"
+HeaderView hostFromLocation(const HeaderView& location);
+// "http://192.168.1.20:1400/xml/..." -> 1400 (80 when absent) and "/xml/..."
+uint16_t portFromLocation(const HeaderView& location);
+HeaderView pathFromLocation(const HeaderView& location);
+bool equals(const HeaderView& view, const String& value);
+
+}  // namespace SonosSsdpParser
+
+#endif
@@ -439,4 +439,229 @@ bool parseInt(const String& value, int& parsed, String& error) {
     return true;
 }
 
+StreamingTagExtractor::StreamingTagExtractor(const char* const* tags, size_t tagCount, const char* stopTag, size_t maxValueLen)
+    : _tags(tags), _tagCount(tagCount < MAX_TAGS ? tagCount : MAX_TAGS), _stopTag(stopTag), _maxValueLen(maxValueLen) {}
+
+bool StreamingTagExtractor::allFound() const {
+    for (size_t i = 0; i < _tagCount; i++) {
+        if (!_found[i]) return false;
+    }
+    return true;
+}
+
+void StreamingTagExtractor::feed(const char* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        switch (_state) {
+            case State::TEXT:
+                if (c == '<') {
+                    if (_capture >= 0) {
+                        String raw = _values[_capture];
+                        raw.trim();
+                        _values[_capture] = decodeEntities(raw);
+                        _found[_capture] = true;
+                        _capture = -1;
+                    }
+                    _state = State::TAG_NAME;
+                    _nameLen = 0;
+                    _closing = false;
+                } else if (_capture >= 0 && _values[_capture].length() < _maxValueLen) {
+                    _values[_capture] += c;
+                }
+                break;
+
+            case State::TAG_NAME:
+                if (_nameLen == 0 && !_closing && (c == '?' || c == '!')) {
+                    _state = State::SKIP;
+                } else if (_nameLen == 0 && !_closing && c == '/') {
+                    _closing = true;
+                } else if (isNameChar(c)) {
+                    if (_nameLen < sizeof(_name) - 1) _name[_nameLen++] = c;
+                } else {
+                    endTagName();
+                    if (c == '>') endTag();
+                    else _state = State::IN_TAG;
+                }
+                break;
+
+            case State::IN_TAG:
+                if (c == '>') {
+                    if (_prevChar == '/') _pendingCapture = -1;  // Self-closing; nothing to capture
+                    endTag();
+                }
+                break;
+
+            case State::SKIP:
+                if (c == '>') _state = State::TEXT;
+                break;
+        }
+        _prevChar = c;
+    }
+}
+
+void StreamingTagExtractor::endTagName() {
+    _name[_nameLen] = '\0';
+    _pendingCapture = -1;
+    if (_closing || _nameLen == 0) return;
+
+    String name(_name);
+    if (_stopTag != nullptr && namesMatch(name, _stopTag)) {
+        _stopped = true;
+        return;
+    }
+    for (size_t i = 0; i < _tagCount; i++) {
+        if (!_found[i] && namesMatch(name, _tags[i])) {
+            _pendingCapture = static_cast<int>(i);
+            _values[i] = "";
+            return;
+        }
+    }
+}
+
+void StreamingTagExtractor::endTag() {
+    _capture = _pendingCapture;
+    _pendingCapture = -1;
+    _state = State::TEXT;
+}
+
+ZoneGroupStateParser::ZoneGroupStateParser(MemberCallback callback) : _callback(callback) {}
+
+void ZoneGroupStateParser::feed(const char* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        char c = data[i];
+        if (_entityLen < 0) {
+            if (c == '&') _entityLen = 0;
+            else feedChar(c);
+            continue;
+        }
+
+        if (c != ';') {
+            // Not an entity we decode; drop it rather than buffer an unbounded run
+            if (_entityLen < (int)sizeof(_entity) - 1) _entity[_entityLen++] = c;
+            else _entityLen = -1;
+            continue;
+        }
+
+        _entity[_entityLen] = '\0';
+        _entityLen = -1;
+        if (strcmp(_entity, "lt") == 0) feedChar('<');
+        else if (strcmp(_entity, "gt") == 0) feedChar('>');
+        else if (strcmp(_entity, "quot") == 0) feedChar('"');
+        else if (strcmp(_entity, "apos") == 0) feedChar('\'');
+        else if (strcmp(_entity, "amp") == 0) feedChar('&');
+    }
+}
+
+void ZoneGroupStateParser::feedChar(char c) {
+    switch (_state) {
+        case State::TEXT:
+            if (c == '<') {
+                _state = State::TAG_NAME;
+                _nameLen = 0;
+                _closing = false;
+            }
+            break;
+
+        case State::TAG_NAME:
+            if (_nameLen == 0 && !_closing && (c == '?' || c == '!')) {
+                _tag = Tag::OTHER;
+                _state = State::SKIP;
+            } else if (_nameLen == 0 && !_closing && c == '/') {
+                _closing = true;
+            } else if (isNameChar(c)) {
+                if (_nameLen < sizeof(_name) - 1) _name[_nameLen++] = c;
+            } else {
+                endTagName();
+                if (c == '>') endTag();
+                else _state = _tag == Tag::OTHER ? State::SKIP : State::IN_TAG;
+            }
+            break;
+
+        case State::IN_TAG:
+            if (c == '>') {
+                endTag();
+            } else if (isNameChar(c)) {
+                _nameLen = 0;
+                _name[_nameLen++] = c;
+                _state = State::ATTR_NAME;
+            }
+            break;
+
+        case State::ATTR_NAME:
+            if (isNameChar(c)) {
+                if (_nameLen < sizeof(_name) - 1) _name[_nameLen++] = c;
+            } else {
+                endAttrName();
+                _state = c == '=' ? State::ATTR_EQUALS : State::IN_TAG;
+                if (c == '>') endTag();
+            }
+            break;
+
+        case State::ATTR_EQUALS:
+            if (c == '"' || c == '\'') {
+                _quote = c;
+                _state = State::ATTR_VALUE;
+            }
+            break;
+
+        case State::ATTR_VALUE:
+            if (c == _quote) {
+                _attrTarget = nullptr;
+                _state = State::IN_TAG;
+            } else if (_attrTarget != nullptr && _attrTarget->length() < 128) {
+                *_attrTarget += c;
+            }
+            break;
+
+        case State::SKIP:
+            // Other elements are skipped whole; quoted attribute values may contain '>'
+            if (_quote != 0) {
+                if (c == _quote) _quote = 0;
+            } else if (c == '"' || c == '\'') {
+                _quote = c;
+            } else if (c == '>') {
+                _state = State::TEXT;
+            }
+            break;
+    }
+}
+
+void ZoneGroupStateParser::endTagName() {
+    _name[_nameLen] = '\0';
+    String name(_name);
+    _tag = Tag::OTHER;
+    _quote = 0;
+    if (namesMatch(name, "ZoneGroup")) {
+        if (_closing) {
+            _groupCoordinator = "";
+            return;
+        }
+        _tag = Tag::GROUP;
+        _coordinatorAttr = "";
+    } else if (!_closing && namesMatch(name, "ZoneGroupMember")) {
+        _tag = Tag::MEMBER;
+        _member = Member();
+    }
+}
+
+void ZoneGroupStateParser::endAttrName() {
+    _name[_nameLen] = '\0';
+    _attrTarget = nullptr;
+    if (_tag == Tag::GROUP && strcmp(_name, "Coordinator") == 0) _attrTarget = &_coordinatorAttr;
+    else if (_tag == Tag::MEMBER && strcmp(_name, "UUID") == 0) _attrTarget = &_member.uuid;
+    else if (_tag == Tag::MEMBER && strcmp(_name, "Location") == 0) _attrTarget = &_member.location;
+}
+
+void ZoneGroupStateParser::endTag() {
+    if (_tag == Tag::GROUP) {
+        _groupCoordinator = _coordinatorAttr;
+    } else if (_tag == Tag::MEMBER && _member.uuid.length() > 0) {
+        _member.coordinator = _groupCoordinator;
+        _memberCount++;
+        if (_callback) _callback(_member);
+    }
+    _tag = Tag::OTHER;
+    _state = State::TEXT;
+}
+
 }  // namespace SonosXmlParser
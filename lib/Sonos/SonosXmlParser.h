@@ -2,6 +2,7 @@
 #define SONOS_XML_PARSER_H
 
 #include <Arduino.h>
+#include <functional>
 
 namespace SonosXmlParser {
 
@@ -16,6 +17,86 @@ XmlLookupResult findAttributeValue(const String& xml, const String& tag, const S
 bool parseTimeToSeconds(const String& value, int& seconds, String& error);
 bool parseInt(const String& value, int& parsed, String& error);
 
+// Pulls the text of a few leaf elements out of a document fed in arbitrary chunks, without
+// buffering the document. Values are trimmed and entity-decoded. Nested markup inside a
+// wanted element is not supported. Seeing stopTag open marks the extraction as stopped so
+// callers can abandon the rest of the stream.
+class StreamingTagExtractor {
+public:
+    static const size_t MAX_TAGS = 4;
+
+    StreamingTagExtractor(const char* const* tags, size_t tagCount, const char* stopTag = nullptr, size_t maxValueLen = 128);
+
+    void feed(const char* data, size_t len);
+    bool found(size_t index) const { return index < _tagCount && _found[index]; }
+    const String& value(size_t index) const { return _values[index < _tagCount ? index : 0]; }
+    bool allFound() const;
+    bool stopped() const { return _stopped; }
+
+private:
+    enum class State : uint8_t { TEXT, TAG_NAME, IN_TAG, SKIP };
+
+    const char* const* _tags;
+    size_t _tagCount;
+    const char* _stopTag;
+    size_t _maxValueLen;
+    bool _found[MAX_TAGS] = {};
+    String _values[MAX_TAGS];
+    State _state = State::TEXT;
+    char _name[32];
+    size_t _nameLen = 0;
+    bool _closing = false;
+    char _prevChar = 0;
+    int _pendingCapture = -1;
+    int _capture = -1;
+    bool _stopped = false;
+
+    void endTagName();
+    void endTag();
+};
+
+// Walks a ZoneGroupState document fed in arbitrary chunks and reports every <ZoneGroupMember>
+// with its group's coordinator. The document may arrive raw or entity-escaped once, as it does
+// inside a GetZoneGroupState response or a ZoneGroupTopology event.
+class ZoneGroupStateParser {
+public:
+    struct Member {
+        String uuid;         // RINCON_...
+        String location;     // Description URL; carries the member's IP
+        String coordinator;  // UUID of the group coordinator
+    };
+    typedef std::function<void(const Member&)> MemberCallback;
+
+    explicit ZoneGroupStateParser(MemberCallback callback);
+
+    void feed(const char* data, size_t len);
+    size_t memberCount() const { return _memberCount; }
+
+private:
+    enum class State : uint8_t { TEXT, TAG_NAME, IN_TAG, ATTR_NAME, ATTR_EQUALS, ATTR_VALUE, SKIP };
+    enum class Tag : uint8_t { OTHER, GROUP, MEMBER };
+
+    MemberCallback _callback;
+    State _state = State::TEXT;
+    Tag _tag = Tag::OTHER;
+    char _entity[8];
+    int _entityLen = -1;  // -1 when not inside an entity reference
+    char _name[24];
+    size_t _nameLen = 0;
+    bool _closing = false;
+    char _quote = 0;
+    String* _attrTarget = nullptr;
+    String _groupCoordinator;
+    String _coordinatorAttr;
+    Member _member;
+    size_t _memberCount = 0;
+
+    void feedChar(char c);
+    void endTagName();
+    void endAttrName();
+    void endTag();
+};
+
 }  // namespace SonosXmlParser
 
 #endif
@@ -0,0 +1,347 @@
+#include "ArtCache.h"
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include "AppLogger.h"
+
+namespace {
+
+const char* ART_DIR = "/art";
+const char* INDEX_FILE = "/art/index.bin";
+const char* INDEX_TEMP_FILE = "/art/index.tmp";
+const uint32_t ART_MAGIC = 0x54524153;    // "SART" little-endian
+const uint32_t INDEX_MAGIC = 0x58444941;  // "AIDX" little-endian
+const uint16_t INDEX_VERSION = 2;  // 2: art scaled to fit the art box exactly
+const uint16_t MAX_ART_EDGE = 240;
+
+enum ArtEncoding : uint8_t { ENCODING_RAW = 0, ENCODING_RLE = 1 };
+
+struct ArtHeader {
+    uint32_t magic;
+    uint16_t width;
+    uint16_t height;
+    uint8_t encoding;
+    uint8_t reserved[3];
+    uint32_t payloadBytes;
+    uint32_t crc;  // CRC32 of the payload
+};
+
+struct IndexHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t useClock;
+    uint32_t crc;  // CRC32 of the entries
+};
+
+static_assert(sizeof(ArtHeader) == 20, "art header layout changed");
+static_assert(sizeof(IndexHeader) == 16, "art index header layout changed");
+
+// PackBits over 16-bit pixels, one row at a time: a control byte with the high bit set repeats
+// the next pixel (control & 0x7F) + 1 times; otherwise control + 1 literal pixels follow.
+void encodeRow(const uint16_t* pixels, uint16_t width, std::vector<uint8_t>& out) {
+    auto putPixel = [&out](uint16_t pixel) {
+        out.push_back(pixel & 0xFF);
+        out.push_back(pixel >> 8);
+    };
+    auto runAt = [pixels, width](uint16_t i) {
+        uint16_t run = 1;
+        while (i + run < width && run < 128 && pixels[i + run] == pixels[i]) run++;
+        return run;
+    };
+
+    uint16_t i = 0;
+    while (i < width) {
+        uint16_t run = runAt(i);
+        if (run >= 3) {
+            out.push_back(0x80 | (run - 1));
+            putPixel(pixels[i]);
+            i += run;
+            continue;
+        }
+
+        uint16_t start = i;
+        uint16_t count = 0;
+        while (i < width && count < 128 && (count == 0 || runAt(i) < 3)) {
+            i++;
+            count++;
+        }
+        out.push_back(count - 1);
+        for (uint16_t p = start; p < start + count; p++) putPixel(pixels[p]);
+    }
+}
+
+bool decodeRow(const uint8_t*& cursor, const uint8_t* end, uint16_t* row, uint16_t width) {
+    uint16_t filled = 0;
+    while (filled < width) {
+        if (cursor >= end) return false;
+        uint8_t control = *cursor++;
+        uint16_t count = (control & 0x7F) + 1;
+        if (filled + count > width) return false;
+        if (control & 0x80) {
+            if (cursor + 2 > end) return false;
+            uint16_t pixel = cursor[0] | (cursor[1] << 8);
+            cursor += 2;
+            for (uint16_t i = 0; i < count; i++) row[filled++] = pixel;
+        } else {
+            if (cursor + count * 2 > end) return false;
+            for (uint16_t i = 0; i < count; i++, cursor += 2) row[filled++] = cursor[0] | (cursor[1] << 8);
+        }
+    }
+    return true;
+}
+
+// Without an index nothing on flash can be accounted for, so every file in the directory goes
+void removeAllArt() {
+    File dir = LittleFS.open(ART_DIR);
+    if (!dir || !dir.isDirectory()) return;
+    std::vector<String> paths;
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) {
+        paths.push_back(file.path());
+        file.close();
+    }
+    dir.close();
+    for (const auto& path : paths) LittleFS.remove(path);
+    if (!paths.empty()) LOG_INFO("image", "Art cache cleared " + String(paths.size()) + " files without an index");
+}
+
+}  // namespace
+
+bool ArtCache::begin(size_t budgetBytes) {
+    _budgetBytes = budgetBytes;
+    if (!LittleFS.exists(ART_DIR) && !LittleFS.mkdir(ART_DIR)) {
+        LOG_WARN("image", "Art cache unavailable: cannot create " + String(ART_DIR));
+        return false;
+    }
+    _ready = true;
+
+    unsigned long start = micros();
+    File file = LittleFS.open(INDEX_FILE, "r");
+    if (!file) {
+        removeAllArt();
+        return true;
+    }
+
+    IndexHeader header;
+    bool ok = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+              header.magic == INDEX_MAGIC && header.version == INDEX_VERSION && header.count <= 1024;
+    if (ok) {
+        _entries.resize(header.count);
+        size_t expected = header.count * sizeof(Entry);
+        ok = file.read(reinterpret_cast<uint8_t*>(_entries.data()), expected) == expected &&
+             esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(_entries.data()), expected) == header.crc;
+    }
+    file.close();
+
+    if (!ok) {
+        _entries.clear();
+        LOG_WARN("image", "Art cache index invalid; starting empty");
+        removeAllArt();
+        return true;
+    }
+
+    _useClock = header.useClock;
+    for (const auto& entry : _entries) _totalBytes += entry.bytes;
+    LOG_INFO("image", "Art cache index: " + String(_entries.size()) + " entries, " + String(_totalBytes) + " of " +
+             String(_budgetBytes) + " bytes, loaded in " + String(micros() - start) + " us");
+    return true;
+}
+
+bool ArtCache::load(const String& url, const SizeCallback& onSize, const RowCallback& onRow) {
+    if (!_ready) return false;
+    uint32_t hash = hashUrl(url);
+    Entry* entry = findEntry(hash);
+    if (entry == nullptr) {
+        _misses++;
+        return false;
+    }
+
+    File file = LittleFS.open(pathFor(hash), "r");
+    ArtHeader header;
+    bool ok = file && file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+              header.magic == ART_MAGIC && header.width > 0 && header.height > 0 &&
+              header.width <= MAX_ART_EDGE && header.height <= MAX_ART_EDGE &&
+              header.payloadBytes == entry->bytes - sizeof(ArtHeader) &&
+              (header.encoding == ENCODING_RLE ||
+               (header.encoding == ENCODING_RAW && header.payloadBytes == (uint32_t)header.width * header.height * 2));
+    std::vector<uint8_t> payload;
+    if (ok) {
+        payload.resize(header.payloadBytes);
+        ok = file.read(payload.data(), payload.size()) == payload.size() &&
+             esp_rom_crc32_le(0, payload.data(), payload.size()) == header.crc;
+    }
+    if (file) file.close();
+
+    if (ok && !onSize(header.width, header.height)) return false;
+
+    std::vector<uint16_t> row(header.width);
+    const uint8_t* cursor = payload.data();
+    const uint8_t* end = cursor + payload.size();
+    for (uint16_t y = 0; ok && y < header.height; y++) {
+        if (header.encoding == ENCODING_RLE) {
+            ok = decodeRow(cursor, end, row.data(), header.width);
+            if (!ok) break;
+        } else {
+            memcpy(row.data(), cursor + (size_t)y * header.width * 2, header.width * 2);
+        }
+        onRow(y, row.data());
+    }
+    if (!ok) {
+        // The caller discards whatever rows it was given
+        LOG_WARN("image", "Art cache entry damaged; dropping it");
+        removeEntry(hash);
+        _misses++;
+        return false;
+    }
+
+    entry->lastUse = ++_useClock;
+    _indexDirty = true;
+    _hits++;
+    return true;
+}
+
+bool ArtCache::store(const String& url, const uint16_t* pixels, uint16_t width, uint16_t height) {
+    if (!_ready || pixels == nullptr || width == 0 || height == 0 || width > MAX_ART_EDGE || height > MAX_ART_EDGE) {
+        return false;
+    }
+
+    size_t rawBytes = (size_t)width * height * 2;
+    std::vector<uint8_t> payload;
+    payload.reserve(rawBytes);
+    for (uint16_t y = 0; y < height && payload.size() < rawBytes; y++) {
+        encodeRow(pixels + (size_t)y * width, width, payload);
+    }
+    uint8_t encoding = ENCODING_RLE;
+    if (payload.size() >= rawBytes) {
+        // Photographic art rarely compresses; keep it raw so loads are a plain copy
+        payload.assign(reinterpret_cast<const uint8_t*>(pixels), reinterpret_cast<const uint8_t*>(pixels) + rawBytes);
+        encoding = ENCODING_RAW;
+    }
+
+    ArtHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = ART_MAGIC;
+    header.width = width;
+    header.height = height;
+    header.encoding = encoding;
+    header.payloadBytes = payload.size();
+    header.crc = esp_rom_crc32_le(0, payload.data(), payload.size());
+
+    uint32_t hash = hashUrl(url);
+    uint32_t bytes = sizeof(header) + payload.size();
+    removeEntry(hash);
+    while (!_entries.empty() && _totalBytes + bytes > _budgetBytes) {
+        size_t oldest = 0;
+        for (size_t i = 1; i < _entries.size(); i++) {
+            if (_entries[i].lastUse < _entries[oldest].lastUse) oldest = i;
+        }
+        LOG_DEBUG("image", "Art cache evicting " + pathFor(_entries[oldest].hash));
+        removeEntry(_entries[oldest].hash);
+    }
+    if (bytes > _budgetBytes) return false;
+
+    File file = LittleFS.open(pathFor(hash), "w");
+    if (!file) return false;
+    size_t written = file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    written += file.write(payload.data(), payload.size());
+    file.close();
+    if (written != bytes) {
+        LittleFS.remove(pathFor(hash));
+        LOG_WARN("image", "Failed to write art cache entry");
+        return false;
+    }
+
+    Entry entry;
+    entry.hash = hash;
+    entry.bytes = bytes;
+    entry.lastUse = ++_useClock;
+    _entries.push_back(entry);
+    _totalBytes += bytes;
+    saveIndex();
+
+    LOG_DEBUG("image", "Cached art " + String(width) + "x" + String(height) + " as " + String(bytes) + " bytes (" +
+              (encoding == ENCODING_RLE ? "RLE" : "raw") + "); cache " + String(_totalBytes) + "/" + String(_budgetBytes));
+    return true;
+}
+
+void ArtCache::update() {
+    if (!_indexDirty || millis() - _lastIndexFlushMs < INDEX_FLUSH_INTERVAL_MS) return;
+    saveIndex();
+}
+
+String ArtCache::normalizeUrl(const String& url) {
+    String normalized = url;
+    normalized.replace("&amp;", "&");
+
+    // Speaker-served art (/getaa?...) is the same image whichever speaker's IP is in the URL
+    int getaa = normalized.indexOf("/getaa?");
+    if (getaa >= 0) return normalized.substring(getaa);
+
+    int schemeEnd = normalized.indexOf("://");
+    int hostEnd = schemeEnd >= 0 ? normalized.indexOf('/', schemeEnd + 3) : -1;
+    if (hostEnd < 0) hostEnd = normalized.length();
+    String origin = normalized.substring(0, hostEnd);
+    origin.toLowerCase();
+    return origin + normalized.substring(hostEnd);
+}
+
+uint32_t ArtCache::hashUrl(const String& url) {
+    // FNV-1a
+    String normalized = normalizeUrl(url);
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < normalized.length(); i++) {
+        hash ^= (uint8_t)normalized[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+String ArtCache::pathFor(uint32_t hash) {
+    char path[20];
+    snprintf(path, sizeof(path), "/art/%08lx.bin", (unsigned long)hash);
+    return String(path);
+}
+
+ArtCache::Entry* ArtCache::findEntry(uint32_t hash) {
+    for (auto& entry : _entries) {
+        if (entry.hash == hash) return &entry;
+    }
+    return nullptr;
+}
+
+void ArtCache::removeEntry(uint32_t hash) {
+    for (size_t i = 0; i < _entries.size(); i++) {
+        if (_entries[i].hash != hash) continue;
+        _totalBytes -= _entries[i].bytes;
+        _entries[i] = _entries.back();
+        _entries.pop_back();
+        LittleFS.remove(pathFor(hash));
+        _indexDirty = true;
+        return;
+    }
+}
+
+bool ArtCache::saveIndex() {
+    IndexHeader header;
+    header.magic = INDEX_MAGIC;
+    header.version = INDEX_VERSION;
+    header.count = _entries.size();
+    header.useClock = _useClock;
+    header.crc = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(_entries.data()), _entries.size() * sizeof(Entry));
+
+    _indexDirty = false;
+    _lastIndexFlushMs = millis();
+
+    // Written beside the live index and renamed over it, so power loss never leaves half an index
+    File file = LittleFS.open(INDEX_TEMP_FILE, "w");
+    if (!file) return false;
+    size_t expected = sizeof(header) + _entries.size() * sizeof(Entry);
+    size_t written = file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    written += file.write(reinterpret_cast<const uint8_t*>(_entries.data()), _entries.size() * sizeof(Entry));
+    file.close();
+    if (written != expected || !LittleFS.rename(INDEX_TEMP_FILE, INDEX_FILE)) {
+        LittleFS.remove(INDEX_TEMP_FILE);
+        LOG_WARN("image", "Failed to write art cache index");
+        return false;
+    }
+    return true;
+}
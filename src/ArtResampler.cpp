@@ -0,0 +1,115 @@
+#include "ArtResampler.h"
+#include "PixelKernels.h"
+
+namespace {
+
+// Beyond this reduction per axis the 32-bit accumulators could overflow
+const uint32_t MAX_STEP = 64u << 16;
+
+}  // namespace
+
+void ArtResampler::fitToBox(uint16_t srcW, uint16_t srcH, uint16_t boxW, uint16_t boxH, uint16_t& dstW,
+                            uint16_t& dstH) {
+    if ((uint32_t)srcW * boxH >= (uint32_t)srcH * boxW) {
+        dstW = boxW;
+        dstH = max<uint32_t>(1, (uint32_t)srcH * boxW / srcW);
+    } else {
+        dstH = boxH;
+        dstW = max<uint32_t>(1, (uint32_t)srcW * boxH / srcH);
+    }
+}
+
+uint8_t ArtResampler::decodeScale(uint16_t srcW, uint16_t srcH, uint16_t dstW, uint16_t dstH, uint8_t maxScale) {
+    for (uint8_t scale = maxScale; scale > 0; scale--) {
+        if ((srcW >> scale) >= dstW && (srcH >> scale) >= dstH) return scale;
+    }
+    return 0;
+}
+
+bool ArtResampler::begin(uint16_t srcW, uint16_t srcH, uint16_t dstW, uint16_t dstH, RowSink sink) {
+    if (srcW == 0 || srcH == 0 || dstW == 0 || dstH == 0) return false;
+    _srcW = srcW;
+    _srcH = srcH;
+    _dstW = dstW;
+    _dstH = dstH;
+    _stepX = ((uint32_t)srcW << 16) / dstW;
+    _stepY = ((uint32_t)srcH << 16) / dstH;
+    if (_stepX < 256 || _stepY < 256 || _stepX > MAX_STEP || _stepY > MAX_STEP) return false;
+    _srcRow = 0;
+    _dstRow = 0;
+    _sink = sink;
+    _rowSums.assign(dstW * 3, 0);
+    _columns.assign(dstW * 3, 0);
+    _columnWeight = 0;
+    _out.assign(dstW, 0);
+    // Same rounding as the area average, so this only changes speed
+    _halving = srcW == dstW * 2 && srcH == dstH * 2;
+    if (_halving) _pendingRow.assign(srcW, 0);
+    return true;
+}
+
+void ArtResampler::pushRow(const uint16_t* pixels) {
+    if (finished() || _srcRow >= _srcH) return;
+    if (_halving) {
+        if (_srcRow++ % 2 == 0) {
+            memcpy(_pendingRow.data(), pixels, _srcW * sizeof(uint16_t));
+        } else {
+            halveRgb565(_pendingRow.data(), pixels, _out.data(), _dstW);
+            _sink(_dstRow++, _out.data());
+        }
+        return;
+    }
+    averageRow(pixels);
+
+    // This source row spans [pos, end) in 16.16; it may close one destination row and start the next
+    uint32_t pos = _srcRow << 16;
+    uint32_t end = pos + 0x10000;
+    while (pos < end && !finished()) {
+        uint32_t rowEnd = (uint32_t)(_dstRow + 1) * _stepY;
+        uint32_t segmentEnd = min(end, rowEnd);
+        uint32_t weight = (segmentEnd >> 8) - (pos >> 8);
+        if (weight > 0) {
+            for (size_t i = 0; i < _columns.size(); i++) _columns[i] += (uint32_t)_rowSums[i] * weight;
+            _columnWeight += weight;
+        }
+        pos = segmentEnd;
+        if (segmentEnd == rowEnd) emitRow();
+    }
+    _srcRow++;
+}
+
+// Each destination pixel covers [x * step, (x + 1) * step) of the row; edge pixels count by their overlap
+void ArtResampler::averageRow(const uint16_t* pixels) {
+    uint32_t divisor = _stepX >> 8;
+    for (uint16_t x = 0; x < _dstW; x++) {
+        uint32_t start = x * _stepX;
+        uint32_t end = start + _stepX;
+        uint32_t last = min<uint32_t>((end - 1) >> 16, _srcW - 1);
+        uint32_t r = 0, g = 0, b = 0;
+        for (uint32_t i = start >> 16; i <= last; i++) {
+            uint32_t weight = min(end, (i + 1) << 16) - max(start, i << 16);
+            uint16_t pixel = pixels[i];
+            r += (pixel >> 11) * weight;
+            g += ((pixel >> 5) & 0x3F) * weight;
+            b += (pixel & 0x1F) * weight;
+        }
+        _rowSums[x * 3] = r / divisor;
+        _rowSums[x * 3 + 1] = g / divisor;
+        _rowSums[x * 3 + 2] = b / divisor;
+    }
+}
+
+void ArtResampler::emitRow() {
+    uint32_t weight = max<uint32_t>(_columnWeight, 1);
+    uint32_t half = weight * 128;
+    for (uint16_t x = 0; x < _dstW; x++) {
+        uint32_t r = min<uint32_t>((_columns[x * 3] + half) / weight >> 8, 0x1F);
+        uint32_t g = min<uint32_t>((_columns[x * 3 + 1] + half) / weight >> 8, 0x3F);
+        uint32_t b = min<uint32_t>((_columns[x * 3 + 2] + half) / weight >> 8, 0x1F);
+        _out[x] = (r << 11) | (g << 5) | b;
+    }
+    _sink(_dstRow, _out.data());
+    _dstRow++;
+    std::fill(_columns.begin(), _columns.end(), 0);
+    _columnWeight = 0;
+}
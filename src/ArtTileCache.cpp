@@ -0,0 +1,102 @@
+#include "ArtTileCache.h"
+#include <esp_heap_caps.h>
+#include "ArtCache.h"
+#include "AppLogger.h"
+
+ArtTileCache::~ArtTileCache() {
+    clear();
+}
+
+bool ArtTileCache::begin(size_t budgetBytes) {
+    size_t freePsram = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    if (freePsram == 0) {
+        LOG_WARN("image", "No PSRAM; decoded art tile cache disabled");
+        _budgetBytes = 0;
+        return false;
+    }
+    // Leave PSRAM headroom for TLS and JPEG buffers that spill out of internal RAM
+    _budgetBytes = min(budgetBytes, freePsram / 2);
+    LOG_INFO("image", "Art tile cache: " + String(_budgetBytes / 1024) + " KB budget of " + String(freePsram / 1024) +
+             " KB free PSRAM");
+    return true;
+}
+
+const ArtTileCache::Tile* ArtTileCache::get(const String& url) {
+    Tile* tile = find(url);
+    if (tile == nullptr) {
+        _misses++;
+        return nullptr;
+    }
+    tile->lastUse = ++_useClock;
+    _hits++;
+    return tile;
+}
+
+bool ArtTileCache::contains(const String& url) const {
+    String key = ArtCache::normalizeUrl(url);
+    for (const auto& tile : _tiles) {
+        if (tile.url == key) return true;
+    }
+    return false;
+}
+
+bool ArtTileCache::put(const String& url, const uint16_t* pixels, uint16_t width, uint16_t height) {
+    size_t bytes = (size_t)width * height * sizeof(uint16_t);
+    if (pixels == nullptr || bytes == 0 || bytes > _budgetBytes) return false;
+
+    String key = ArtCache::normalizeUrl(url);
+    for (size_t i = 0; i < _tiles.size(); i++) {
+        if (_tiles[i].url == key) {
+            release(i);
+            break;
+        }
+    }
+    while (!_tiles.empty() && _usedBytes + bytes > _budgetBytes) evictOldest();
+
+    uint16_t* copy = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    while (copy == nullptr && !_tiles.empty()) {
+        // Fragmented or shared with other PSRAM users; make room and retry
+        evictOldest();
+        copy = (uint16_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    }
+    if (copy == nullptr) return false;
+    memcpy(copy, pixels, bytes);
+
+    Tile tile;
+    tile.url = key;
+    tile.pixels = copy;
+    tile.width = width;
+    tile.height = height;
+    tile.lastUse = ++_useClock;
+    _tiles.push_back(tile);
+    _usedBytes += bytes;
+    return true;
+}
+
+void ArtTileCache::clear() {
+    while (!_tiles.empty()) release(_tiles.size() - 1);
+}
+
+ArtTileCache::Tile* ArtTileCache::find(const String& url) {
+    String key = ArtCache::normalizeUrl(url);
+    for (auto& tile : _tiles) {
+        if (tile.url == key) return &tile;
+    }
+    return nullptr;
+}
+
+void ArtTileCache::evictOldest() {
+    size_t oldest = 0;
+    for (size_t i = 1; i < _tiles.size(); i++) {
+        if (_tiles[i].lastUse < _tiles[oldest].lastUse) oldest = i;
+    }
+    release(oldest);
+    _evictions++;
+}
+
+void ArtTileCache::release(size_t index) {
+    _usedBytes -= tileBytes(_tiles[index]);
+    heap_caps_free(_tiles[index].pixels);
+    _tiles[index] = _tiles.back();
+    _tiles.pop_back();
+}
@@ -0,0 +1,444 @@
+#include "ArtWorker.h"
+#include <HTTPClient.h>
+#include <TJpg_Decoder.h>
+#include <esp_heap_caps.h>
+#include "HttpBodyReader.h"
+#include "ArtResampler.h"
+#include "PngDecoder.h"
+#include "AppLogger.h"
+
+namespace {
+
+const uint16_t MAX_TILE_EDGE = 240;
+const uint8_t PREVIEW_SCALE = 3;  // 1/8: tjpgd only needs the DC coefficient of each block
+const size_t MAX_SPOOL_BYTES = 512 * 1024;
+// A download that completes within this goes straight to the full decode; a preview would only delay it
+const unsigned long PREVIEW_BUDGET_MS = 200;
+const size_t SPOOL_READ_BYTES = 1024;
+
+// The compressed body, copied to PSRAM as it downloads so the full pass can decode it again
+// without the network
+struct Spool {
+    uint8_t* data = nullptr;
+    size_t size = 0;
+    size_t capacity = 0;
+
+    ~Spool() { heap_caps_free(data); }
+    bool allocate(size_t bytes) {
+        data = (uint8_t*)heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+        capacity = data != nullptr ? bytes : 0;
+        return data != nullptr;
+    }
+};
+
+}  // namespace
+
+// Passed to tjpgd as its device pointer, so the callbacks need no shared state
+struct ArtDecodeContext {
+    HttpBodyReader* body;  // Null while replaying the spool
+    Spool* spool;          // Null when not spooling
+    size_t spoolPos;       // Next spooled byte for the decoder; past the end, reads continue from the body
+    uint8_t prefix[8];     // Read to sniff the format, then handed to the decoder first
+    size_t prefixLen;
+    size_t prefixPos;
+    std::function<bool()> cancelled;
+    ArtResampler resampler;
+    std::vector<uint16_t> band;  // One MCU row of the decoded image, at the decode scale
+    uint16_t decodedWidth;
+};
+
+namespace {
+
+// A null buffer skips bytes, as tjpgd asks for
+size_t readSource(ArtDecodeContext& context, uint8_t* buf, size_t len) {
+    Spool* spool = context.spool;
+    size_t n = 0;
+    if (spool != nullptr) {
+        n = min(len, spool->size - context.spoolPos);
+        if (buf != nullptr) memcpy(buf, &spool->data[context.spoolPos], n);
+        context.spoolPos += n;
+    }
+    if (n == len || context.body == nullptr) return n;
+    if (buf != nullptr) buf += n;
+    len -= n;
+    if (spool == nullptr) return n + context.body->read(buf, len);
+    // Caught up with the download; the rest is spooled as it passes through. tjpgd reads in 512-byte
+    // pieces, so the last one usually asks past the body; only what is left of the spool goes into it
+    size_t take = min(len, spool->capacity - spool->size);
+    size_t got = context.body->read(&spool->data[spool->size], take);
+    if (buf != nullptr) memcpy(buf, &spool->data[spool->size], got);
+    spool->size += got;
+    context.spoolPos += got;
+    n += got;
+    if (got < take || take == len) return n;
+    return n + context.body->read(buf != nullptr ? buf + got : nullptr, len - take);
+}
+
+// Downloads ahead of the decoder until the body is in the spool or the budget runs out; true when complete
+bool spoolAhead(ArtDecodeContext& context, unsigned long budgetMs) {
+    Spool* spool = context.spool;
+    unsigned long start = millis();
+    while (spool->size < spool->capacity && millis() - start < budgetMs && !context.cancelled()) {
+        size_t want = min(SPOOL_READ_BYTES, spool->capacity - spool->size);
+        size_t got = context.body->read(&spool->data[spool->size], want);
+        spool->size += got;
+        if (got < want) break;
+    }
+    return spool->size == spool->capacity;
+}
+
+size_t readBody(ArtDecodeContext& context, uint8_t* buf, size_t len) {
+    if (context.cancelled()) return 0;
+    size_t n = min(len, context.prefixLen - context.prefixPos);
+    if (buf != nullptr) memcpy(buf, &context.prefix[context.prefixPos], n);
+    context.prefixPos += n;
+    if (n < len) n += readSource(context, buf != nullptr ? buf + n : nullptr, len - n);
+    return n;
+}
+
+size_t jpegInput(JDEC* jdec, uint8_t* buf, size_t len) {
+    return readBody(*static_cast<ArtDecodeContext*>(jdec->device), buf, len);
+}
+
+// Returning 0 makes jd_decomp stop with JDR_INTR
+int jpegOutput(JDEC* jdec, void* bitmap, JRECT* rect) {
+    ArtDecodeContext& context = *static_cast<ArtDecodeContext*>(jdec->device);
+    if (context.cancelled()) return 0;
+    const uint16_t* src = static_cast<const uint16_t*>(bitmap);
+    int w = rect->right - rect->left + 1;
+    int rows = rect->bottom - rect->top + 1;
+    if (rect->right >= context.decodedWidth || (size_t)rows * context.decodedWidth > context.band.size()) return 0;
+    for (int y = 0; y < rows; y++) {
+        memcpy(&context.band[y * context.decodedWidth + rect->left], &src[y * w], w * sizeof(uint16_t));
+    }
+    // The last block of an MCU row completes the band; hand its rows to the resampler
+    if (rect->right + 1 >= context.decodedWidth) {
+        for (int y = 0; y < rows; y++) context.resampler.pushRow(&context.band[y * context.decodedWidth]);
+    }
+    return 1;
+}
+
+bool allocateImage(ArtImage& image, uint16_t width, uint16_t height) {
+    if (width == 0 || height == 0 || width > MAX_TILE_EDGE || height > MAX_TILE_EDGE) return false;
+    image.pixels = (uint16_t*)malloc((size_t)width * height * sizeof(uint16_t));
+    image.width = width;
+    image.height = height;
+    return image.pixels != nullptr;
+}
+
+void freeImage(ArtImage& image) {
+    free(image.pixels);
+    image.pixels = nullptr;
+}
+
+// Decodes at a power-of-two scale and area-averages into an image of exactly width x height
+JRESULT decodeScaled(JDEC& jdec, ArtDecodeContext& context, uint8_t scale, ArtImage& image, uint16_t width,
+                     uint16_t height) {
+    context.decodedWidth = jdec.width >> scale;
+    uint16_t bandRows = max(1, (jdec.msy * 8) >> scale);
+    context.band.resize((size_t)context.decodedWidth * bandRows);
+    ArtImage* target = &image;
+    bool ready = allocateImage(image, width, height) &&
+                 context.resampler.begin(context.decodedWidth, jdec.height >> scale, width, height,
+                     [target](uint16_t row, const uint16_t* pixels) {
+                         memcpy(&target->pixels[row * target->width], pixels, target->width * sizeof(uint16_t));
+                     });
+    if (!ready) return JDR_MEM1;
+    JRESULT result = jd_decomp(&jdec, jpegOutput, scale);
+    if (result == JDR_OK && !context.resampler.finished()) result = JDR_FMT1;
+    return result;
+}
+
+}  // namespace
+
+bool ArtWorker::begin(BaseType_t core) {
+    // Arduino's loop() runs on core 1; art gets the other one
+    BaseType_t created = xTaskCreatePinnedToCore(taskEntry, "art", STACK_BYTES, this, 1, &_task, core);
+    if (created != pdPASS) {
+        LOG_ERROR("image", "Failed to start art worker task");
+        _task = nullptr;
+        return false;
+    }
+    LOG_INFO("image", "Art worker running on core " + String((int)core));
+    return true;
+}
+
+void ArtWorker::request(const String& url, Purpose purpose) {
+    unsigned long now = millis();
+    unsigned long startAfterMs = now;
+    if (purpose == Purpose::Display) {
+        // Back-to-back track changes wait to settle, so skipping through covers fetches only the last one
+        if (_lastDisplayRequestMs != 0 && now - _lastDisplayRequestMs < SETTLE_MS) startAfterMs = now + SETTLE_MS;
+        _lastDisplayRequestMs = now;
+    }
+    uint32_t generation = ++_generation[(int)purpose];
+    Job* job = new Job{url, purpose, now, startAfterMs, generation};
+    delete _pending[(int)purpose].exchange(job);
+    if (_task != nullptr) xTaskNotifyGive(_task);
+}
+
+ArtWorker::Result* ArtWorker::takeResult() {
+    Result* result = _ready[(int)Purpose::Display].exchange(nullptr);
+    if (result == nullptr) result = _ready[(int)Purpose::Prefetch].exchange(nullptr);
+    return result;
+}
+
+void ArtWorker::release(Result* result) {
+    if (result == nullptr) return;
+    freeImage(result->image);
+    delete result;
+}
+
+void ArtWorker::taskEntry(void* arg) {
+    static_cast<ArtWorker*>(arg)->run();
+}
+
+void ArtWorker::run() {
+    while (true) {
+        Job* job = _pending[(int)Purpose::Display].exchange(nullptr);
+        if (job == nullptr) job = _pending[(int)Purpose::Prefetch].exchange(nullptr);
+        if (job == nullptr) {
+            // The flash cache is only touched from this task, including its periodic index flush
+            _cache.update();
+            _connections.closeIdle();
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(IDLE_WAKE_MS));
+            continue;
+        }
+
+        long settleMs = (long)(job->startAfterMs - millis());
+        if (settleMs > 0) {
+            // Put the job back unless a newer one already took its slot, then sleep out the delay
+            Job* expected = nullptr;
+            if (!_pending[(int)job->purpose].compare_exchange_strong(expected, job)) delete job;
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(settleMs));
+            continue;
+        }
+
+        Result* result = new Result();
+        result->image.url = job->url;
+        result->purpose = job->purpose;
+        result->requestedMs = job->requestedMs;
+        result->source = "flash";
+        result->ok = !superseded(*job) && loadFromFlash(job->url, result->image);
+        if (!result->ok && !superseded(*job)) {
+            result->source = "network";
+            result->ok = fetch(*job, result->image);
+            if (result->ok) _cache.store(job->url, result->image.pixels, result->image.width, result->image.height);
+        }
+        if (!result->ok) freeImage(result->image);
+        result->finishedMs = millis();
+
+        // Only the latest request is ever published; anything overtaken mid-flight is dropped
+        bool stale = superseded(*job);
+        delete job;
+        if (stale) {
+            uint32_t cancelled = ++_cancelled;
+            LOG_DEBUG("image", "Dropped superseded " + String(result->purpose == Purpose::Display ? "display" : "prefetch") +
+                      " art after " + String(result->finishedMs - result->requestedMs) + " ms (" + String(cancelled) +
+                      " cancelled so far)");
+            release(result);
+            continue;
+        }
+
+        LOG_DEBUG("image", String(result->purpose == Purpose::Display ? "Display" : "Prefetch") + " art from " +
+                  result->source + (result->ok ? "" : " failed") + " after " +
+                  String(result->finishedMs - result->requestedMs) + " ms on core " + String((int)xPortGetCoreID()));
+        release(_ready[(int)result->purpose].exchange(result));
+    }
+}
+
+bool ArtWorker::loadFromFlash(const String& url, ArtImage& image) {
+    bool loaded = _cache.load(url,
+        [&image](uint16_t w, uint16_t h) { return allocateImage(image, w, h); },
+        [&image](uint16_t row, const uint16_t* pixels) {
+            memcpy(&image.pixels[row * image.width], pixels, image.width * sizeof(uint16_t));
+        });
+    if (!loaded) freeImage(image);
+    return loaded;
+}
+
+bool ArtWorker::superseded(const Job& job) const {
+    if (_generation[(int)job.purpose].load() != job.generation) return true;
+    // Prefetching yields to a track change that is waiting for its art
+    return job.purpose == Purpose::Prefetch && _pending[(int)Purpose::Display].load() != nullptr;
+}
+
+bool ArtWorker::fetch(const Job& job, ArtImage& image) {
+    String location = job.url;
+    for (int attempt = 0; attempt < MAX_FETCH_ATTEMPTS; attempt++) {
+        ConnectionPool::Connection* connection = _connections.acquire(location);
+        if (connection == nullptr) {
+            LOG_WARN("image", "Unsupported album art URL: " + location);
+            return false;
+        }
+        bool reused = connection->client->connected();
+
+        HTTPClient& http = *connection->http;
+        http.setReuse(true);
+        // Redirects are followed here so each hop goes through the pooled client for its own host
+        http.setFollowRedirects(HTTPC_DISABLE_FOLLOW_REDIRECTS);
+        const char* headerKeys[] = {"Transfer-Encoding"};
+        http.collectHeaders(headerKeys, 1);
+        int httpCode = http.begin(*connection->client, location) ? http.GET() : -1;
+
+        if (superseded(job)) {
+            http.end();
+            _connections.release(connection, false);
+            return false;
+        }
+        if (httpCode < 0 && reused) {
+            // The server dropped the idle connection; try once more on a fresh one
+            http.end();
+            _connections.release(connection, false);
+            continue;
+        }
+        if (httpCode == HTTP_CODE_MOVED_PERMANENTLY || httpCode == HTTP_CODE_FOUND || httpCode == HTTP_CODE_SEE_OTHER ||
+            httpCode == HTTP_CODE_TEMPORARY_REDIRECT || httpCode == HTTP_CODE_PERMANENT_REDIRECT) {
+            String next = http.getLocation();
+            http.end();
+            _connections.release(connection, true);
+            if (next.length() == 0) break;
+            location = next.startsWith("/") ? location.substring(0, location.indexOf('/', location.indexOf("://") + 3)) + next
+                                            : next;
+            continue;
+        }
+        if (httpCode != HTTP_CODE_OK) {
+            LOG_WARN("image", "Album art fetch failed. HTTP code=" + String(httpCode));
+            http.end();
+            _connections.release(connection, false);
+            return false;
+        }
+
+        bool ok = decode(*connection, job, image);
+        http.end();
+        LOG_DEBUG("image", String(reused ? "Reused connection" : "New connection") + " for art (" +
+                  String(_connections.handshakes()) + " TLS handshakes, " + String(_connections.reuses()) + " reuses)");
+        return ok;
+    }
+    LOG_WARN("image", "Album art fetch gave up after " + String(MAX_FETCH_ATTEMPTS) + " attempts");
+    return false;
+}
+
+bool ArtWorker::decode(ConnectionPool::Connection& connection, const Job& job, ArtImage& image) {
+    HTTPClient& http = *connection.http;
+    // Decoded straight off the socket, so memory use no longer depends on the image size
+    bool chunked = http.header("Transfer-Encoding").equalsIgnoreCase("chunked");
+    int contentLength = http.getSize();
+    HttpBodyReader body(*connection.client, contentLength, chunked);
+    Spool spool;
+    ArtDecodeContext context;
+    context.body = &body;
+    context.spool = nullptr;
+    context.spoolPos = 0;
+    context.cancelled = [this, &job]() { return superseded(job); };
+
+    // Services and Sonos's /getaa proxy hand out PNG as well as JPEG; go by the magic bytes, not the URL
+    context.prefixLen = body.read(context.prefix, sizeof(context.prefix));
+    context.prefixPos = 0;
+    bool png = PngDecoder::isPng(context.prefix, context.prefixLen);
+    bool jpeg = context.prefixLen >= 2 && context.prefix[0] == 0xFF && context.prefix[1] == 0xD8;
+
+    bool ok = false;
+    if (png) {
+        ok = decodePng(context, image);
+    } else if (jpeg) {
+        // Art the user is waiting for is spooled so a slow download can show a coarse preview first
+        if (job.purpose == Purpose::Display && !chunked && contentLength > 0 &&
+            (size_t)contentLength <= MAX_SPOOL_BYTES && spool.allocate(contentLength)) {
+            memcpy(spool.data, context.prefix, context.prefixLen);
+            spool.size = context.prefixLen;
+            context.spool = &spool;
+            // The spool holds the sniffed bytes, so the decoder reads them from there
+            context.prefixPos = context.prefixLen;
+        }
+        ok = decodeJpeg(context, job, image);
+    } else {
+        LOG_WARN("image", "Album art is neither JPEG nor PNG");
+    }
+    // The connection only stays open for the next image if this response was read to its end
+    _connections.release(&connection, ok && body.finish());
+
+    if (!ok && superseded(job)) {
+        LOG_DEBUG("image", "Cancelled art decode after " + String(body.bytesRead()) + " bytes; a newer track wants art");
+        return false;
+    }
+    if (!ok) {
+        if (body.failed()) LOG_WARN("image", "Album art stream failed after " + String(body.bytesRead()) + " bytes");
+        return false;
+    }
+    LOG_DEBUG("image", String(png ? "PNG" : "JPEG") + " art decoded to " + String(image.width) + "x" +
+              String(image.height) + " from " + String(body.bytesRead()) + " bytes" + (chunked ? " (chunked)" : ""));
+    return true;
+}
+
+bool ArtWorker::decodeJpeg(ArtDecodeContext& context, const Job& job, ArtImage& image) {
+    static uint8_t workspace[TJPGD_WORKSPACE_SIZE] __attribute__((aligned(4)));
+    // Baseline JPEG needs the whole scan for any preview, so one only pays off when the download is slow
+    bool downloaded = context.spool != nullptr && spoolAhead(context, PREVIEW_BUDGET_MS);
+    if (downloaded) {
+        LOG_DEBUG("image", "Art downloaded after " + String(millis() - job.requestedMs) + " ms (" +
+                  String(context.spool->size) + " bytes); no preview");
+    }
+    JDEC jdec;
+    JRESULT result = jd_prepare(&jdec, jpegInput, workspace, sizeof(workspace), &context);
+    if (result == JDR_OK) {
+        // TJpgDec only reduces by powers of two; decode at the nearest one above the box fit and
+        // area-average the rest of the way as MCU rows arrive
+        uint16_t width, height;
+        ArtResampler::fitToBox(jdec.width, jdec.height, BOX_WIDTH, BOX_HEIGHT, width, height);
+        uint8_t scale = ArtResampler::decodeScale(jdec.width, jdec.height, width, height);
+
+        bool previewable = (jdec.width >> PREVIEW_SCALE) >= 8 && (jdec.height >> PREVIEW_SCALE) >= 8;
+        if (context.spool != nullptr && !downloaded && scale < PREVIEW_SCALE && previewable) {
+            ArtImage preview;
+            preview.url = image.url;
+            result = decodeScaled(jdec, context, PREVIEW_SCALE, preview, width, height);
+            if (result == JDR_OK && !superseded(job)) {
+                unsigned long previewMs = millis();
+                Result* early = new Result{preview, Purpose::Display, true, "network", job.requestedMs, previewMs, true};
+                release(_ready[(int)Purpose::Display].exchange(early));
+                LOG_DEBUG("image", "Art preview ready after " + String(previewMs - job.requestedMs) + " ms (" +
+                          String(context.body->bytesRead()) + " bytes, 1/8 decode)");
+            } else {
+                freeImage(preview);
+            }
+            if (result == JDR_OK) {
+                // Second pass from PSRAM at full quality
+                HttpBodyReader* body = context.body;
+                context.body = nullptr;
+                context.spoolPos = 0;
+                result = jd_prepare(&jdec, jpegInput, workspace, sizeof(workspace), &context);
+                if (result == JDR_OK) result = decodeScaled(jdec, context, scale, image, width, height);
+                context.body = body;
+            }
+        } else {
+            result = decodeScaled(jdec, context, scale, image, width, height);
+        }
+    }
+    if (result == JDR_OK && context.spool != nullptr) {
+        LOG_DEBUG("image", "Full-quality art ready after " + String(millis() - job.requestedMs) + " ms");
+    }
+    if (result != JDR_OK && result != JDR_INTR && !superseded(job)) {
+        LOG_WARN("image", "Album art JPEG decode failed (JRESULT " + String((int)result) + ")");
+    }
+    return result == JDR_OK;
+}
+
+bool ArtWorker::decodePng(ArtDecodeContext& context, ArtImage& image) {
+    // Full-resolution rows go through the same area-averaging resampler as JPEG MCU rows
+    ArtResampler resampler;
+    ArtImage* target = &image;
+    PngDecoder png([&context](uint8_t* dest, size_t len) { return readBody(context, dest, len); });
+    bool ok = png.decode(
+        [&](uint16_t w, uint16_t h) {
+            uint16_t width, height;
+            ArtResampler::fitToBox(w, h, BOX_WIDTH, BOX_HEIGHT, width, height);
+            return allocateImage(image, width, height) &&
+                   resampler.begin(w, h, width, height, [target](uint16_t row, const uint16_t* pixels) {
+                       memcpy(&target->pixels[row * target->width], pixels, target->width * sizeof(uint16_t));
+                   });
+        },
+        [&resampler](uint16_t, const uint16_t* pixels) { resampler.pushRow(pixels); });
+    if (!ok && !context.cancelled()) LOG_WARN("image", "Album art PNG decode failed: " + String(png.error()));
+    return ok && resampler.finished();
+}
@@ -0,0 +1,122 @@
+#include "ConnectionPool.h"
+#include <HTTPClient.h>
+#include <WiFiClientSecure.h>
+#include "AppLogger.h"
+
+ConnectionPool::~ConnectionPool() {
+    closeAll();
+}
+
+ConnectionPool::Connection* ConnectionPool::acquire(const String& url) {
+    String origin;
+    bool secure;
+    if (!parseOrigin(url, origin, secure)) return nullptr;
+
+    Entry* entry = find(origin);
+    if (entry == nullptr) {
+        if (_entries.size() >= MAX_CONNECTIONS) {
+            size_t oldest = 0;
+            for (size_t i = 1; i < _entries.size(); i++) {
+                if (_entries[i].lastUse < _entries[oldest].lastUse) oldest = i;
+            }
+            remove(oldest);
+        }
+        WiFiClient* client;
+        if (secure) {
+            WiFiClientSecure* secureClient = new WiFiClientSecure();
+            secureClient->setInsecure();
+            client = secureClient;
+        } else {
+            client = new WiFiClient();
+        }
+        _entries.push_back({origin, secure, new Connection{client, new HTTPClient()}, millis()});
+        entry = &_entries.back();
+    }
+
+    entry->lastUse = millis();
+    if (entry->connection->client->connected()) {
+        _reuses++;
+    } else if (entry->secure) {
+        // HTTPClient will connect on this client; make sure the handshake has heap to work with
+        if (ESP.getFreeHeap() < TLS_HEAP_RESERVE) {
+            Connection* keep = entry->connection;
+            evictIdle(keep);
+            entry = findConnection(keep);
+        }
+        _handshakes++;
+    }
+    return entry->connection;
+}
+
+void ConnectionPool::release(Connection* connection, bool reusable) {
+    Entry* entry = findConnection(connection);
+    if (entry == nullptr) return;
+    if (!reusable && connection->client->connected()) connection->client->stop();
+    entry->lastUse = millis();
+}
+
+void ConnectionPool::closeIdle() {
+    for (size_t i = _entries.size(); i-- > 0;) {
+        if (millis() - _entries[i].lastUse > IDLE_CLOSE_MS) remove(i);
+    }
+}
+
+void ConnectionPool::closeAll() {
+    while (!_entries.empty()) remove(_entries.size() - 1);
+}
+
+// "scheme://host[:port]/..." to "scheme://host:port"
+bool ConnectionPool::parseOrigin(const String& url, String& origin, bool& secure) {
+    int schemeEnd = url.indexOf("://");
+    if (schemeEnd < 0) return false;
+    String scheme = url.substring(0, schemeEnd);
+    scheme.toLowerCase();
+    if (scheme == "https") secure = true;
+    else if (scheme == "http") secure = false;
+    else return false;
+
+    int hostStart = schemeEnd + 3;
+    int pathStart = url.indexOf('/', hostStart);
+    String authority = url.substring(hostStart, pathStart < 0 ? url.length() : pathStart);
+    int at = authority.lastIndexOf('@');
+    if (at >= 0) authority = authority.substring(at + 1);
+    if (authority.length() == 0) return false;
+    authority.toLowerCase();
+    if (authority.indexOf(':') < 0) authority += secure ? ":443" : ":80";
+    origin = scheme + "://" + authority;
+    return true;
+}
+
+ConnectionPool::Entry* ConnectionPool::find(const String& origin) {
+    for (auto& entry : _entries) {
+        if (entry.origin == origin) return &entry;
+    }
+    return nullptr;
+}
+
+ConnectionPool::Entry* ConnectionPool::findConnection(const Connection* connection) {
+    for (auto& entry : _entries) {
+        if (entry.connection == connection) return &entry;
+    }
+    return nullptr;
+}
+
+void ConnectionPool::remove(size_t index) {
+    Entry& entry = _entries[index];
+    WiFiClient* client = entry.connection->client;
+    if (client->connected()) {
+        LOG_DEBUG("image", "Closing keep-alive connection to " + entry.origin);
+        client->stop();
+    }
+    // The HTTPClient still points at the client and stops it on the way out, so it goes first
+    delete entry.connection->http;
+    delete client;
+    delete entry.connection;
+    _entries.erase(_entries.begin() + index);
+}
+
+void ConnectionPool::evictIdle(const Connection* keep) {
+    for (size_t i = _entries.size(); i-- > 0 && ESP.getFreeHeap() < TLS_HEAP_RESERVE;) {
+        if (_entries[i].connection != keep && _entries[i].connection->client->connected()) remove(i);
+    }
+}
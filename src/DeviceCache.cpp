@@ -1,9 +1,40 @@
 #include "DeviceCache.h"
 #include <LittleFS.h>
 #include <ArduinoJson.h>
+#include <esp_rom_crc.h>
 #include "AppLogger.h"
 
-const char* DeviceCache::CACHE_FILE = "/sonos_devices.json";
+const char* DeviceCache::CACHE_FILE = "/sonos_devices.bin";
+const char* DeviceCache::TEMP_FILE = "/sonos_devices.tmp";
+const char* DeviceCache::LEGACY_JSON_FILE = "/sonos_devices.json";
+
+namespace {
+
+const uint32_t CACHE_MAGIC = 0x43444e53;  // "SNDC" little-endian
+const uint16_t CACHE_VERSION = 1;
+const uint16_t MAX_CACHED_DEVICES = 512;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t crc;  // CRC32 of the records that follow
+};
+
+struct CacheRecord {
+    char uuid[40];
+    char name[48];
+    uint32_t ip;  // IPAddress in network byte order
+};
+
+static_assert(sizeof(CacheHeader) == 12, "cache header layout changed");
+static_assert(sizeof(CacheRecord) == 92, "cache record layout changed; bump CACHE_VERSION");
+
+uint32_t recordsCrc(const std::vector<CacheRecord>& records) {
+    return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(records.data()), records.size() * sizeof(CacheRecord));
+}
+
+}  // namespace
 
 bool DeviceCache::begin() {
     if (!LittleFS.begin(true)) {
@@ -17,75 +48,148 @@ bool DeviceCache::begin() {
 
 std::vector<CachedDevice> DeviceCache::loadDevices() {
     std::vector<CachedDevice> devices;
-    
-    if (!filesystemReady || !LittleFS.exists(CACHE_FILE)) {
+    if (!filesystemReady) return devices;
+
+    if (!LittleFS.exists(CACHE_FILE)) {
+        if (LittleFS.exists(LEGACY_JSON_FILE)) migrateLegacyJson(devices);
         return devices;
     }
-    
+
+    unsigned long start = micros();
     File file = LittleFS.open(CACHE_FILE, "r");
     if (!file) {
         return devices;
     }
-    
+
+    CacheHeader header;
+    bool headerOk = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+                    header.magic == CACHE_MAGIC && header.version == CACHE_VERSION && header.count <= MAX_CACHED_DEVICES;
+    if (!headerOk) {
+        file.close();
+        LOG_WARN("cache", "Device cache header invalid; ignoring cache");
+        return devices;
+    }
+
+    std::vector<CacheRecord> records(header.count);
+    size_t expected = header.count * sizeof(CacheRecord);
+    size_t read = file.read(reinterpret_cast<uint8_t*>(records.data()), expected);
+    file.close();
+    if (read != expected || recordsCrc(records) != header.crc) {
+        LOG_WARN("cache", "Device cache truncated or corrupt; ignoring cache");
+        return devices;
+    }
+
+    devices.reserve(records.size());
+    for (auto& record : records) {
+        record.uuid[sizeof(record.uuid) - 1] = '\0';
+        record.name[sizeof(record.name) - 1] = '\0';
+        devices.push_back(CachedDevice(record.name, IPAddress(record.ip).toString(), record.uuid));
+    }
+
+    _lastCrc = header.crc;
+    _lastCount = header.count;
+    _hasLastCrc = true;
+    LOG_INFO("cache", "Loaded " + String(devices.size()) + " devices from binary cache in " + String(micros() - start) + " us");
+    return devices;
+}
+
+bool DeviceCache::migrateLegacyJson(std::vector<CachedDevice>& devices) {
+    unsigned long start = micros();
+    File file = LittleFS.open(LEGACY_JSON_FILE, "r");
+    if (!file) {
+        return false;
+    }
+
     JsonDocument doc;
     DeserializationError error = deserializeJson(doc, file);
     file.close();
-    
+
     if (error) {
-        LOG_WARN("cache", "Failed to parse device cache");
-        return devices;
+        LOG_WARN("cache", "Failed to parse legacy device cache");
+        return false;
     }
-    
+
+    std::vector<SonosDevice> migrated;
     JsonArray array = doc.as<JsonArray>();
     for (JsonObject obj : array) {
-        CachedDevice dev;
+        SonosDevice dev;
         dev.name = obj["name"].as<String>();
         dev.ip = obj["ip"].as<String>();
         dev.uuid = obj["uuid"].as<String>();
-        devices.push_back(dev);
+        migrated.push_back(dev);
+        devices.push_back(CachedDevice(dev));
     }
-    
-    return devices;
+    LOG_INFO("cache", "Loaded " + String(devices.size()) + " devices from JSON cache in " + String(micros() - start) + " us");
+
+    if (saveDevices(migrated)) {
+        LittleFS.remove(LEGACY_JSON_FILE);
+        LOG_INFO("cache", "Migrated JSON device cache to binary format");
+    }
+    return true;
 }
 
 bool DeviceCache::saveDevices(const std::vector<SonosDevice>& devices) {
     if (!filesystemReady) {
         return false;
     }
-    
-    JsonDocument doc;
-    JsonArray array = doc.to<JsonArray>();
-    
-    for (const auto& device : devices) {
-        JsonObject obj = array.add<JsonObject>();
-        obj["name"] = device.name;
-        obj["ip"] = device.ip;
-        obj["uuid"] = device.uuid;
+
+    size_t count = min(devices.size(), (size_t)MAX_CACHED_DEVICES);
+    std::vector<CacheRecord> records(count);
+    for (size_t i = 0; i < count; i++) {
+        CacheRecord& record = records[i];
+        memset(&record, 0, sizeof(record));
+        strlcpy(record.uuid, devices[i].uuid.c_str(), sizeof(record.uuid));
+        strlcpy(record.name, devices[i].name.c_str(), sizeof(record.name));
+        IPAddress ip;
+        record.ip = ip.fromString(devices[i].ip) ? static_cast<uint32_t>(ip) : 0;
+    }
+
+    CacheHeader header;
+    header.magic = CACHE_MAGIC;
+    header.version = CACHE_VERSION;
+    header.count = count;
+    header.crc = recordsCrc(records);
+
+    // Discovery re-saves after every scan; most scans change nothing worth a flash write
+    if (_hasLastCrc && header.crc == _lastCrc && header.count == _lastCount) {
+        _skippedWrites++;
+        LOG_DEBUG("cache", "Device cache unchanged; skipped write (" + String(_writes) + " writes, " +
+                  String(_skippedWrites) + " skipped since boot)");
+        return true;
     }
-    
-    File file = LittleFS.open(CACHE_FILE, "w");
+
+    // Write beside the live file and rename over it, so power loss never leaves a partial cache
+    File file = LittleFS.open(TEMP_FILE, "w");
     if (!file) {
         return false;
     }
-    
-    bool success = serializeJson(doc, file) > 0;
+    size_t expected = sizeof(header) + count * sizeof(CacheRecord);
+    size_t written = file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    written += file.write(reinterpret_cast<const uint8_t*>(records.data()), count * sizeof(CacheRecord));
     file.close();
-    
-    if (success) {
-        LOG_INFO("cache", "Saved " + String(devices.size()) + " devices to cache");
-    } else {
+
+    if (written != expected || !LittleFS.rename(TEMP_FILE, CACHE_FILE)) {
+        LittleFS.remove(TEMP_FILE);
         LOG_WARN("cache", "Failed to write device cache");
+        return false;
     }
-    
-    return success;
+
+    _lastCrc = header.crc;
+    _lastCount = header.count;
+    _hasLastCrc = true;
+    _writes++;
+    LOG_INFO("cache", "Saved " + String(count) + " devices to cache (" + String(expected) + " bytes, " + String(_writes) +
+             " writes, " + String(_skippedWrites) + " skipped since boot)");
+    return true;
 }
 
 bool DeviceCache::hasCachedDevices() {
-    return filesystemReady && LittleFS.exists(CACHE_FILE);
+    return filesystemReady && (LittleFS.exists(CACHE_FILE) || LittleFS.exists(LEGACY_JSON_FILE));
 }
 
 void DeviceCache::clear() {
-    if (filesystemReady && LittleFS.exists(CACHE_FILE)) {
-        LittleFS.remove(CACHE_FILE);
-    }
+    if (!filesystemReady) return;
+    if (LittleFS.exists(CACHE_FILE)) LittleFS.remove(CACHE_FILE);
+    if (LittleFS.exists(LEGACY_JSON_FILE)) LittleFS.remove(LEGACY_JSON_FILE);
+    _hasLastCrc = false;
 }
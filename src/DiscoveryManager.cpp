@@ -4,17 +4,32 @@
 DiscoveryManager::DiscoveryManager(Sonos& sonos, DeviceCache& cache)
     : _sonos(sonos), _cache(cache), _lastDiscoveryTime(0) {
     _sonos.setDeviceFoundCallback([this](const SonosDevice& device) {
-        bool exists = false;
-        for (const auto& d : _devices) {
-            if (d.ip == device.ip) {
-                exists = true;
+        bool changed = true;
+        int index = findDevice(device);
+        if (index >= 0) {
+            SonosDevice& d = _devices[index];
+            changed = d.ip != device.ip || d.name != device.name || d.reachability != device.reachability;
+            d = device;
+            if (device.uuid.length() > 0) _deviceIndex[device.uuid] = index;
+        } else {
+            if (device.uuid.length() > 0) _deviceIndex[device.uuid] = _devices.size();
+            _devices.push_back(device);
+        }
+        if (changed) {
+            if (!_sonos.isDiscovering()) _cacheDirty = true;
+            _listChanged = true;
+        }
+    });
+
+    _sonos.setDeviceLostCallback([this](const SonosDevice& device) {
+        for (auto it = _devices.begin(); it != _devices.end(); ++it) {
+            if (it->uuid == device.uuid) {
+                _devices.erase(it);
+                rebuildIndex();
+                _listChanged = true;
                 break;
             }
         }
-        if (!exists) {
-            _devices.push_back(device);
-            if (_discoveryCallback) _discoveryCallback(_devices);
-        }
     });
 }
 
@@ -29,28 +44,129 @@ void DiscoveryManager::begin() {
         dev.uuid = c.uuid;
         _devices.push_back(dev);
     }
+    rebuildIndex();
     _sonos.setDevices(_devices);
     _lastDiscoveryTime = millis();
 }
 
 bool DiscoveryManager::update() {
+    if (!_sonos.isInitialized()) return false;
+
+    if (!_cacheValidated) {
+        _cacheValidated = true;
+        validateCache();
+    }
+
+    _sonos.updatePresence();
+
     if (_sonos.isDiscovering()) {
         _sonos.updateDiscovery();
         if (!_sonos.isDiscovering()) {
-            LOG_INFO("discovery", "Discovery finished with " + String(_devices.size()) + " devices");
+            _devices = _sonos.getDiscoveredDevices();
+            rebuildIndex();
+            const SonosDiscoveryStats& stats = _sonos.getLastDiscoveryStats();
             if (_devices.size() > 0) _cache.saveDevices(_devices);
+            _cacheDirty = false;
+            _listChanged = true;
+            publishListChanges(true);
+            LOG_INFO("discovery", "Discovery finished with " + String(_devices.size()) + " devices in " +
+                     String(stats.durationMs) + " ms" + (stats.endedEarly ? "" : " (hit timeout)") +
+                     ", list refreshes=" + String(_listPublishes));
+            _listPublishes = 0;
+        } else {
+            publishListChanges(false);
         }
         return true;
     }
 
+    publishListChanges(false);
+
+    if (_cacheDirty) {
+        _cacheDirty = false;
+        _cache.saveDevices(_devices);
+    }
+
+    if (WiFi.status() == WL_CONNECTED) {
+        if (_sonos.hasPendingResolves()) {
+            _sonos.resolvePendingDevices();
+            return false;
+        }
+
+        unsigned long interval = _sonos.isPresenceActive() ? DISCOVERY_INTERVAL : DISCOVERY_INTERVAL_NO_PRESENCE;
+        if (!_hasScanned && _devices.empty()) {
+            startDiscovery("no cached devices");
+        } else if (millis() - _lastDiscoveryTime > interval) {
+            startDiscovery("periodic fallback");
+        }
+    }
+
     return false;
 }
 
+void DiscoveryManager::updatePresence() {
+    if (!_sonos.isInitialized()) return;
+    _sonos.updatePresence();
+    publishListChanges(false);
+}
+
 void DiscoveryManager::forceRefresh() {
     if (WiFi.status() != WL_CONNECTED || _sonos.isDiscovering()) return;
+    startDiscovery("manual refresh");
+}
 
-    LOG_INFO("discovery", "Starting manual refresh");
+void DiscoveryManager::startDiscovery(const char* reason) {
+    LOG_INFO("discovery", "Starting discovery (" + String(reason) + ")");
     _lastDiscoveryTime = millis();
-    _devices.clear();
+    _hasScanned = true;
     _sonos.discoverDevices();
 }
+
+void DiscoveryManager::validateCache() {
+    if (_devices.empty() || _sonos.isDiscovering()) return;
+
+    _sonos.validateDevices(_devices);
+    _sonos.setDevices(_devices);
+
+    std::vector<String> failed;
+    for (const auto& device : _devices) {
+        if (device.reachability != SonosReachability::REACHABLE && device.uuid.length() > 0) {
+            failed.push_back(device.uuid);
+        }
+    }
+    if (_discoveryCallback) _discoveryCallback(_devices);
+
+    if (!failed.empty()) {
+        LOG_INFO("discovery", "Rediscovering " + String(failed.size()) + " unreachable cached devices");
+        _lastDiscoveryTime = millis();
+        _sonos.discoverDevices(failed);
+    }
+}
+
+int DiscoveryManager::findDevice(const SonosDevice& device) const {
+    if (device.uuid.length() > 0) {
+        auto indexed = _deviceIndex.find(device.uuid);
+        return indexed != _deviceIndex.end() ? (int)indexed->second : -1;
+    }
+    for (size_t i = 0; i < _devices.size(); i++) {
+        if (_devices[i].ip == device.ip) return i;
+    }
+    return -1;
+}
+
+void DiscoveryManager::rebuildIndex() {
+    _deviceIndex.clear();
+    for (size_t i = 0; i < _devices.size(); i++) {
+        if (_devices[i].uuid.length() > 0) _deviceIndex[_devices[i].uuid] = i;
+    }
+}
+
+void DiscoveryManager::publishListChanges(bool force) {
+    if (!_listChanged) return;
+    unsigned long now = millis();
+    if (!force && now - _lastListPublishMs < LIST_PUBLISH_INTERVAL) return;
+
+    _listChanged = false;
+    _lastListPublishMs = now;
+    _listPublishes++;
+    if (_discoveryCallback) _discoveryCallback(_devices);
+}
@@ -0,0 +1,153 @@
+#include "HttpBodyReader.h"
+
+HttpBodyReader::HttpBodyReader(Client& client, int contentLength, bool chunked, unsigned long timeoutMs)
+    : _client(client), _contentLength(chunked ? -1 : contentLength), _chunked(chunked), _timeoutMs(timeoutMs) {}
+
+size_t HttpBodyReader::read(uint8_t* dest, size_t len) {
+    size_t total = 0;
+    while (total < len && !_ended && !_failed) {
+        if (_chunked && _chunkLeft == 0) {
+            if (!readChunkHeader()) break;
+            continue;
+        }
+
+        size_t want = len - total;
+        if (_chunked) want = min(want, _chunkLeft);
+        else if (_contentLength >= 0) want = min(want, (size_t)_contentLength - _bytesRead);
+        if (want == 0) {
+            _ended = true;
+            break;
+        }
+
+        size_t got = readRaw(dest != nullptr ? dest + total : nullptr, want);
+        if (got == 0) {
+            // Without a length, the server closing the connection is the end of the body
+            if (!_chunked && _contentLength < 0 && !_client.connected()) _ended = true;
+            else _failed = true;
+            break;
+        }
+        total += got;
+        _bytesRead += got;
+        if (_chunked) _chunkLeft -= got;
+    }
+    return total;
+}
+
+bool HttpBodyReader::finish(size_t maxBytes) {
+    size_t skipped = 0;
+    while (!_ended && !_failed && skipped <= maxBytes) {
+        size_t got = read(nullptr, 512);
+        if (got == 0) break;
+        skipped += got;
+    }
+    // A body delimited by the server closing the connection leaves nothing to reuse
+    return _ended && !_failed && (_chunked || _contentLength >= 0);
+}
+
+bool HttpBodyReader::fill() {
+    if (_count == RING_SIZE) return true;
+    unsigned long start = millis();
+    int available = _client.available();
+    while (available <= 0) {
+        if (!_client.connected() || millis() - start > _timeoutMs) return false;
+        delay(1);
+        available = _client.available();
+    }
+
+    size_t tail = (_head + _count) % RING_SIZE;
+    size_t space = (tail >= _head) ? RING_SIZE - tail : _head - tail;
+    if (_count == 0) {
+        _head = tail = 0;
+        space = RING_SIZE;
+    }
+    int got = _client.read(&_ring[tail], min(space, (size_t)available));
+    if (got <= 0) return false;
+    _count += got;
+    return true;
+}
+
+bool HttpBodyReader::readRawByte(uint8_t& byte) {
+    if (_count == 0 && !fill()) return false;
+    byte = _ring[_head];
+    _head = (_head + 1) % RING_SIZE;
+    _count--;
+    return true;
+}
+
+size_t HttpBodyReader::readRaw(uint8_t* dest, size_t len) {
+    size_t total = 0;
+    while (total < len) {
+        if (_count == 0 && !fill()) break;
+        size_t run = min(min(len - total, _count), RING_SIZE - _head);
+        if (dest != nullptr) memcpy(dest + total, &_ring[_head], run);
+        _head = (_head + run) % RING_SIZE;
+        _count -= run;
+        total += run;
+    }
+    return total;
+}
+
+// "<hex size>[;extensions]\r\n", preceded by the CRLF that closes the previous chunk
+bool HttpBodyReader::readChunkHeader() {
+    uint8_t byte;
+    if (!_firstChunk) {
+        for (int i = 0; i < 2; i++) {
+            if (!readRawByte(byte)) {
+                _failed = true;
+                return false;
+            }
+        }
+    }
+    _firstChunk = false;
+
+    size_t size = 0;
+    bool digits = false;
+    bool inExtension = false;
+    while (true) {
+        if (!readRawByte(byte)) {
+            _failed = true;
+            return false;
+        }
+        if (byte == '\n') break;
+        if (byte == '\r' || inExtension) continue;
+        if (byte == ';') {
+            inExtension = true;
+            continue;
+        }
+        int nibble = (byte >= '0' && byte <= '9') ? byte - '0' : (byte >= 'a' && byte <= 'f') ? byte - 'a' + 10 :
+                     (byte >= 'A' && byte <= 'F') ? byte - 'A' + 10 : -1;
+        if (nibble < 0 || size > 0x0FFFFFFF) {
+            _failed = true;
+            return false;
+        }
+        size = (size << 4) | nibble;
+        digits = true;
+    }
+    if (!digits) {
+        _failed = true;
+        return false;
+    }
+
+    // The zero-size chunk ends the body; its trailers must be consumed for the connection to be reused
+    if (size == 0) {
+        if (!skipTrailers()) _failed = true;
+        _ended = true;
+    }
+    _chunkLeft = size;
+    return size > 0;
+}
+
+// Trailer fields after the last chunk, ended by an empty line
+bool HttpBodyReader::skipTrailers() {
+    size_t lineLength = 0;
+    uint8_t byte;
+    while (readRawByte(byte)) {
+        if (byte == '\n') {
+            if (lineLength == 0) return true;
+            lineLength = 0;
+        } else if (byte != '\r') {
+            lineLength++;
+        }
+    }
+    return false;
+}
@@ -1,20 +1,102 @@
 #include <Arduino.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_ST7789.h>
-#include <TJpg_Decoder.h>
-#include <HTTPClient.h>
-#include <WiFiClientSecure.h>
 #include "NowPlaying.h"
 #include "UIGlobals.h"
 #include "AppLogger.h"
 #include "Images.h"
+#include "ArtCache.h"
+#include "ArtTileCache.h"
+#include "ArtWorker.h"
 
 extern Adafruit_ST7789 tft;
+extern ArtCache artCache;
+extern ArtTileCache artTileCache;
+extern ArtWorker artWorker;
 
-static bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
-    if (y >= tft.height()) return false;
-    tft.drawRGBBitmap(x, y, bitmap, w, h);
-    return true;
+// Placement of the art on screen, so it can be sampled into the thumbnail
+static uint16_t artThumbnail[NowPlaying::THUMB_SIZE * NowPlaying::THUMB_SIZE];
+static bool artThumbnailValid = false;
+static int16_t artX = 0, artY = 0, artW = 0, artH = 0;
+// Art requested from the worker for display; empty once it has been drawn
+static String wantedArtUrl = "";
+
+// Next track, decoded and laid out ahead of the track change so the swap is just a blit
+struct StagedTrack {
+    bool valid = false;
+    String title, artist, album, artUrl;
+    std::vector<TextLine> layout;
+    uint16_t* tile = nullptr;
+    uint16_t width = 0, height = 0;
+};
+static StagedTrack staged;
+static uint32_t stageHits = 0, stageMisses = 0;
+
+static void captureThumbnail(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t* bitmap) {
+    const int size = NowPlaying::THUMB_SIZE;
+    if (artW <= 0 || artH <= 0) return;
+    for (int ty = 0; ty < size; ty++) {
+        int sy = artY + (ty * artH + artH / 2) / size;
+        if (sy < y || sy >= y + h) continue;
+        for (int tx = 0; tx < size; tx++) {
+            int sx = artX + (tx * artW + artW / 2) / size;
+            if (sx < x || sx >= x + w) continue;
+            artThumbnail[ty * size + tx] = bitmap[(sy - y) * w + (sx - x)];
+        }
+    }
+}
+
+static void logArtLatency(const char* source, unsigned long startMs) {
+    uint32_t lookups = artCache.hits() + artCache.misses();
+    LOG_INFO("image", "Time to art: " + String(millis() - startMs) + " ms from " + source + " (flash cache " +
+             String(artCache.hits()) + " hits, " + String(artCache.misses()) + " misses, " +
+             String(lookups > 0 ? artCache.hits() * 100 / lookups : 0) + "% hit rate; PSRAM tiles " +
+             String(artTileCache.hits()) + " hits, " + String(artTileCache.misses()) + " misses, " +
+             String(artTileCache.evictions()) + " evictions, " + String(artTileCache.usedBytes() / 1024) + " KB)");
+}
+
+// Centers art of the given size in the art box and draws it in a single window write
+static void showArt(uint16_t* pixels, uint16_t w, uint16_t h) {
+    artX = (240 - w) / 2;
+    artY = 58 + (94 - h) / 2;
+    artW = w;
+    artH = h;
+    tft.fillRect(0, 58, 240, 94, ST77XX_BLACK);
+    tft.drawRGBBitmap(artX, artY, pixels, w, h);
+    captureThumbnail(artX, artY, w, h, pixels);
+    artThumbnailValid = true;
+}
+
+static std::vector<TextLine> layoutTrackInfo(const char* song, const char* artist, const char* album) {
+    std::vector<TextLine> lines;
+    int16_t sL = strlen(song);
+
+    int16_t currentY = 183;
+    if (sL > (240 / 12)) {
+        if (sL > (240 / 6)) {
+            currentY = layoutCenteredWrapped(song, currentY, 240, 1, ST77XX_WHITE, lines);
+        } else {
+            lines.push_back({String(song), centerX(song, 1), currentY, 1, ST77XX_WHITE});
+            currentY += 10;
+        }
+    } else {
+        lines.push_back({String(song), centerX(song, 2), currentY, 2, ST77XX_WHITE});
+        currentY += 20;
+    }
+
+    currentY += 10;
+    currentY = layoutCenteredWrapped(artist, currentY, 240, 1, 0xAD55, lines);
+
+    if (album && strlen(album) > 0) {
+        currentY += 10;
+        layoutCenteredWrapped(album, currentY, 240, 1, 0xAD55, lines);
+    }
+    return lines;
+}
+
+static void clearStaged() {
+    if (staged.tile != nullptr) free(staged.tile);
+    staged = StagedTrack();
 }
 
 void NowPlaying::drawStatic() {
@@ -34,6 +116,7 @@ void NowPlaying::drawStatusBar(const char* statusText) {
 }
 
 void NowPlaying::drawAlbumArt() {
+    artThumbnailValid = false;
     int centerX = 120, centerY = 105;
     tft.fillRect(0, 58, 240, 94, ST77XX_BLACK);
     tft.drawCircle(centerX, centerY, 40, 0x4208);
@@ -47,101 +130,109 @@ void NowPlaying::drawAlbumArt() {
 
 void NowPlaying::drawAlbumArt(const char* url) {
     if (url == nullptr || strlen(url) == 0) {
+        wantedArtUrl = "";
         drawAlbumArt();
         return;
     }
 
-    LOG_DEBUG("image", "Fetching album art: " + String(url));
-    HTTPClient http;
-    http.setFollowRedirects(HTTPC_STRICT_FOLLOW_REDIRECTS);
-
-    int httpCode = -1;
+    unsigned long start = millis();
     String urlStr = String(url);
-    if (urlStr.startsWith("https://")) {
-        WiFiClientSecure sc; sc.setInsecure();
-        if (http.begin(sc, urlStr)) httpCode = http.GET();
-    } else {
-        if (http.begin(urlStr)) httpCode = http.GET();
+    // Decoded tiles in PSRAM are a single window write away
+    const ArtTileCache::Tile* tile = artTileCache.get(urlStr);
+    if (tile != nullptr) {
+        wantedArtUrl = "";
+        showArt(tile->pixels, tile->width, tile->height);
+        logArtLatency("PSRAM", start);
+        return;
     }
 
-    if (httpCode == HTTP_CODE_OK) {
-        int len = http.getSize();
-        if (len > 0) {
-            size_t freeHeap = ESP.getFreeHeap();
-            if (freeHeap < (size_t)len + 8192) {
-                LOG_WARN("image", "Not enough memory for image. freeHeap=" + String(freeHeap) + " size=" + String(len));
-                drawAlbumArt();
-                http.end();
-                return;
-            }
-
-            uint8_t* buffer = (uint8_t*)malloc(len);
-            if (buffer) {
-                if (http.getStream().readBytes(buffer, len) > 0) {
-                    TJpgDec.setCallback(tft_output);
-                    uint16_t w, h;
-                    if (TJpgDec.getJpgSize(&w, &h, buffer, len) == JDR_OK) {
-                        uint8_t scale = 1;
-                        if (w > 320 || h > 320) scale = 8;
-                        else if (w > 160 || h > 160) scale = 4;
-                        else if (w > 80 || h > 80) scale = 2;
-
-                        TJpgDec.setJpgScale(scale);
-                        int drawW = w / scale;
-                        int drawH = h / scale;
-                        int x = (240 - drawW) / 2;
-                        int y = 58 + (94 - drawH) / 2;
-
-                        tft.fillRect(0, 58, 240, 94, ST77XX_BLACK);
-                        TJpgDec.drawJpg(x, y, buffer, len);
-                    } else {
-                        LOG_WARN("image", "Failed to decode JPG metadata");
-                        drawAlbumArt();
-                    }
-                }
-                free(buffer);
-            } else {
-                LOG_WARN("image", "Failed to allocate image buffer");
-            }
+    // Flash and network go through the art worker; the previous art stays up until update() swaps it
+    wantedArtUrl = urlStr;
+    artThumbnailValid = false;
+    artWorker.request(urlStr, ArtWorker::Purpose::Display);
+}
+
+bool NowPlaying::update() {
+    ArtWorker::Result* result = artWorker.takeResult();
+    if (result == nullptr) return false;
+
+    ArtImage& image = result->image;
+    bool shown = false;
+    if (result->ok && !result->preview) artTileCache.put(image.url, image.pixels, image.width, image.height);
+    if (image.url == wantedArtUrl && result->preview) {
+        // Refined in place when the full-quality pass lands
+        shown = true;
+        showArt(image.pixels, image.width, image.height);
+        LOG_INFO("image", "Art preview on screen " + String(millis() - result->requestedMs) + " ms after request");
+    } else if (image.url == wantedArtUrl) {
+        wantedArtUrl = "";
+        shown = true;
+        if (result->ok) {
+            showArt(image.pixels, image.width, image.height);
+            logArtLatency(result->source, result->requestedMs);
+        } else {
+            drawAlbumArt();
         }
-    } else {
-        LOG_WARN("image", "Album art fetch failed. HTTP code=" + String(httpCode));
-        drawAlbumArt();
+    } else if (result->ok && !result->preview && staged.valid && staged.tile == nullptr && image.url == staged.artUrl) {
+        staged.tile = image.pixels;
+        staged.width = image.width;
+        staged.height = image.height;
+        image.pixels = nullptr;
+        LOG_DEBUG("image", "Staged art for next track '" + staged.title + "' after " +
+                  String(result->finishedMs - result->requestedMs) + " ms");
     }
-    http.end();
+    ArtWorker::release(result);
+    return shown;
 }
 
 void NowPlaying::drawTrackInfo(const char* song, const char* artist, const char* album) {
-    tft.setTextColor(ST77XX_WHITE);
     tft.fillRect(0, 180, 240, 70, ST77XX_BLACK);
     tft.setFont();
-    uint8_t tS = 2;
-    int16_t sL = strlen(song);
+    printLines(tft, layoutTrackInfo(song, artist, album));
+}
 
-    int16_t currentY = 183;
-    if (sL > (240 / 12)) {
-        tS = 1; tft.setTextSize(1);
-        if (sL > (240 / 6)) {
-            currentY = printCenteredWrapped(tft, song, currentY, 240, 1);
-        } else {
-            tft.setCursor(centerX(song, 1), currentY); tft.print(song);
-            currentY += 10;
-        }
-    } else {
-        tft.setTextSize(2); tft.setCursor(centerX(song, 2), currentY); tft.print(song);
-        currentY += 20;
-    }
+void NowPlaying::stageTrack(const char* song, const char* artist, const char* album, const char* artUrl) {
+    clearStaged();
+    staged.valid = true;
+    staged.title = song;
+    staged.artist = artist;
+    staged.album = album;
+    staged.artUrl = artUrl;
+    staged.layout = layoutTrackInfo(song, artist, album);
+    if (staged.artUrl.length() == 0 || artTileCache.contains(staged.artUrl)) return;
+    artWorker.request(staged.artUrl, ArtWorker::Purpose::Prefetch);
+}
 
-    tft.setTextSize(1); tft.setTextColor(0xAD55);
-    currentY += 10;
-    currentY = printCenteredWrapped(tft, artist, currentY, 240, 1);
+bool NowPlaying::isStaged(const char* song, const char* artUrl) const {
+    return staged.valid && staged.title == song && staged.artUrl == artUrl;
+}
 
-    if (album && strlen(album) > 0) {
-        currentY += 10;
-        printCenteredWrapped(tft, album, currentY, 240, 1);
+bool NowPlaying::showStagedTrack(const char* song, const char* artist, const char* album, const char* artUrl) {
+    bool hit = staged.valid && staged.title == song && staged.artist == artist && staged.album == album &&
+               staged.artUrl == artUrl;
+    if (!hit) {
+        stageMisses++;
+        LOG_DEBUG("image", "Track change missed the prefetch (" + String(stageHits) + " hits, " + String(stageMisses) +
+                  " misses)");
+        return false;
     }
-}
 
+    unsigned long start = millis();
+    tft.fillRect(0, 180, 240, 70, ST77XX_BLACK);
+    tft.setFont();
+    printLines(tft, staged.layout);
+    if (staged.tile != nullptr) {
+        wantedArtUrl = "";
+        showArt(staged.tile, staged.width, staged.height);
+    } else {
+        drawAlbumArt(artUrl);
+    }
+    stageHits++;
+    LOG_INFO("image", "Swapped in prefetched track in " + String(millis() - start) + " ms (" + String(stageHits) +
+             " hits, " + String(stageMisses) + " misses)");
+    clearStaged();
+    return true;
+}
 
 static String formatTime(int seconds) {
     if (seconds < 0) seconds = 0;
@@ -175,3 +266,38 @@ void NowPlaying::drawSpeakerInfo(const char* name) {
     tft.setFont(); tft.setTextSize(2);
     tft.setCursor(centerX(name, 2), 37); tft.print(name);
 }
+
+bool NowPlaying::getArtThumbnail(std::vector<uint16_t>& pixels) const {
+    if (!artThumbnailValid) {
+        pixels.clear();
+        return false;
+    }
+    pixels.assign(artThumbnail, artThumbnail + THUMB_SIZE * THUMB_SIZE);
+    return true;
+}
+
+void NowPlaying::drawArtThumbnail(const std::vector<uint16_t>& pixels) {
+    if (pixels.size() != (size_t)THUMB_SIZE * THUMB_SIZE) {
+        drawAlbumArt();
+        return;
+    }
+
+    memcpy(artThumbnail, pixels.data(), sizeof(artThumbnail));
+    artThumbnailValid = true;
+
+    // Pixel-doubled into the art box until the real art has been fetched
+    const int edge = THUMB_SIZE * 2;
+    int x = (240 - edge) / 2;
+    int y = 58 + (94 - edge) / 2;
+    uint16_t line[THUMB_SIZE * 2];
+    tft.fillRect(0, 58, 240, 94, ST77XX_BLACK);
+    for (int row = 0; row < THUMB_SIZE; row++) {
+        const uint16_t* src = &pixels[row * THUMB_SIZE];
+        for (int col = 0; col < THUMB_SIZE; col++) {
+            line[col * 2] = src[col];
+            line[col * 2 + 1] = src[col];
+        }
+        tft.drawRGBBitmap(x, y + row * 2, line, edge, 1);
+        tft.drawRGBBitmap(x, y + row * 2 + 1, line, edge, 1);
+    }
+}
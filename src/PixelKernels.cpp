@@ -0,0 +1,68 @@
+#include "PixelKernels.h"
+
+namespace {
+
+inline uint32_t load32(const void* p) {
+    uint32_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+inline void store32(void* p, uint32_t word) {
+    memcpy(p, &word, sizeof(word));
+}
+
+// Moves green into the upper half so the three channels have headroom for a four-pixel sum
+inline uint32_t spread(uint16_t pixel) {
+    return (pixel | ((uint32_t)pixel << 16)) & 0x07E0F81F;
+}
+
+inline uint16_t unspread(uint32_t spreadPixel) {
+    spreadPixel &= 0x07E0F81F;
+    return spreadPixel | (spreadPixel >> 16);
+}
+
+inline uint16_t pack(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+}  // namespace
+
+void packRgb565Scalar(const uint8_t* rgb, uint16_t* out, size_t count) {
+    for (size_t i = 0; i < count; i++, rgb += 3) out[i] = pack(rgb[0], rgb[1], rgb[2]);
+}
+
+// Four pixels per step: three word loads of R0G0B0R1 G1B1R2G2 B2R3G3B3 (little-endian), two word stores
+void packRgb565Swar(const uint8_t* rgb, uint16_t* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4, rgb += 12) {
+        uint32_t w0 = load32(rgb), w1 = load32(rgb + 4), w2 = load32(rgb + 8);
+        uint32_t p0 = ((w0 & 0xF8) << 8) | ((w0 >> 5) & 0x07E0) | ((w0 >> 19) & 0x1F);
+        uint32_t p1 = ((w0 >> 16) & 0xF800) | ((w1 << 3) & 0x07E0) | ((w1 >> 11) & 0x1F);
+        uint32_t p2 = ((w1 >> 8) & 0xF800) | ((w1 >> 21) & 0x07E0) | ((w2 >> 3) & 0x1F);
+        uint32_t p3 = (w2 & 0xF800) | ((w2 >> 13) & 0x07E0) | (w2 >> 27);
+        store32(&out[i], p0 | (p1 << 16));
+        store32(&out[i + 2], p2 | (p3 << 16));
+    }
+    packRgb565Scalar(rgb, out + i, count - i);
+}
+
+void halveRgb565Scalar(const uint16_t* row0, const uint16_t* row1, uint16_t* out, size_t outCount) {
+    for (size_t i = 0; i < outCount; i++) {
+        uint16_t a = row0[i * 2], b = row0[i * 2 + 1], c = row1[i * 2], d = row1[i * 2 + 1];
+        uint32_t r = ((a >> 11) + (b >> 11) + (c >> 11) + (d >> 11) + 2) >> 2;
+        uint32_t g = (((a >> 5) & 0x3F) + ((b >> 5) & 0x3F) + ((c >> 5) & 0x3F) + ((d >> 5) & 0x3F) + 2) >> 2;
+        uint32_t bl = ((a & 0x1F) + (b & 0x1F) + (c & 0x1F) + (d & 0x1F) + 2) >> 2;
+        out[i] = (r << 11) | (g << 5) | bl;
+    }
+}
+
+// All three channels summed in one register; the spread layout leaves two spare bits above each
+void halveRgb565Swar(const uint16_t* row0, const uint16_t* row1, uint16_t* out, size_t outCount) {
+    const uint32_t ROUND = (2u << 21) | (2u << 11) | 2u;
+    for (size_t i = 0; i < outCount; i++) {
+        uint32_t top = load32(&row0[i * 2]), bottom = load32(&row1[i * 2]);
+        uint32_t sum = spread(top) + spread(top >> 16) + spread(bottom) + spread(bottom >> 16) + ROUND;
+        out[i] = unspread(sum >> 2);
+    }
+}
@@ -0,0 +1,288 @@
+#include "PngDecoder.h"
+#include <esp_heap_caps.h>
+#include <rom/miniz.h>
+#include "PixelKernels.h"
+
+namespace {
+
+const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+enum ColorType : uint8_t { GRAY = 0, RGB = 2, PALETTE = 3, GRAY_ALPHA = 4, RGBA = 6 };
+
+uint32_t readBigEndian(const uint8_t* bytes) {
+    return ((uint32_t)bytes[0] << 24) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 8) | bytes[3];
+}
+
+uint32_t chunkType(const char* name) {
+    return readBigEndian(reinterpret_cast<const uint8_t*>(name));
+}
+
+// Window and inflator state are large; keep them out of internal RAM when PSRAM is there
+void* allocate(size_t bytes) {
+    void* memory = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM);
+    return memory != nullptr ? memory : malloc(bytes);
+}
+
+uint8_t paeth(uint8_t left, uint8_t up, uint8_t upLeft) {
+    int p = (int)left + up - upLeft;
+    int pa = abs(p - left), pb = abs(p - up), pc = abs(p - upLeft);
+    if (pa <= pb && pa <= pc) return left;
+    return pb <= pc ? up : upLeft;
+}
+
+uint16_t toRgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+uint8_t overBlack(uint8_t value, uint8_t alpha) {
+    return ((uint16_t)value * alpha + 127) / 255;
+}
+
+}  // namespace
+
+bool PngDecoder::isPng(const uint8_t* data, size_t len) {
+    return len >= sizeof(SIGNATURE) && memcmp(data, SIGNATURE, sizeof(SIGNATURE)) == 0;
+}
+
+PngDecoder::~PngDecoder() {
+    release();
+}
+
+bool PngDecoder::decode(const HeaderFn& onHeader, const RowFn& onRow) {
+    uint8_t signature[sizeof(SIGNATURE)];
+    if (!readExact(signature, sizeof(signature)) || !isPng(signature, sizeof(signature))) return fail("not a PNG");
+    memset(_paletteAlpha, 0xFF, sizeof(_paletteAlpha));
+
+    while (true) {
+        uint8_t chunk[8];
+        if (!readExact(chunk, sizeof(chunk))) return fail("truncated before IEND");
+        uint32_t length = readBigEndian(chunk);
+        uint32_t type = readBigEndian(chunk + 4);
+        if (length > 0x7FFFFFFF) return fail("bad chunk length");
+
+        bool ok;
+        if (type == chunkType("IHDR")) {
+            ok = readHeader(length, onHeader);
+        } else if (_window == nullptr) {
+            // IHDR must come first
+            return fail("missing IHDR");
+        } else if (type == chunkType("PLTE") && length <= sizeof(_palette) && length % 3 == 0) {
+            ok = readExact(_palette, length);
+        } else if (type == chunkType("tRNS") && _colorType == PALETTE && length <= sizeof(_paletteAlpha)) {
+            ok = readExact(_paletteAlpha, length);
+        } else if (type == chunkType("IDAT")) {
+            ok = inflateChunk(length, onRow);
+        } else if (type == chunkType("IEND")) {
+            if (_rowIndex < _height) return fail("image data ended early");
+            return skip(length + 4);
+        } else {
+            ok = skip(length);
+        }
+        // Chunk CRCs are not checked; zlib's Adler-32 covers the image data
+        if (!ok || !skip(4)) return _error != nullptr ? false : fail("truncated chunk");
+    }
+}
+
+bool PngDecoder::fail(const char* error) {
+    if (_error == nullptr) _error = error;
+    return false;
+}
+
+bool PngDecoder::readExact(uint8_t* dest, size_t len) {
+    return _read(dest, len) == len;
+}
+
+bool PngDecoder::skip(size_t len) {
+    return len == 0 || _read(nullptr, len) == len;
+}
+
+bool PngDecoder::readHeader(uint32_t length, const HeaderFn& onHeader) {
+    uint8_t header[13];
+    if (_window != nullptr || length != sizeof(header)) return fail("bad IHDR");
+    if (!readExact(header, sizeof(header))) return false;
+
+    uint32_t width = readBigEndian(header);
+    uint32_t height = readBigEndian(header + 4);
+    _bitDepth = header[8];
+    _colorType = header[9];
+    if (width == 0 || height == 0 || width > MAX_DIMENSION || height > MAX_DIMENSION) return fail("unsupported size");
+    if (header[10] != 0 || header[11] != 0) return fail("unknown compression or filter method");
+    if (header[12] != 0) return fail("interlaced PNG not supported");
+
+    uint8_t channels;
+    bool depthOk;
+    switch (_colorType) {
+        case GRAY: channels = 1; depthOk = _bitDepth == 1 || _bitDepth == 2 || _bitDepth == 4 || _bitDepth == 8 || _bitDepth == 16; break;
+        case PALETTE: channels = 1; depthOk = _bitDepth == 1 || _bitDepth == 2 || _bitDepth == 4 || _bitDepth == 8; break;
+        case RGB: channels = 3; depthOk = _bitDepth == 8 || _bitDepth == 16; break;
+        case GRAY_ALPHA: channels = 2; depthOk = _bitDepth == 8 || _bitDepth == 16; break;
+        case RGBA: channels = 4; depthOk = _bitDepth == 8 || _bitDepth == 16; break;
+        default: return fail("unknown color type");
+    }
+    if (!depthOk) return fail("bad bit depth");
+
+    _width = width;
+    _height = height;
+    size_t bitsPerPixel = (size_t)channels * _bitDepth;
+    _bytesPerPixel = max<size_t>(1, bitsPerPixel / 8);
+    _rowBytes = (width * bitsPerPixel + 7) / 8;
+
+    _inflator = static_cast<tinfl_decompressor*>(allocate(sizeof(tinfl_decompressor)));
+    _window = static_cast<uint8_t*>(allocate(TINFL_LZ_DICT_SIZE));
+    _input = static_cast<uint8_t*>(malloc(INPUT_BYTES));
+    _row = static_cast<uint8_t*>(allocate(_rowBytes + 1));
+    _prior = static_cast<uint8_t*>(allocate(_rowBytes + 1));
+    _pixels = static_cast<uint16_t*>(allocate(width * sizeof(uint16_t)));
+    if (!_inflator || !_window || !_input || !_row || !_prior || !_pixels) {
+        release();
+        return fail("out of memory");
+    }
+    tinfl_init(_inflator);
+    memset(_prior, 0, _rowBytes + 1);
+    return onHeader(_width, _height) || fail("size rejected");
+}
+
+// The inflator writes into a wrapping 32 KB window; each stretch it produces is fed to the
+// scanline assembler before the window wraps over it
+bool PngDecoder::inflateChunk(uint32_t length, const RowFn& onRow) {
+    size_t inputPos = 0, inputLeft = 0;
+    while (true) {
+        if (_inflateDone) return skip(length);
+        if (inputLeft == 0 && length > 0) {
+            size_t want = length < INPUT_BYTES ? length : INPUT_BYTES;
+            if (!readExact(_input, want)) return false;
+            length -= want;
+            inputPos = 0;
+            inputLeft = want;
+        }
+
+        size_t inBytes = inputLeft;
+        size_t outBytes = TINFL_LZ_DICT_SIZE - _windowPos;
+        tinfl_status status = tinfl_decompress(_inflator, _input + inputPos, &inBytes, _window, _window + _windowPos,
+                                               &outBytes, TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+        inputPos += inBytes;
+        inputLeft -= inBytes;
+        if (!consume(_window + _windowPos, outBytes, onRow)) return false;
+        _windowPos = (_windowPos + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+
+        if (status < TINFL_STATUS_DONE) return fail("corrupt image data");
+        if (status == TINFL_STATUS_DONE) _inflateDone = true;
+        // Out of input for this chunk; the stream continues in the next IDAT
+        else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && inputLeft == 0 && length == 0) return true;
+    }
+}
+
+bool PngDecoder::consume(const uint8_t* data, size_t len, const RowFn& onRow) {
+    while (len > 0 && _rowIndex < _height) {
+        size_t take = min(len, _rowBytes + 1 - _rowFill);
+        memcpy(_row + _rowFill, data, take);
+        _rowFill += take;
+        data += take;
+        len -= take;
+        if (_rowFill < _rowBytes + 1) break;
+
+        if (!unfilterRow()) return false;
+        convertRow();
+        onRow(_rowIndex++, _pixels);
+        std::swap(_row, _prior);
+        _rowFill = 0;
+    }
+    return true;
+}
+
+bool PngDecoder::unfilterRow() {
+    uint8_t filter = _row[0];
+    uint8_t* row = _row + 1;
+    const uint8_t* prior = _prior + 1;
+    size_t bpp = _bytesPerPixel;
+    switch (filter) {
+        case 0:
+            break;
+        case 1:
+            for (size_t i = bpp; i < _rowBytes; i++) row[i] += row[i - bpp];
+            break;
+        case 2:
+            for (size_t i = 0; i < _rowBytes; i++) row[i] += prior[i];
+            break;
+        case 3:
+            for (size_t i = 0; i < _rowBytes; i++) row[i] += ((i >= bpp ? row[i - bpp] : 0) + prior[i]) >> 1;
+            break;
+        case 4:
+            for (size_t i = 0; i < _rowBytes; i++) {
+                row[i] += i >= bpp ? paeth(row[i - bpp], prior[i], prior[i - bpp]) : prior[i];
+            }
+            break;
+        default:
+            return fail("bad filter type");
+    }
+    return true;
+}
+
+// Sub-byte samples are packed most significant first
+uint8_t PngDecoder::sample(const uint8_t* row, uint16_t index) const {
+    if (_bitDepth == 8) return row[index];
+    if (_bitDepth == 16) return row[index * 2];
+    size_t bit = (size_t)index * _bitDepth;
+    uint8_t shift = 8 - _bitDepth - (bit & 7);
+    return (row[bit >> 3] >> shift) & ((1 << _bitDepth) - 1);
+}
+
+void PngDecoder::convertRow() {
+    const uint8_t* row = _row + 1;
+    if (_colorType == RGB && _bitDepth == 8) {
+        // The usual case for photos; packed several pixels at a time
+        packRgb565(row, _pixels, _width);
+        return;
+    }
+    for (uint16_t x = 0; x < _width; x++) {
+        uint8_t r, g, b, a = 0xFF;
+        switch (_colorType) {
+            case GRAY:
+                r = g = b = _bitDepth < 8 ? sample(row, x) * 255 / ((1 << _bitDepth) - 1) : sample(row, x);
+                break;
+            case PALETTE: {
+                uint8_t index = sample(row, x);
+                r = _palette[index * 3];
+                g = _palette[index * 3 + 1];
+                b = _palette[index * 3 + 2];
+                a = _paletteAlpha[index];
+                break;
+            }
+            case RGB:
+                r = sample(row, x * 3);
+                g = sample(row, x * 3 + 1);
+                b = sample(row, x * 3 + 2);
+                break;
+            case GRAY_ALPHA:
+                r = g = b = sample(row, x * 2);
+                a = sample(row, x * 2 + 1);
+                break;
+            default:
+                r = sample(row, x * 4);
+                g = sample(row, x * 4 + 1);
+                b = sample(row, x * 4 + 2);
+                a = sample(row, x * 4 + 3);
+                break;
+        }
+        if (a != 0xFF) {
+            r = overBlack(r, a);
+            g = overBlack(g, a);
+            b = overBlack(b, a);
+        }
+        _pixels[x] = toRgb565(r, g, b);
+    }
+}
+
+void PngDecoder::release() {
+    heap_caps_free(_inflator);
+    heap_caps_free(_window);
+    free(_input);
+    heap_caps_free(_row);
+    heap_caps_free(_prior);
+    heap_caps_free(_pixels);
+    _inflator = nullptr;
+    _window = nullptr;
+    _input = nullptr;
+    _row = _prior = nullptr;
+    _pixels = nullptr;
+}
@@ -0,0 +1,125 @@
+#include "RtcState.h"
+#include <sys/time.h>
+#include <esp_sleep.h>
+#include <esp_rom_crc.h>
+#include "AppLogger.h"
+
+namespace {
+
+const uint32_t RTC_MAGIC = 0x53435452;  // "RTCS" little-endian
+const uint16_t RTC_VERSION = 1;
+
+RTC_DATA_ATTR RtcSnapshot rtcSnapshot;
+
+uint32_t snapshotCrc(const RtcSnapshot& snapshot) {
+    return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&snapshot), offsetof(RtcSnapshot, crc));
+}
+
+int64_t wallClockSeconds() {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    return tv.tv_sec;
+}
+
+template <size_t N>
+void putString(char (&dest)[N], const String& value) {
+    strlcpy(dest, value.c_str(), N);
+}
+
+template <size_t N>
+String getString(const char (&src)[N]) {
+    String value;
+    value.concat(src, strnlen(src, N));
+    return value;
+}
+
+}  // namespace
+
+void RtcState::pack(const RuntimeState& state, int64_t now, RtcSnapshot& snapshot) {
+    memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.magic = RTC_MAGIC;
+    snapshot.version = RTC_VERSION;
+    putString(snapshot.deviceUuid, state.deviceUuid);
+    putString(snapshot.deviceName, state.deviceName);
+    putString(snapshot.deviceIP, state.deviceIP);
+    putString(snapshot.coordinatorUuid, state.coordinatorUuid);
+    putString(snapshot.coordinatorIP, state.coordinatorIP);
+    putString(snapshot.localIP, state.localIP);
+    putString(snapshot.title, state.track.title);
+    putString(snapshot.artist, state.track.artist);
+    putString(snapshot.album, state.track.album);
+    putString(snapshot.playbackState, state.track.playbackState);
+    snapshot.position = state.track.position;
+    snapshot.duration = state.track.duration;
+    snapshot.volume = state.track.volume;
+    snapshot.savedAt = now;
+
+    for (const auto& sub : state.subscriptions) {
+        // A SID that would not fit is useless truncated; it gets a fresh subscription on wake instead
+        if (snapshot.subscriptionCount == RtcSnapshot::MAX_SUBSCRIPTIONS ||
+            sub.sid.length() >= sizeof(RtcSnapshot::Subscription::sid)) {
+            continue;
+        }
+        RtcSnapshot::Subscription& slot = snapshot.subscriptions[snapshot.subscriptionCount++];
+        putString(slot.ip, sub.ip);
+        putString(slot.service, sub.service);
+        putString(slot.sid, sub.sid);
+        slot.expiresAt = now + sub.secondsLeft;
+    }
+    snapshot.crc = snapshotCrc(snapshot);
+}
+
+bool RtcState::unpack(const RtcSnapshot& snapshot, int64_t now, RuntimeState& state) {
+    if (snapshot.magic != RTC_MAGIC || snapshot.version != RTC_VERSION ||
+        snapshot.subscriptionCount > RtcSnapshot::MAX_SUBSCRIPTIONS || snapshot.crc != snapshotCrc(snapshot) ||
+        snapshot.deviceUuid[0] == '\0') {
+        return false;
+    }
+
+    state.deviceUuid = getString(snapshot.deviceUuid);
+    state.deviceName = getString(snapshot.deviceName);
+    state.deviceIP = getString(snapshot.deviceIP);
+    state.coordinatorUuid = getString(snapshot.coordinatorUuid);
+    state.coordinatorIP = getString(snapshot.coordinatorIP);
+    state.localIP = getString(snapshot.localIP);
+    state.track.title = getString(snapshot.title);
+    state.track.artist = getString(snapshot.artist);
+    state.track.album = getString(snapshot.album);
+    state.track.albumArtUrl = "";
+    state.track.playbackState = getString(snapshot.playbackState);
+    state.track.position = snapshot.position;
+    state.track.duration = snapshot.duration;
+    state.track.volume = snapshot.volume;
+
+    state.subscriptions.clear();
+    for (uint8_t i = 0; i < snapshot.subscriptionCount; i++) {
+        const RtcSnapshot::Subscription& slot = snapshot.subscriptions[i];
+        int64_t secondsLeft = slot.expiresAt - now;
+        if (secondsLeft <= (int64_t)EXPIRY_MARGIN_SECONDS) continue;
+        state.subscriptions.push_back({getString(slot.ip), getString(slot.service), getString(slot.sid), (uint32_t)secondsLeft});
+    }
+    return true;
+}
+
+void RtcState::save(const RuntimeState& state) {
+    pack(state, wallClockSeconds(), rtcSnapshot);
+}
+
+bool RtcState::restore(RuntimeState& state) {
+    // RTC slow memory holds garbage after power-on; only a deep-sleep wake is worth trying
+    if (esp_sleep_get_wakeup_cause() == ESP_SLEEP_WAKEUP_UNDEFINED) return false;
+
+    int64_t now = wallClockSeconds();
+    if (!unpack(rtcSnapshot, now, state)) {
+        LOG_WARN("core", "RTC snapshot invalid; cold start");
+        return false;
+    }
+    LOG_INFO("core", "Restored RTC snapshot for " + state.deviceName + " after " + String((long)(now - rtcSnapshot.savedAt)) +
+             " s asleep (" + String(state.subscriptions.size()) + " of " + String(rtcSnapshot.subscriptionCount) +
+             " subscriptions still live)");
+    return true;
+}
+
+void RtcState::clear() {
+    memset(&rtcSnapshot, 0, sizeof(rtcSnapshot));
+}
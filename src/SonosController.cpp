@@ -97,11 +97,16 @@ void SonosController::setVolume(const String& ip, int volume) {
 }
 
 void SonosController::volumeUp(const String& ip) {
-    _sonos.increaseVolume(ip, 5);
+    // A grouped speaker moves the whole group, as the Sonos app does
+    int groupVolume;
+    if (_sonos.isGrouped(ip)) _sonos.adjustGroupVolume(ip, 5, groupVolume);
+    else _sonos.increaseVolume(ip, 5);
 }
 
 void SonosController::volumeDown(const String& ip) {
-    _sonos.decreaseVolume(ip, 5);
+    int groupVolume;
+    if (_sonos.isGrouped(ip)) _sonos.adjustGroupVolume(ip, -5, groupVolume);
+    else _sonos.decreaseVolume(ip, 5);
 }
 
 static bool isPlayingState(const String& state) {
@@ -158,6 +163,28 @@ static String multiUnescape(String s) {
     return s;
 }
 
+// DIDL-Lite item fields; anything missing is left empty
+static void parseTrackMetadata(String meta, TrackData& track) {
+    meta = multiUnescape(meta);
+
+    auto getTag = [](const String& m, const String& t) {
+        SonosXmlParser::XmlLookupResult r = SonosXmlParser::findTagValue(m, t);
+        return r.success ? r.value : "";
+    };
+
+    track.title = getTag(meta, "title");
+    if (!track.title.length()) track.title = getTag(meta, "dc:title");
+
+    track.artist = getTag(meta, "creator");
+    if (!track.artist.length()) track.artist = getTag(meta, "dc:creator");
+
+    track.album = getTag(meta, "album");
+    if (!track.album.length()) track.album = getTag(meta, "upnp:album");
+
+    track.albumArtUrl = getTag(meta, "albumArtURI");
+    if (!track.albumArtUrl.length()) track.albumArtUrl = getTag(meta, "upnp:albumArtURI");
+}
+
 void SonosController::parseEvent(const String& xml) {
     LOG_DEBUG("control", "Event received: " + xml);
 
@@ -229,35 +256,26 @@ void SonosController::parseEvent(const String& xml) {
     // 5. Metadata (title, artist, album, art)
     String meta = extractVal(lastChange, "CurrentTrackMetaData");
     if (meta.length()) {
-        meta = multiUnescape(meta);
-        
-        auto getTag = [](const String& m, const String& t) {
-            SonosXmlParser::XmlLookupResult r = SonosXmlParser::findTagValue(m, t);
-            return r.success ? r.value : "";
-        };
-
-        String t = getTag(meta, "title");
-        if (!t.length()) t = getTag(meta, "dc:title");
-        
-        String a = getTag(meta, "creator");
-        if (!a.length()) a = getTag(meta, "dc:creator");
-        
-        String alb = getTag(meta, "album");
-        if (!alb.length()) alb = getTag(meta, "upnp:album");
-        
-        String art = getTag(meta, "albumArtURI");
-        if (!art.length()) art = getTag(meta, "upnp:albumArtURI");
-
-        if (t.length()) {
-            if (t != _currentTrack.title) {
+        TrackData parsed;
+        parseTrackMetadata(meta, parsed);
+        if (parsed.title.length()) {
+            if (parsed.title != _currentTrack.title) {
                 _currentTrack.position = 0;
                 _positionRemainderMs = 0;
             }
-            _currentTrack.title = t;
-            LOG_DEBUG("control", "Parsed title: " + t);
+            _currentTrack.title = parsed.title;
+            LOG_DEBUG("control", "Parsed title: " + parsed.title);
         }
-        if (a.length()) _currentTrack.artist = a;
-        if (alb.length()) _currentTrack.album = alb;
-        if (art.length()) _currentTrack.albumArtUrl = art;
+        if (parsed.artist.length()) _currentTrack.artist = parsed.artist;
+        if (parsed.album.length()) _currentTrack.album = parsed.album;
+        if (parsed.albumArtUrl.length()) _currentTrack.albumArtUrl = parsed.albumArtUrl;
+    }
+
+    // 6. Next track, so its art can be prefetched; an empty value means nothing is queued
+    SonosXmlParser::XmlLookupResult next = SonosXmlParser::findAttributeValue(lastChange, "NextTrackMetaData", "val");
+    if (next.success) {
+        _nextTrack = TrackData();
+        if (next.value.length()) parseTrackMetadata(next.value, _nextTrack);
+        if (_nextTrack.title.length()) LOG_DEBUG("control", "Parsed next title: " + _nextTrack.title);
     }
 }
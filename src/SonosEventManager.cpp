@@ -2,6 +2,15 @@
 #include "AppLogger.h"
 #include <WiFi.h>
 
+namespace {
+
+String eventPath(const String& service) {
+    if (service == "ZoneGroupTopology") return "/ZoneGroupTopology/Event";
+    return "/MediaRenderer/" + service + "/Event";
+}
+
+}  // namespace
+
 SonosEventManager::SonosEventManager(int port) : _port(port), _server(port) {}
 
 void SonosEventManager::begin() {
@@ -15,7 +24,7 @@ void SonosEventManager::update() {
     // Check for renewals (every 4.5 minutes for a 5 min subscription)
     unsigned long now = millis();
     for (auto& sub : _subscriptions) {
-        if (now - sub.lastRenewal > 270000) { // 4.5 minutes
+        if (now - sub.lastRenewal > RENEW_AFTER_MS) {
             sendSubscribeRequest(sub, true);
         }
     }
@@ -83,7 +92,7 @@ bool SonosEventManager::sendSubscribeRequest(Subscription& sub, bool isRenewal)
         return false;
     }
 
-    String path = "/MediaRenderer/" + sub.service + "/Event";
+    String path = eventPath(sub.service);
     String callback = "<http://" + WiFi.localIP().toString() + ":" + String(_port) + "/>";
 
     client.println("SUBSCRIBE " + path + " HTTP/1.1");
@@ -95,7 +104,7 @@ bool SonosEventManager::sendSubscribeRequest(Subscription& sub, bool isRenewal)
         client.println("CALLBACK: " + callback);
         client.println("NT: upnp:event");
     }
-    client.println("TIMEOUT: Second-300");
+    client.println("TIMEOUT: Second-" + String(SUBSCRIPTION_SECONDS));
     client.println();
 
     // Parse SID from response if not a renewal
@@ -121,7 +130,7 @@ void SonosEventManager::unsubscribe(const String& deviceIP, const String& servic
         if (it->ip == deviceIP && it->service == service) {
             WiFiClient client;
             if (client.connect(deviceIP.c_str(), 1400)) {
-                String path = "/MediaRenderer/" + service + "/Event";
+                String path = eventPath(service);
                 client.println("UNSUBSCRIBE " + path + " HTTP/1.1");
                 client.println("HOST: " + deviceIP + ":1400");
                 client.println("SID: " + it->sid);
@@ -134,3 +143,42 @@ void SonosEventManager::unsubscribe(const String& deviceIP, const String& servic
     }
 }
 
+
+void SonosEventManager::updateDeviceAddress(const String& oldIP, const String& newIP) {
+    for (auto& sub : _subscriptions) {
+        if (sub.ip != oldIP) continue;
+        sub.ip = newIP;
+        sub.sid = "";
+        if (sendSubscribeRequest(sub)) {
+            LOG_INFO("events", "Moved " + sub.service + " subscription from " + oldIP + " to " + newIP);
+        }
+    }
+}
+
+std::vector<SonosEventManager::SubscriptionState> SonosEventManager::getSubscriptions() const {
+    std::vector<SubscriptionState> states;
+    unsigned long now = millis();
+    for (const auto& sub : _subscriptions) {
+        unsigned long elapsed = (now - sub.lastRenewal) / 1000;
+        if (sub.sid.length() == 0 || elapsed >= SUBSCRIPTION_SECONDS) continue;
+        states.push_back({sub.ip, sub.service, sub.sid, (uint32_t)(SUBSCRIPTION_SECONDS - elapsed)});
+    }
+    return states;
+}
+
+void SonosEventManager::restoreSubscription(const SubscriptionState& state) {
+    for (const auto& sub : _subscriptions) {
+        if (sub.ip == state.ip && sub.service == state.service) return;
+    }
+
+    Subscription sub;
+    sub.ip = state.ip;
+    sub.service = state.service;
+    sub.sid = state.sid;
+    sub.expiry = 0;
+    // Back-date the renewal so update() renews at the usual point before the speaker drops it
+    uint32_t secondsLeft = min(state.secondsLeft, (uint32_t)SUBSCRIPTION_SECONDS);
+    sub.lastRenewal = millis() - (SUBSCRIPTION_SECONDS - secondsLeft) * 1000;
+    _subscriptions.push_back(sub);
+    LOG_INFO("events", "Restored " + state.service + " subscription on " + state.ip + " (" + String(secondsLeft) + " s left)");
+}
@@ -76,6 +76,8 @@ void SpeakerList::drawDeviceRow(int index, const SonosDevice& device, int y, boo
     tft.setTextColor(0x7BEF);
     tft.setCursor(16, y + 16);
     tft.print(device.ip);
+    if (device.reachability == SonosReachability::STALE) tft.print(" (offline)");
+    else if (device.reachability == SonosReachability::MOVED) tft.print(" (moved)");
 }
 
 void SpeakerList::drawScanButton(int y, bool isSelected) {
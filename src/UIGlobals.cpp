@@ -8,18 +8,26 @@ int16_t centerX(const char* text, uint8_t textSize) {
     return x;
 }
 
-int16_t printCenteredWrapped(Adafruit_GFX& gfx, const char* text, int16_t y, uint16_t w, uint8_t textSize) {
+int16_t layoutCenteredWrapped(const char* text, int16_t y, uint16_t w, uint8_t textSize, uint16_t color,
+                              std::vector<TextLine>& lines) {
     String str = String(text);
     int len = str.length();
     if (len == 0) return y;
 
-    gfx.setTextSize(textSize);
-    gfx.setTextWrap(false); // We handle wrapping manually
-
     int16_t charWidth = 6 * textSize;
     int16_t lineHeight = 8 * textSize;
     int16_t maxChars = w / charWidth;
 
+    auto addLine = [&](const String& line, int16_t x) {
+        lines.push_back({line, x, y, textSize, color});
+        y += lineHeight;
+    };
+    auto centered = [&](const String& line) {
+        int32_t lineWidth = (int32_t)line.length() * charWidth;
+        int16_t x = (w - lineWidth) / 2;
+        return x < 0 ? (int16_t)0 : x;
+    };
+
     String currentLine = "";
     int start = 0;
     
@@ -34,20 +42,12 @@ int16_t printCenteredWrapped(Adafruit_GFX& gfx, const char* text, int16_t y, uin
             currentLine += word;
         } else {
             if (currentLine.length() > 0) {
-                int32_t lineWidth = (int32_t)currentLine.length() * charWidth;
-                int16_t x = (w - lineWidth) / 2;
-                if (x < 0) x = 0;
-                gfx.setCursor(x, y);
-                gfx.print(currentLine);
-                y += lineHeight;
+                addLine(currentLine, centered(currentLine));
                 currentLine = word;
             } else {
                 // Word is huge, split it
                 while (word.length() > maxChars) {
-                    String part = word.substring(0, maxChars);
-                    gfx.setCursor(0, y); // Full width, so x=0
-                    gfx.print(part);
-                    y += lineHeight;
+                    addLine(word.substring(0, maxChars), 0);  // Full width, so x=0
                     word = word.substring(maxChars);
                 }
                 currentLine = word;
@@ -57,13 +57,31 @@ int16_t printCenteredWrapped(Adafruit_GFX& gfx, const char* text, int16_t y, uin
     }
     
     if (currentLine.length() > 0) {
-        int32_t lineWidth = (int32_t)currentLine.length() * charWidth;
-        int16_t x = (w - lineWidth) / 2;
-        if (x < 0) x = 0;
-        gfx.setCursor(x, y);
-        gfx.print(currentLine);
-        y += lineHeight;
+        addLine(currentLine, centered(currentLine));
     }
     
     return y;
 }
+
+void printLines(Adafruit_GFX& gfx, const std::vector<TextLine>& lines) {
+    gfx.setTextWrap(false); // Lines are already wrapped
+    for (const auto& line : lines) {
+        gfx.setTextSize(line.textSize);
+        gfx.setTextColor(line.color);
+        gfx.setCursor(line.x, line.y);
+        gfx.print(line.text);
+    }
+}
+
+int16_t printCenteredWrapped(Adafruit_GFX& gfx, const char* text, int16_t y, uint16_t w, uint8_t textSize) {
+    std::vector<TextLine> lines;
+    y = layoutCenteredWrapped(text, y, w, textSize, 0, lines);
+
+    gfx.setTextSize(textSize);
+    gfx.setTextWrap(false); // We handle wrapping manually
+    for (const auto& line : lines) {
+        gfx.setCursor(line.x, line.y);
+        gfx.print(line.text);
+    }
+    return y;
+}
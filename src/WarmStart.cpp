@@ -0,0 +1,151 @@
+#include "WarmStart.h"
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include "NowPlaying.h"
+#include "AppLogger.h"
+
+const char* WarmStart::SNAPSHOT_FILE = "/warm_start.bin";
+const char* WarmStart::TEMP_FILE = "/warm_start.tmp";
+
+namespace {
+
+const uint32_t SNAPSHOT_MAGIC = 0x4d525753;  // "SWRM" little-endian
+const uint16_t SNAPSHOT_VERSION = 1;
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t thumbSize;     // Edge of the square thumbnail; 0 when absent
+    uint32_t payloadBytes;  // Strings and integers, followed by the thumbnail pixels
+    uint32_t crc;           // CRC32 of the payload
+};
+
+void putString(std::vector<uint8_t>& out, const String& value) {
+    uint16_t len = min(value.length(), (unsigned int)0xFFFF);
+    out.push_back(len & 0xFF);
+    out.push_back(len >> 8);
+    out.insert(out.end(), value.c_str(), value.c_str() + len);
+}
+
+void putInt(std::vector<uint8_t>& out, int32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back((value >> (8 * i)) & 0xFF);
+}
+
+bool getString(const std::vector<uint8_t>& in, size_t& pos, String& value) {
+    if (pos + 2 > in.size()) return false;
+    uint16_t len = in[pos] | (in[pos + 1] << 8);
+    pos += 2;
+    if (pos + len > in.size()) return false;
+    value = "";
+    value.concat(reinterpret_cast<const char*>(in.data() + pos), len);
+    pos += len;
+    return true;
+}
+
+bool getInt(const std::vector<uint8_t>& in, size_t& pos, int& value) {
+    if (pos + 4 > in.size()) return false;
+    uint32_t raw = 0;
+    for (int i = 0; i < 4; i++) raw |= (uint32_t)in[pos + i] << (8 * i);
+    value = (int32_t)raw;
+    pos += 4;
+    return true;
+}
+
+}  // namespace
+
+bool WarmStart::load(WarmStartSnapshot& snapshot) {
+    unsigned long start = micros();
+    if (!LittleFS.exists(SNAPSHOT_FILE)) return false;
+
+    File file = LittleFS.open(SNAPSHOT_FILE, "r");
+    if (!file) return false;
+
+    SnapshotHeader header;
+    bool headerOk = file.read(reinterpret_cast<uint8_t*>(&header), sizeof(header)) == sizeof(header) &&
+                    header.magic == SNAPSHOT_MAGIC && header.version == SNAPSHOT_VERSION &&
+                    (header.thumbSize == 0 || header.thumbSize == NowPlaying::THUMB_SIZE) && header.payloadBytes <= 16384;
+    if (!headerOk) {
+        file.close();
+        LOG_WARN("cache", "Warm-start snapshot header invalid; ignoring it");
+        return false;
+    }
+
+    std::vector<uint8_t> payload(header.payloadBytes);
+    size_t read = file.read(payload.data(), payload.size());
+    file.close();
+    if (read != payload.size() || esp_rom_crc32_le(0, payload.data(), payload.size()) != header.crc) {
+        LOG_WARN("cache", "Warm-start snapshot truncated or corrupt; ignoring it");
+        return false;
+    }
+
+    size_t pos = 0;
+    TrackData& track = snapshot.track;
+    bool ok = getString(payload, pos, snapshot.deviceUuid) && getString(payload, pos, snapshot.deviceName) &&
+              getString(payload, pos, snapshot.deviceIP) && getString(payload, pos, track.title) &&
+              getString(payload, pos, track.artist) && getString(payload, pos, track.album) &&
+              getString(payload, pos, track.albumArtUrl) && getString(payload, pos, track.playbackState) &&
+              getInt(payload, pos, track.position) && getInt(payload, pos, track.duration) && getInt(payload, pos, track.volume);
+
+    size_t thumbBytes = (size_t)header.thumbSize * header.thumbSize * sizeof(uint16_t);
+    if (!ok || pos + thumbBytes != payload.size()) {
+        LOG_WARN("cache", "Warm-start snapshot payload malformed; ignoring it");
+        return false;
+    }
+    snapshot.thumbnail.resize(thumbBytes / sizeof(uint16_t));
+    if (thumbBytes > 0) memcpy(snapshot.thumbnail.data(), payload.data() + pos, thumbBytes);
+
+    LOG_INFO("cache", "Loaded warm-start snapshot for " + snapshot.deviceName + " in " + String(micros() - start) + " us");
+    return true;
+}
+
+bool WarmStart::save(const WarmStartSnapshot& snapshot) {
+    bool hasThumb = snapshot.thumbnail.size() == (size_t)NowPlaying::THUMB_SIZE * NowPlaying::THUMB_SIZE;
+
+    std::vector<uint8_t> payload;
+    payload.reserve(256 + (hasThumb ? snapshot.thumbnail.size() * sizeof(uint16_t) : 0));
+    const TrackData& track = snapshot.track;
+    putString(payload, snapshot.deviceUuid);
+    putString(payload, snapshot.deviceName);
+    putString(payload, snapshot.deviceIP);
+    putString(payload, track.title);
+    putString(payload, track.artist);
+    putString(payload, track.album);
+    putString(payload, track.albumArtUrl);
+    putString(payload, track.playbackState);
+    putInt(payload, track.position);
+    putInt(payload, track.duration);
+    putInt(payload, track.volume);
+    if (hasThumb) {
+        const uint8_t* pixels = reinterpret_cast<const uint8_t*>(snapshot.thumbnail.data());
+        payload.insert(payload.end(), pixels, pixels + snapshot.thumbnail.size() * sizeof(uint16_t));
+    }
+
+    SnapshotHeader header;
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    header.thumbSize = hasThumb ? NowPlaying::THUMB_SIZE : 0;
+    header.payloadBytes = payload.size();
+    header.crc = esp_rom_crc32_le(0, payload.data(), payload.size());
+
+    _dirty = false;
+    _lastSaveMs = millis();
+
+    File file = LittleFS.open(TEMP_FILE, "w");
+    if (!file) return false;
+    size_t written = file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+    written += file.write(payload.data(), payload.size());
+    file.close();
+
+    if (written != sizeof(header) + payload.size() || !LittleFS.rename(TEMP_FILE, SNAPSHOT_FILE)) {
+        LittleFS.remove(TEMP_FILE);
+        LOG_WARN("cache", "Failed to write warm-start snapshot");
+        return false;
+    }
+    LOG_DEBUG("cache", "Saved warm-start snapshot (" + String(written) + " bytes)");
+    return true;
+}
+
+void WarmStart::clear() {
+    _dirty = false;
+    if (LittleFS.exists(SNAPSHOT_FILE)) LittleFS.remove(SNAPSHOT_FILE);
+}
@@ -0,0 +1,81 @@
+#include "WiFiCache.h"
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include "AppLogger.h"
+
+const char* WiFiCache::CACHE_FILE = "/wifi_ap.bin";
+
+namespace {
+
+const uint32_t WIFI_MAGIC = 0x49464957;  // "WIFI" little-endian
+const uint16_t WIFI_VERSION = 2;
+
+struct WiFiRecord {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t crc;  // CRC32 of everything above
+};
+
+static_assert(sizeof(WiFiRecord) == 20, "wifi record layout changed; bump WIFI_VERSION");
+
+uint32_t recordCrc(const WiFiRecord& record) {
+    return esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(&record), offsetof(WiFiRecord, crc));
+}
+
+}  // namespace
+
+bool WiFiCache::load(WiFiConnectionInfo& info) {
+    File file = LittleFS.open(CACHE_FILE, "r");
+    if (!file) return false;
+
+    WiFiRecord record;
+    bool ok = file.read(reinterpret_cast<uint8_t*>(&record), sizeof(record)) == sizeof(record) &&
+              record.magic == WIFI_MAGIC && record.version == WIFI_VERSION && record.crc == recordCrc(record) &&
+              record.channel > 0 && record.channel <= 14;
+    file.close();
+    if (!ok) {
+        LOG_WARN("wifi", "Cached access point invalid; ignoring it");
+        return false;
+    }
+
+    memcpy(info.bssid, record.bssid, sizeof(info.bssid));
+    info.channel = record.channel;
+    _lastCrc = record.crc;
+    _hasLastCrc = true;
+    return true;
+}
+
+bool WiFiCache::save(const WiFiConnectionInfo& info) {
+    WiFiRecord record;
+    memset(&record, 0, sizeof(record));
+    record.magic = WIFI_MAGIC;
+    record.version = WIFI_VERSION;
+    memcpy(record.bssid, info.bssid, sizeof(record.bssid));
+    record.channel = info.channel;
+    record.crc = recordCrc(record);
+
+    // Same AP as last boot is the common case
+    if (_hasLastCrc && record.crc == _lastCrc) return true;
+
+    File file = LittleFS.open(CACHE_FILE, "w");
+    if (!file) return false;
+    size_t written = file.write(reinterpret_cast<const uint8_t*>(&record), sizeof(record));
+    file.close();
+    if (written != sizeof(record)) {
+        LittleFS.remove(CACHE_FILE);
+        LOG_WARN("wifi", "Failed to write cached access point");
+        return false;
+    }
+
+    _lastCrc = record.crc;
+    _hasLastCrc = true;
+    LOG_DEBUG("wifi", "Cached access point on channel " + String(info.channel));
+    return true;
+}
+
+void WiFiCache::clear() {
+    _hasLastCrc = false;
+    if (LittleFS.exists(CACHE_FILE)) LittleFS.remove(CACHE_FILE);
+}
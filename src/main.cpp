@@ -5,6 +5,7 @@
 #include <Adafruit_MCP23X17.h>
 #include <Sonos.h>
 #include <vector>
+#include <esp_sleep.h>
 #include "NowPlaying.h"
 #include "SpeakerList.h"
 #include "secrets.h"
@@ -14,6 +15,12 @@
 #include "DiscoveryManager.h"
 #include "AppLogger.h"
 #include "SonosEventManager.h"
+#include "WarmStart.h"
+#include "ArtCache.h"
+#include "ArtTileCache.h"
+#include "ArtWorker.h"
+#include "WiFiCache.h"
+#include "RtcState.h"
 
 #define TFT_CS  D3
 #define TFT_DC  D2
@@ -27,6 +34,15 @@
 #define BTN_VUP   12
 #define BTN_VDOWN 11
 
+// Build with -DENABLE_DEEP_SLEEP=1 to sleep after a spell of inactivity on Now Playing.
+// The MCP23017 INTA output must be wired to DEEP_SLEEP_WAKE_PIN (an RTC-capable GPIO).
+#ifndef ENABLE_DEEP_SLEEP
+#define ENABLE_DEEP_SLEEP 0
+#endif
+#ifndef DEEP_SLEEP_WAKE_PIN
+#define DEEP_SLEEP_WAKE_PIN 1  // D0 on the XIAO ESP32-S3
+#endif
+
 Adafruit_ST7789 tft = Adafruit_ST7789(TFT_CS, TFT_DC, TFT_RST);
 Adafruit_MCP23X17 mcp;
 Sonos sonos;
@@ -36,10 +52,26 @@ DeviceCache deviceCache;
 SonosController sonosController(sonos);
 DiscoveryManager discoveryManager(sonos, deviceCache);
 SonosEventManager eventManager(8080);
+WarmStart warmStart;
+ArtCache artCache;
+ArtTileCache artTileCache;
+ArtWorker artWorker(artCache);
+WiFiCache wifiCache;
 ButtonHandler buttons(mcp, BTN_UP, BTN_DOWN, BTN_CLICK, BTN_VUP, BTN_VDOWN);
 
 int selectedIndex = 0;
-IPAddress selectedDeviceIP;
+// Devices are identified by UUID; the IP is resolved on every use so DHCP moves are picked up
+String selectedDeviceUuid = "";
+String selectedDeviceLastIP = "";
+// AVTransport is subscribed on the group coordinator, which may not be the selected speaker
+String subscribedTransportIP = "";
+String selectedDeviceName = "";
+// Set when Now Playing was restored at boot and still needs its event subscriptions
+bool pendingNowPlayingSubscribe = false;
+// SIDs still live after a deep-sleep wake, and the address their callbacks point at
+std::vector<SonosEventManager::SubscriptionState> rtcSubscriptions;
+String rtcLocalIP = "";
+const unsigned long IDLE_SLEEP_MS = 120000;
 
 // UI tracking
 String lastAlbumArtUrl = "";
@@ -74,6 +106,57 @@ WiFiState wifiState = WIFI_DISCONNECTED;
 WiFiState previousWifiState = WIFI_DISCONNECTED;
 unsigned long wifiConnectStartTime = 0;
 const unsigned long WIFI_TIMEOUT = 30000; // 30 seconds timeout
+const unsigned long DIRECTED_WIFI_TIMEOUT = 5000;  // Before falling back to a full scan
+WiFiConnectionInfo cachedAp;
+bool hasCachedAp = false;
+bool directedWiFiAttempt = false;
+// Set from the WiFi event task
+volatile unsigned long wifiAssociatedMs = 0;
+volatile unsigned long wifiGotIpMs = 0;
+
+String selectedDeviceIP() {
+    SonosDevice* device = sonos.getDeviceByUuid(selectedDeviceUuid);
+    if (device != nullptr) selectedDeviceLastIP = device->ip;
+    return selectedDeviceLastIP;
+}
+
+// Moves the AVTransport subscription when the selected speaker joins or leaves a group
+void followCoordinator() {
+    if (currentScreen != SCREEN_NOW_PLAYING) return;
+    String coordinatorIP = sonos.getCoordinatorIP(selectedDeviceIP());
+    if (coordinatorIP == subscribedTransportIP) return;
+
+    LOG_INFO("core", "Coordinator changed from " + subscribedTransportIP + " to " + coordinatorIP);
+    eventManager.unsubscribe(subscribedTransportIP, "AVTransport");
+    subscribedTransportIP = coordinatorIP;
+    eventManager.subscribe(subscribedTransportIP, "AVTransport");
+    needsInitialNowPlayingFetch = true;
+    lastInitialFetchAttemptMs = 0;
+}
+
+// Takes over a subscription that survived deep sleep instead of subscribing again
+bool adoptRtcSubscription(const String& ip, const String& service) {
+    for (const auto& sub : rtcSubscriptions) {
+        if (sub.ip != ip || sub.service != service) continue;
+        eventManager.restoreSubscription(sub);
+        return true;
+    }
+    return false;
+}
+
+// The topology decides which speaker owns the transport
+void subscribeSelectedDevice() {
+    String deviceIP = selectedDeviceIP();
+    // Callbacks in SIDs taken before sleep point at our old address if DHCP gave us a new one
+    if (rtcLocalIP != WiFi.localIP().toString()) rtcSubscriptions.clear();
+    // After a wake the topology was seeded from RTC memory and ZoneGroupTopology events keep it current
+    if (rtcSubscriptions.empty()) sonos.refreshTopology(deviceIP);
+    subscribedTransportIP = sonos.getCoordinatorIP(deviceIP);
+    if (!adoptRtcSubscription(subscribedTransportIP, "AVTransport")) eventManager.subscribe(subscribedTransportIP, "AVTransport");
+    if (!adoptRtcSubscription(deviceIP, "RenderingControl")) eventManager.subscribe(deviceIP, "RenderingControl");
+    if (!adoptRtcSubscription(deviceIP, "ZoneGroupTopology")) eventManager.subscribe(deviceIP, "ZoneGroupTopology");
+    rtcSubscriptions.clear();
+}
 
 template <size_t N>
 static String formatChannelList(const char* const (&channels)[N], bool shouldDisplay = true) {
@@ -87,28 +170,58 @@ static String formatChannelList(const char* const (&channels)[N], bool shouldDis
 }
 
 void startWiFiConnection() {
-    LOG_INFO("wifi", "Starting WiFi connection");
     WiFi.persistent(true);
     WiFi.mode(WIFI_STA);
+    wifiAssociatedMs = 0;
+    wifiGotIpMs = 0;
+    directedWiFiAttempt = hasCachedAp;
 #if USE_STATIC_IP
     WiFi.config(STATIC_IP, GATEWAY, SUBNET);
 #endif
-    WiFi.begin(ssid, password);
+    // Only the scan is skipped; the address always comes from DHCP so a changed lease is never reused
+    if (directedWiFiAttempt) {
+        LOG_INFO("wifi", "Starting directed WiFi connection on channel " + String(cachedAp.channel));
+        WiFi.begin(ssid, password, cachedAp.channel, cachedAp.bssid);
+    } else {
+        LOG_INFO("wifi", "Starting WiFi connection");
+        WiFi.begin(ssid, password);
+    }
     WiFi.setAutoReconnect(true);
     wifiState = WIFI_CONNECTING;
     wifiConnectStartTime = millis();
 }
 
+void rememberAccessPoint() {
+    const uint8_t* bssid = WiFi.BSSID();
+    if (bssid == nullptr) return;
+    memcpy(cachedAp.bssid, bssid, sizeof(cachedAp.bssid));
+    cachedAp.channel = WiFi.channel();
+    hasCachedAp = wifiCache.save(cachedAp);
+}
+
 void checkWiFiConnection() {
     if (wifiState == WIFI_CONNECTING) {
         if (WiFi.status() == WL_CONNECTED) {
             wifiState = WIFI_CONNECTED;
-            LOG_INFO("wifi", "WiFi connected: " + WiFi.localIP().toString());
+            unsigned long associatedMs = wifiAssociatedMs, gotIpMs = wifiGotIpMs;
+            LOG_INFO("wifi", "WiFi connected: " + WiFi.localIP().toString() + " (" +
+                     (directedWiFiAttempt ? "directed" : "full scan") + ", associated after " +
+                     String(associatedMs > 0 ? associatedMs - wifiConnectStartTime : 0) + " ms, IP after " +
+                     String(gotIpMs > 0 ? gotIpMs - wifiConnectStartTime : millis() - wifiConnectStartTime) +
+                     " ms, " + String(millis()) + " ms since boot)");
+            rememberAccessPoint();
             sonos.begin();
             eventManager.begin();
-        } else if (millis() - wifiConnectStartTime > WIFI_TIMEOUT) {
+        } else if (millis() - wifiConnectStartTime > (directedWiFiAttempt ? DIRECTED_WIFI_TIMEOUT : WIFI_TIMEOUT)) {
             wifiState = WIFI_DISCONNECTED;
-            LOG_WARN("wifi", "WiFi connect timeout, retrying");
+            if (directedWiFiAttempt) {
+                // The AP moved channel or was replaced
+                LOG_WARN("wifi", "Directed WiFi connect failed, falling back to a full scan");
+                hasCachedAp = false;
+                wifiCache.clear();
+            } else {
+                LOG_WARN("wifi", "WiFi connect timeout, retrying");
+            }
             WiFi.disconnect();
             delay(100);
             startWiFiConnection();
@@ -136,16 +249,18 @@ void handleSpeakerListNavigation() {
 
     if (buttons.clickPressed()) {
         if (selectedIndex < (int)devices.size()) {
-            selectedDeviceIP.fromString(devices[selectedIndex].ip.c_str());
+            selectedDeviceUuid = devices[selectedIndex].uuid;
+            selectedDeviceLastIP = devices[selectedIndex].ip;
+            selectedDeviceName = devices[selectedIndex].name;
             currentScreen = SCREEN_NOW_PLAYING;
             forcePositionSync = true;
             lastPositionSyncMs = 0;
             needsInitialNowPlayingFetch = true;
             lastInitialFetchAttemptMs = 0;
 
-            // Subscribe to events
-            eventManager.subscribe(selectedDeviceIP.toString(), "AVTransport");
-            eventManager.subscribe(selectedDeviceIP.toString(), "RenderingControl");
+            subscribeSelectedDevice();
+            pendingNowPlayingSubscribe = false;
+            warmStart.markDirty();
 
             // Full redraw reset
             lastAlbumArtUrl = lastTitle = lastArtist = lastAlbum = lastPlaybackState = "";
@@ -171,13 +286,17 @@ void handleSpeakerListNavigation() {
 }
 void handleNowPlayingNavigation() {
     if (buttons.clickPressed()) {
-        sonosController.togglePlayPause(selectedDeviceIP.toString());
+        sonosController.togglePlayPause(selectedDeviceIP());
         return;
     }
 
     if (buttons.clickLongPressed()) {
-        eventManager.unsubscribe(selectedDeviceIP.toString(), "AVTransport");
-        eventManager.unsubscribe(selectedDeviceIP.toString(), "RenderingControl");
+        eventManager.unsubscribe(subscribedTransportIP, "AVTransport");
+        eventManager.unsubscribe(selectedDeviceIP(), "RenderingControl");
+        eventManager.unsubscribe(selectedDeviceIP(), "ZoneGroupTopology");
+        subscribedTransportIP = "";
+        pendingNowPlayingSubscribe = false;
+        warmStart.clear();
         forcePositionSync = false;
         needsInitialNowPlayingFetch = false;
         currentScreen = SCREEN_SPEAKER_LIST;
@@ -186,17 +305,17 @@ void handleNowPlayingNavigation() {
     }
 
     if (buttons.upPressed()) {
-        sonosController.next(selectedDeviceIP.toString());
+        sonosController.next(selectedDeviceIP());
     }
     if (buttons.downPressed()) {
-        sonosController.previous(selectedDeviceIP.toString());
+        sonosController.previous(selectedDeviceIP());
     }
 
     if (buttons.volUpPressed()) {
-        sonosController.volumeUp(selectedDeviceIP.toString());
+        sonosController.volumeUp(selectedDeviceIP());
     }
     if (buttons.volDownPressed()) {
-        sonosController.volumeDown(selectedDeviceIP.toString());
+        sonosController.volumeDown(selectedDeviceIP());
     }
 }
 
@@ -205,10 +324,15 @@ void updateNowPlayingScreen() {
     sonosController.tick();
     unsigned long nowMs = millis();
 
+    if (pendingNowPlayingSubscribe && sonos.isInitialized()) {
+        pendingNowPlayingSubscribe = false;
+        subscribeSelectedDevice();
+    }
+
     if (needsInitialNowPlayingFetch &&
         (lastInitialFetchAttemptMs == 0 || nowMs - lastInitialFetchAttemptMs >= INITIAL_FETCH_RETRY_INTERVAL_MS)) {
         lastInitialFetchAttemptMs = nowMs;
-        if (sonosController.update(selectedDeviceIP.toString())) {
+        if (sonosController.update(selectedDeviceIP())) {
             needsInitialNowPlayingFetch = false;
             forcePositionSync = false;
             lastPositionSyncMs = nowMs;
@@ -223,7 +347,7 @@ void updateNowPlayingScreen() {
     bool periodicSyncDue = isPlaying && (nowMs - lastPositionSyncMs >= POSITION_SYNC_INTERVAL_MS);
 
     if (forcePositionSync || periodicSyncDue) {
-        if (sonosController.refreshPosition(selectedDeviceIP.toString(), true)) {
+        if (sonosController.refreshPosition(selectedDeviceIP(), true)) {
             lastPositionSyncMs = nowMs;
         }
         forcePositionSync = false;
@@ -232,10 +356,15 @@ void updateNowPlayingScreen() {
     const auto& data = sonosController.getTrackData();
 
     if (data.title != lastTitle || data.artist != lastArtist || data.album != lastAlbum) {
+        // A prefetched next track swaps in text and art together
+        bool swapped = lastTitle.length() > 0 &&
+            nowPlaying.showStagedTrack(data.title.c_str(), data.artist.c_str(), data.album.c_str(), data.albumArtUrl.c_str());
         lastTitle = data.title;
         lastArtist = data.artist;
         lastAlbum = data.album;
-        nowPlaying.drawTrackInfo(data.title.c_str(), data.artist.c_str(), data.album.c_str());
+        if (swapped) lastAlbumArtUrl = data.albumArtUrl;
+        else nowPlaying.drawTrackInfo(data.title.c_str(), data.artist.c_str(), data.album.c_str());
+        warmStart.markDirty();
     }
 
     if (data.position != lastPositionSeconds || data.duration != lastDurationSeconds) {
@@ -246,18 +375,127 @@ void updateNowPlayingScreen() {
     if (data.volume != lastVolume) {
         lastVolume = data.volume;
         nowPlaying.drawVolume(data.volume);
+        warmStart.markDirty();
     }
     if (data.playbackState != lastPlaybackState) {
         lastPlaybackState = data.playbackState;
         nowPlaying.drawStatusBar(data.playbackState.c_str());
+        warmStart.markDirty();
     }
 
     if (data.albumArtUrl != lastAlbumArtUrl) {
         lastAlbumArtUrl = data.albumArtUrl;
         nowPlaying.drawAlbumArt(data.albumArtUrl.c_str());
+        warmStart.markDirty();
+    }
+
+    // With the current track on screen, get the next one ready
+    const auto& next = sonosController.getNextTrack();
+    if (next.title.length() > 0 && next.title != data.title &&
+        !nowPlaying.isStaged(next.title.c_str(), next.albumArtUrl.c_str())) {
+        nowPlaying.stageTrack(next.title.c_str(), next.artist.c_str(), next.album.c_str(), next.albumArtUrl.c_str());
+    }
+}
+
+void persistWarmStart() {
+    if (currentScreen != SCREEN_NOW_PLAYING || !warmStart.shouldSave()) return;
+
+    WarmStartSnapshot snapshot;
+    snapshot.deviceUuid = selectedDeviceUuid;
+    snapshot.deviceName = selectedDeviceName;
+    snapshot.deviceIP = selectedDeviceIP();
+    snapshot.track = sonosController.getTrackData();
+    nowPlaying.getArtThumbnail(snapshot.thumbnail);
+    warmStart.save(snapshot);
+}
+
+void showRestoredNowPlaying(const TrackData& data, const std::vector<uint16_t>& thumbnail) {
+    sonosController.setTrackData(data);
+    lastTitle = data.title;
+    lastArtist = data.artist;
+    lastAlbum = data.album;
+    lastPlaybackState = data.playbackState;
+    lastPositionSeconds = data.position;
+    lastDurationSeconds = data.duration;
+    lastVolume = data.volume;
+    lastAlbumArtUrl = "";  // Refetch full-size art over the thumbnail once connected
+
+    nowPlaying.drawStatic();
+    nowPlaying.drawStatusBar(data.playbackState.c_str());
+    nowPlaying.drawSpeakerInfo(selectedDeviceName.c_str());
+    nowPlaying.drawArtThumbnail(thumbnail);
+    nowPlaying.drawTrackInfo(data.title.c_str(), data.artist.c_str(), data.album.c_str());
+    nowPlaying.drawProgressBar(data.position, data.duration);
+    nowPlaying.drawVolume(data.volume);
+
+    currentScreen = SCREEN_NOW_PLAYING;
+    needsInitialNowPlayingFetch = true;
+    lastInitialFetchAttemptMs = 0;
+    pendingNowPlayingSubscribe = true;
+}
+
+// Draws the last Now Playing state straight from flash; the network reconciles it once Wi-Fi is up
+bool restoreWarmStart() {
+    WarmStartSnapshot snapshot;
+    if (!warmStart.load(snapshot) || snapshot.deviceUuid.length() == 0) return false;
+
+    selectedDeviceUuid = snapshot.deviceUuid;
+    selectedDeviceLastIP = snapshot.deviceIP;
+    selectedDeviceName = snapshot.deviceName;
+    showRestoredNowPlaying(snapshot.track, snapshot.thumbnail);
+    return true;
+}
+
+// After a deep-sleep wake: selection, group and live SIDs come back from RTC memory
+bool restoreRtcState() {
+    RuntimeState state;
+    if (!RtcState::restore(state)) return false;
+
+    selectedDeviceUuid = state.deviceUuid;
+    selectedDeviceLastIP = state.deviceIP;
+    selectedDeviceName = state.deviceName;
+    if (state.coordinatorIP.length() > 0 && state.coordinatorIP != state.deviceIP) {
+        std::vector<SonosZoneMember> members;
+        members.push_back({state.deviceUuid, state.deviceIP, state.coordinatorUuid});
+        members.push_back({state.coordinatorUuid, state.coordinatorIP, state.coordinatorUuid});
+        sonos.setZoneMembers(members);
     }
+    rtcSubscriptions = state.subscriptions;
+    rtcLocalIP = state.localIP;
+
+    // The thumbnail is only in the flash snapshot; use it when it is for the same speaker
+    WarmStartSnapshot snapshot;
+    if (!warmStart.load(snapshot) || snapshot.deviceUuid != state.deviceUuid) snapshot.thumbnail.clear();
+    showRestoredNowPlaying(state.track, snapshot.thumbnail);
+    return true;
 }
 
+#if ENABLE_DEEP_SLEEP
+void enterDeepSleep() {
+    RuntimeState state;
+    state.deviceUuid = selectedDeviceUuid;
+    state.deviceName = selectedDeviceName;
+    state.deviceIP = selectedDeviceIP();
+    state.coordinatorIP = sonos.getCoordinatorIP(state.deviceIP);
+    for (const auto& member : sonos.getZoneMembers()) {
+        if (member.ip == state.deviceIP) state.coordinatorUuid = member.coordinatorUuid;
+    }
+    state.localIP = WiFi.localIP().toString();
+    state.track = sonosController.getTrackData();
+    state.subscriptions = eventManager.getSubscriptions();
+    RtcState::save(state);
+
+    // Any button change pulls INTA low
+    mcp.setupInterrupts(true, false, LOW);
+    for (int pin : {BTN_UP, BTN_DOWN, BTN_CLICK, BTN_VUP, BTN_VDOWN}) mcp.setupInterruptPin(pin, CHANGE);
+    esp_sleep_enable_ext0_wakeup((gpio_num_t)DEEP_SLEEP_WAKE_PIN, 0);
+
+    LOG_INFO("core", "Idle for " + String(IDLE_SLEEP_MS / 1000) + " s; entering deep sleep");
+    digitalWrite(TFT_BL, LOW);
+    esp_deep_sleep_start();
+}
+#endif
+
 void setup() {
     WiFi.mode(WIFI_STA); // Initialize stack early
     Serial.begin(115200);
@@ -268,7 +506,7 @@ void setup() {
     // `useAllowList=true` means only channels in this list are shown.
     const bool useAllowList = true;
     const char* allowedLogChannels[] = {
-        "core", "wifi", "discovery", "cache", "xml", "soap", "control", "playback", "image", "ui", "events"
+        "core", "wifi", "discovery", "cache", "xml", "soap", "control", "playback", "image", "ui", "events", "topology"
     };
     AppLogger::clearAllowedChannels();
     if (useAllowList) {
@@ -292,6 +530,14 @@ void setup() {
     LOG_INFO("core", "Allowed channels: " + formatChannelList(allowedLogChannels, useAllowList));
     LOG_INFO("core", "Blocked channels: " + formatChannelList(blockedLogChannels));
     deviceCache.begin();
+    artCache.begin();
+    artTileCache.begin();
+    artWorker.begin(0);
+    hasCachedAp = wifiCache.load(cachedAp);
+    WiFi.onEvent([](arduino_event_id_t, arduino_event_info_t) { wifiAssociatedMs = millis(); },
+                 ARDUINO_EVENT_WIFI_STA_CONNECTED);
+    WiFi.onEvent([](arduino_event_id_t, arduino_event_info_t) { wifiGotIpMs = millis(); },
+                 ARDUINO_EVENT_WIFI_STA_GOT_IP);
 
     if (!mcp.begin_I2C(0x20)) {
         LOG_ERROR("core", "MCP23017 not found");
@@ -317,17 +563,24 @@ void setup() {
 
     eventManager.setEventCallback([](const String& ip, const String& service, const String& data) {
         (void)service;
-        if (currentScreen != SCREEN_NOW_PLAYING || ip != selectedDeviceIP.toString()) {
+        if (data.indexOf("ZoneGroupState") != -1) {
+            sonos.applyZoneGroupState(data);
+            followCoordinator();
+            return;
+        }
+        if (currentScreen != SCREEN_NOW_PLAYING || (ip != selectedDeviceIP() && ip != subscribedTransportIP)) {
             return;
         }
 
         LOG_DEBUG("core", "Event received from " + ip);
         sonosController.parseEvent(data);
 
-        // Ensure album art URL is absolute if relative
-        auto& track = const_cast<TrackData&>(sonosController.getTrackData());
-        if (track.albumArtUrl.length() > 0 && track.albumArtUrl.startsWith("/")) {
-            track.albumArtUrl = "http://" + ip + ":1400" + track.albumArtUrl;
+        // Ensure album art URLs are absolute if relative
+        for (const TrackData* entry : {&sonosController.getTrackData(), &sonosController.getNextTrack()}) {
+            auto& track = const_cast<TrackData&>(*entry);
+            if (track.albumArtUrl.length() > 0 && track.albumArtUrl.startsWith("/")) {
+                track.albumArtUrl = "http://" + ip + ":1400" + track.albumArtUrl;
+            }
         }
 
         if (data.indexOf("CurrentTrackURI") != -1 ||
@@ -339,20 +592,36 @@ void setup() {
 
     });
 
+    sonos.setDeviceMovedCallback([](const SonosDevice& device, const String& oldIP) {
+        LOG_INFO("core", device.name + " moved from " + oldIP + " to " + device.ip);
+        eventManager.updateDeviceAddress(oldIP, device.ip);
+        if (subscribedTransportIP == oldIP) subscribedTransportIP = device.ip;
+    });
+
     speakerList.setSelectedIndex(0);
-    speakerList.draw(discoveryManager.getDevices());
+    const char* firstFrame = "speaker list";
+    if (restoreRtcState()) firstFrame = "deep-sleep wake";
+    else if (restoreWarmStart()) firstFrame = "warm start";
+    else speakerList.draw(discoveryManager.getDevices());
+    LOG_INFO("core", "Boot to first frame: " + String(millis()) + " ms (" + firstFrame + ")");
 
     startWiFiConnection();
 }
 
 void loop() {
+    // Longest stall of the UI loop since art was last drawn; art work belongs on the worker core
+    static unsigned long lastLoopMs = 0, maxLoopGapMs = 0;
+    unsigned long now = millis();
+    if (lastLoopMs != 0 && now - lastLoopMs > maxLoopGapMs) maxLoopGapMs = now - lastLoopMs;
+    lastLoopMs = now;
+
     checkWiFiConnection();
     buttons.update();
     eventManager.update();
 
     if (currentScreen == SCREEN_SPEAKER_LIST) {
-        handleSpeakerListNavigation();
         discoveryManager.update();
+        handleSpeakerListNavigation();
 
         if (wifiState != previousWifiState) {
             previousWifiState = wifiState;
@@ -361,7 +630,17 @@ void loop() {
             else if (wifiState == WIFI_DISCONNECTED) speakerList.updateHeader("WiFi: Failed");
         }
     } else if (currentScreen == SCREEN_NOW_PLAYING) {
+        // Scans and cache validation block for up to seconds; only presence runs under the buttons here
+        discoveryManager.updatePresence();
         handleNowPlayingNavigation();
         updateNowPlayingScreen();
+        if (nowPlaying.update()) {
+            LOG_DEBUG("core", "UI loop max gap while art loaded: " + String(maxLoopGapMs) + " ms");
+            maxLoopGapMs = 0;
+        }
+        persistWarmStart();
+#if ENABLE_DEEP_SLEEP
+        if (millis() - buttons.lastActivityMs() > IDLE_SLEEP_MS) enterDeepSleep();
+#endif
     }
 }
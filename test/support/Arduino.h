@@ -0,0 +1,465 @@
+#pragma once
+// Host stand-in for the parts of the Arduino-ESP32 core this project uses, so the pure and
+// network code can run under `pio test -e native`. Header-only; everything is inline.
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#define ARDUINO_HOST_SHIM 1
+
+#define PROGMEM
+#define IRAM_ATTR
+#define RTC_DATA_ATTR
+#define RTC_NOINIT_ATTR
+
+#define DEC 10
+#define HEX 16
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+using std::max;
+using std::min;
+
+#if defined(__GLIBC__) && __GLIBC__ == 2 && __GLIBC_MINOR__ < 38
+inline size_t strlcpy(char* dest, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t copy = len < size - 1 ? len : size - 1;
+        memcpy(dest, src, copy);
+        dest[copy] = '\0';
+    }
+    return len;
+}
+#endif
+
+inline unsigned long micros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline unsigned long millis() {
+    return micros() / 1000;
+}
+
+inline void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+inline void yield() {
+    std::this_thread::yield();
+}
+
+class String {
+public:
+    String() {}
+    String(const char* value) : _s(value != nullptr ? value : "") {}
+    String(const std::string& value) : _s(value) {}
+    explicit String(char c) : _s(1, c) {}
+    String(int value, unsigned char base = DEC) : _s(format((long long)value, base)) {}
+    String(unsigned int value, unsigned char base = DEC) : _s(format((unsigned long long)value, base)) {}
+    String(long value, unsigned char base = DEC) : _s(format((long long)value, base)) {}
+    String(unsigned long value, unsigned char base = DEC) : _s(format((unsigned long long)value, base)) {}
+    String(long long value, unsigned char base = DEC) : _s(format(value, base)) {}
+    String(unsigned long long value, unsigned char base = DEC) : _s(format(value, base)) {}
+    String(float value, unsigned int decimals = 2) : _s(formatFloat(value, decimals)) {}
+    String(double value, unsigned int decimals = 2) : _s(formatFloat(value, decimals)) {}
+
+    unsigned int length() const { return _s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    const char* c_str() const { return _s.c_str(); }
+    bool reserve(unsigned int size) {
+        _s.reserve(size);
+        return true;
+    }
+
+    bool concat(const String& value) {
+        _s += value._s;
+        return true;
+    }
+    bool concat(const char* value) {
+        if (value == nullptr) return false;
+        _s += value;
+        return true;
+    }
+    bool concat(const char* value, unsigned int len) {
+        if (value == nullptr) return false;
+        _s.append(value, len);
+        return true;
+    }
+    bool concat(char c) {
+        _s += c;
+        return true;
+    }
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    bool concat(T value) {
+        return concat(String(value));
+    }
+
+    String& operator+=(const String& value) {
+        concat(value);
+        return *this;
+    }
+    String& operator+=(const char* value) {
+        concat(value);
+        return *this;
+    }
+    String& operator+=(char c) {
+        concat(c);
+        return *this;
+    }
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    String& operator+=(T value) {
+        concat(String(value));
+        return *this;
+    }
+
+    char charAt(unsigned int index) const { return index < _s.size() ? _s[index] : 0; }
+    void setCharAt(unsigned int index, char c) {
+        if (index < _s.size()) _s[index] = c;
+    }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return _s[index]; }
+
+    int compareTo(const String& other) const { return _s.compare(other._s); }
+    bool equals(const String& other) const { return _s == other._s; }
+    bool equalsIgnoreCase(const String& other) const {
+        if (_s.size() != other._s.size()) return false;
+        for (size_t i = 0; i < _s.size(); i++) {
+            if (tolower((unsigned char)_s[i]) != tolower((unsigned char)other._s[i])) return false;
+        }
+        return true;
+    }
+    bool startsWith(const String& prefix) const { return startsWith(prefix, 0); }
+    bool startsWith(const String& prefix, unsigned int offset) const {
+        return offset <= _s.size() && _s.compare(offset, prefix._s.size(), prefix._s) == 0 &&
+               _s.size() - offset >= prefix._s.size();
+    }
+    bool endsWith(const String& suffix) const {
+        return _s.size() >= suffix._s.size() && _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+    }
+
+    int indexOf(char c, unsigned int from = 0) const { return position(_s.find(c, from)); }
+    int indexOf(const String& value, unsigned int from = 0) const { return position(_s.find(value._s, from)); }
+    int lastIndexOf(char c) const { return position(_s.rfind(c)); }
+    int lastIndexOf(char c, unsigned int from) const { return position(_s.rfind(c, from)); }
+    int lastIndexOf(const String& value) const { return position(_s.rfind(value._s)); }
+    bool contains(const String& value) const { return _s.find(value._s) != std::string::npos; }
+
+    String substring(unsigned int begin) const { return begin >= _s.size() ? String() : String(_s.substr(begin)); }
+    String substring(unsigned int begin, unsigned int end) const {
+        if (begin > end) std::swap(begin, end);
+        if (begin >= _s.size()) return String();
+        return String(_s.substr(begin, min<size_t>(end, _s.size()) - begin));
+    }
+
+    void replace(char find, char replacement) { std::replace(_s.begin(), _s.end(), find, replacement); }
+    void replace(const String& find, const String& replacement) {
+        if (find._s.empty()) return;
+        size_t pos = 0;
+        while ((pos = _s.find(find._s, pos)) != std::string::npos) {
+            _s.replace(pos, find._s.size(), replacement._s);
+            pos += replacement._s.size();
+        }
+    }
+    void remove(unsigned int index) {
+        if (index < _s.size()) _s.erase(index);
+    }
+    void remove(unsigned int index, unsigned int count) {
+        if (index < _s.size()) _s.erase(index, count);
+    }
+    void toLowerCase() {
+        for (auto& c : _s) c = tolower((unsigned char)c);
+    }
+    void toUpperCase() {
+        for (auto& c : _s) c = toupper((unsigned char)c);
+    }
+    void trim() {
+        size_t begin = 0, end = _s.size();
+        while (begin < end && isspace((unsigned char)_s[begin])) begin++;
+        while (end > begin && isspace((unsigned char)_s[end - 1])) end--;
+        _s = _s.substr(begin, end - begin);
+    }
+
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return atof(_s.c_str()); }
+    void toCharArray(char* buffer, unsigned int size, unsigned int index = 0) const {
+        if (size == 0) return;
+        strlcpy(buffer, index < _s.size() ? _s.c_str() + index : "", size);
+    }
+    void getBytes(unsigned char* buffer, unsigned int size, unsigned int index = 0) const {
+        toCharArray(reinterpret_cast<char*>(buffer), size, index);
+    }
+
+    bool operator==(const String& other) const { return _s == other._s; }
+    bool operator==(const char* other) const { return other != nullptr && _s == other; }
+    bool operator!=(const String& other) const { return _s != other._s; }
+    bool operator!=(const char* other) const { return !(*this == other); }
+    bool operator<(const String& other) const { return _s < other._s; }
+    bool operator>(const String& other) const { return _s > other._s; }
+
+    const std::string& str() const { return _s; }
+
+private:
+    std::string _s;
+
+    static int position(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+
+    static std::string format(long long value, unsigned char base) {
+        if (base == DEC) return std::to_string(value);
+        return format((unsigned long long)value, base);
+    }
+    static std::string format(unsigned long long value, unsigned char base) {
+        if (base == DEC) return std::to_string(value);
+        if (value == 0) return "0";
+        std::string digits;
+        for (; value > 0; value /= base) digits.insert(digits.begin(), "0123456789abcdef"[value % base]);
+        return digits;
+    }
+    static std::string formatFloat(double value, unsigned int decimals) {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "%.*f", (int)decimals, value);
+        return buffer;
+    }
+};
+
+// ArduinoJson recognises Arduino strings through this type as well
+class StringSumHelper : public String {
+public:
+    using String::String;
+    StringSumHelper(const String& value) : String(value) {}
+};
+
+inline StringSumHelper operator+(const String& a, const String& b) {
+    String sum(a);
+    sum.concat(b);
+    return sum;
+}
+inline StringSumHelper operator+(const String& a, const char* b) {
+    String sum(a);
+    sum.concat(b);
+    return sum;
+}
+inline StringSumHelper operator+(const char* a, const String& b) {
+    String sum(a);
+    sum.concat(b);
+    return sum;
+}
+inline StringSumHelper operator+(const String& a, char b) {
+    String sum(a);
+    sum.concat(b);
+    return sum;
+}
+template <typename T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+inline StringSumHelper operator+(const String& a, T b) {
+    String sum(a);
+    sum.concat(String(b));
+    return sum;
+}
+inline bool operator==(const char* a, const String& b) {
+    return b == a;
+}
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (n < size && write(buffer[n])) n++;
+        return n;
+    }
+    size_t write(const char* text) { return text != nullptr ? write(reinterpret_cast<const uint8_t*>(text), strlen(text)) : 0; }
+    size_t write(const char* buffer, size_t size) { return write(reinterpret_cast<const uint8_t*>(buffer), size); }
+    virtual void flush() {}
+
+    size_t print(const String& value) { return write(value.c_str(), value.length()); }
+    size_t print(const char* value) { return write(value); }
+    size_t print(char value) { return write((uint8_t)value); }
+    template <typename T, typename std::enable_if<std::is_arithmetic<T>::value && !std::is_same<T, char>::value, int>::type = 0>
+    size_t print(T value) {
+        return print(String(value));
+    }
+    template <typename T>
+    size_t println(const T& value) {
+        return print(value) + println();
+    }
+    size_t println() { return write("\r\n"); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        return len > 0 ? write(buffer, min<size_t>(len, sizeof(buffer) - 1)) : 0;
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeoutMs) { _timeoutMs = timeoutMs; }
+    unsigned long getTimeout() const { return _timeoutMs; }
+
+    virtual size_t readBytes(char* buffer, size_t length) {
+        size_t count = 0;
+        unsigned long start = millis();
+        while (count < length) {
+            int c = read();
+            if (c < 0) {
+                if (millis() - start >= _timeoutMs) break;
+                delay(1);
+                continue;
+            }
+            buffer[count++] = (char)c;
+            start = millis();
+        }
+        return count;
+    }
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes(reinterpret_cast<char*>(buffer), length); }
+
+    String readString() {
+        String value;
+        char c;
+        while (readBytes(&c, 1) == 1) value.concat(c);
+        return value;
+    }
+    String readStringUntil(char terminator) {
+        String value;
+        char c;
+        while (readBytes(&c, 1) == 1 && c != terminator) value.concat(c);
+        return value;
+    }
+
+protected:
+    unsigned long _timeoutMs = 1000;
+};
+
+// Serial goes to stdout so log lines show up in the test output
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override { fflush(stdout); }
+    using Print::write;
+};
+
+inline HardwareSerial Serial;
+
+class IPAddress {
+public:
+    IPAddress() {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _bytes{a, b, c, d} {}
+    // Network byte order, as lwIP stores it
+    IPAddress(uint32_t address) { memcpy(_bytes, &address, sizeof(_bytes)); }
+
+    bool fromString(const char* text) {
+        if (text == nullptr) return false;
+        uint8_t bytes[4] = {0, 0, 0, 0};
+        int part = 0;
+        int value = -1;
+        for (const char* p = text;; p++) {
+            if (isdigit((unsigned char)*p)) {
+                value = (value < 0 ? 0 : value * 10) + (*p - '0');
+                if (value > 255) return false;
+            } else if (*p == '.' || *p == '\0') {
+                if (value < 0 || part > 3) return false;
+                bytes[part++] = value;
+                value = -1;
+                if (*p == '\0') break;
+            } else {
+                return false;
+            }
+        }
+        if (part != 4) return false;
+        memcpy(_bytes, bytes, sizeof(_bytes));
+        return true;
+    }
+    bool fromString(const String& text) { return fromString(text.c_str()); }
+
+    String toString() const {
+        char buffer[16];
+        snprintf(buffer, sizeof(buffer), "%u.%u.%u.%u", _bytes[0], _bytes[1], _bytes[2], _bytes[3]);
+        return String(buffer);
+    }
+
+    operator uint32_t() const {
+        uint32_t address;
+        memcpy(&address, _bytes, sizeof(address));
+        return address;
+    }
+    uint8_t operator[](int index) const { return _bytes[index]; }
+    uint8_t& operator[](int index) { return _bytes[index]; }
+    bool operator==(const IPAddress& other) const { return memcmp(_bytes, other._bytes, sizeof(_bytes)) == 0; }
+    bool operator!=(const IPAddress& other) const { return !(*this == other); }
+
+private:
+    uint8_t _bytes[4] = {0, 0, 0, 0};
+};
+
+// Free heap is modelled as a fixed arena minus what malloc has handed out since start-up, so
+// heap statistics move the way they would on the device
+class EspClass {
+public:
+    static const uint32_t HOST_HEAP_BYTES = 4 * 1024 * 1024;
+
+    uint32_t getHeapSize() { return HOST_HEAP_BYTES; }
+    uint32_t getFreeHeap() {
+        size_t used = usedBytes() > _baseline ? usedBytes() - _baseline : 0;
+        uint32_t free = used >= HOST_HEAP_BYTES ? 0 : HOST_HEAP_BYTES - used;
+        if (free < _minFree) _minFree = free;
+        return free;
+    }
+    uint32_t getMinFreeHeap() {
+        getFreeHeap();
+        return _minFree;
+    }
+    uint32_t getMaxAllocHeap() { return getFreeHeap(); }
+    uint32_t getPsramSize() { return 8 * 1024 * 1024; }
+    uint32_t getFreePsram() { return getPsramSize(); }
+    void restart() { exit(0); }
+
+    // Host only: bytes currently allocated by this process
+    static size_t usedBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+        return mallinfo2().uordblks;
+#else
+        return 0;
+#endif
+    }
+
+private:
+    size_t _baseline = usedBytes();
+    uint32_t _minFree = HOST_HEAP_BYTES;
+};
+
+inline EspClass ESP;
+
+inline bool psramFound() {
+    return true;
+}
+
+inline void* ps_malloc(size_t size) {
+    return malloc(size);
+}
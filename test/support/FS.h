@@ -0,0 +1,140 @@
+#pragma once
+// Host stand-in for the Arduino FS API on a directory of the host filesystem. Counters let
+// tests see how much a component writes to flash.
+#include <Arduino.h>
+#include <dirent.h>
+#include <memory>
+#include <sys/stat.h>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace HostFs {
+
+inline uint32_t filesWritten = 0;  // Files opened for writing
+inline uint64_t bytesWritten = 0;
+inline uint32_t renames = 0;
+
+inline void resetCounters() {
+    filesWritten = 0;
+    bytesWritten = 0;
+    renames = 0;
+}
+
+}  // namespace HostFs
+
+namespace fs {
+
+enum SeekMode { SeekSet = 0, SeekCur = 1, SeekEnd = 2 };
+
+class File : public Stream {
+public:
+    File() {}
+    File(const std::string& hostPath, const String& name, const char* mode) : _name(name) {
+        struct stat info;
+        if (stat(hostPath.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            _dir = std::shared_ptr<DIR>(opendir(hostPath.c_str()), [](DIR* d) {
+                if (d) closedir(d);
+            });
+            _hostPath = hostPath;
+            return;
+        }
+        FILE* handle = fopen(hostPath.c_str(), strcmp(mode, "r") == 0 ? "rb" : (strcmp(mode, "a") == 0 ? "ab" : "wb"));
+        if (handle == nullptr) return;
+        if (strcmp(mode, "r") != 0) HostFs::filesWritten++;
+        _file = std::shared_ptr<FILE>(handle, [](FILE* f) { fclose(f); });
+        _hostPath = hostPath;
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        if (!_file) return 0;
+        size_t written = fwrite(buffer, 1, size, _file.get());
+        HostFs::bytesWritten += written;
+        return written;
+    }
+    using Print::write;
+    int available() override { return _file ? (int)(size() - position()) : 0; }
+    int read() override {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+    size_t read(uint8_t* buffer, size_t size) { return _file ? fread(buffer, 1, size, _file.get()) : 0; }
+    size_t readBytes(char* buffer, size_t length) override { return read(reinterpret_cast<uint8_t*>(buffer), length); }
+    int peek() override {
+        if (!_file) return -1;
+        int c = fgetc(_file.get());
+        if (c != EOF) ungetc(c, _file.get());
+        return c == EOF ? -1 : c;
+    }
+    void flush() override {
+        if (_file) fflush(_file.get());
+    }
+    bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+        return _file && fseek(_file.get(), pos, mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END)) == 0;
+    }
+    size_t position() const { return _file ? ftell(_file.get()) : 0; }
+    size_t size() const {
+        struct stat info;
+        if (_file) fflush(_file.get());
+        return stat(_hostPath.c_str(), &info) == 0 ? info.st_size : 0;
+    }
+    void close() {
+        _file.reset();
+        _dir.reset();
+    }
+    operator bool() const { return _file != nullptr || _dir != nullptr; }
+    const char* name() const {
+        int slash = _name.lastIndexOf('/');
+        return _name.c_str() + slash + 1;
+    }
+    const char* path() const { return _name.c_str(); }
+    bool isDirectory() const { return _dir != nullptr; }
+    File openNextFile(const char* mode = FILE_READ) {
+        if (!_dir) return File();
+        while (struct dirent* entry = readdir(_dir.get())) {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) continue;
+            String base = _name.endsWith("/") ? _name : _name + "/";
+            return File(_hostPath + "/" + entry->d_name, base + entry->d_name, mode);
+        }
+        return File();
+    }
+
+private:
+    std::shared_ptr<FILE> _file;
+    std::shared_ptr<DIR> _dir;
+    std::string _hostPath;
+    String _name;
+};
+
+class FS {
+public:
+    File open(const String& path, const char* mode = FILE_READ, bool create = false) {
+        (void)create;
+        if (strcmp(mode, FILE_READ) == 0 && !exists(path)) return File();
+        return File(hostPath(path), path, mode);
+    }
+    File open(const char* path, const char* mode = FILE_READ, bool create = false) { return open(String(path), mode, create); }
+    bool exists(const String& path) {
+        struct stat info;
+        return stat(hostPath(path).c_str(), &info) == 0;
+    }
+    bool remove(const String& path) { return ::remove(hostPath(path).c_str()) == 0; }
+    bool rename(const String& from, const String& to) {
+        HostFs::renames++;
+        return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+    }
+    bool mkdir(const String& path) { return ::mkdir(hostPath(path).c_str(), 0755) == 0; }
+    bool rmdir(const String& path) { return ::rmdir(hostPath(path).c_str()) == 0; }
+
+protected:
+    std::string _root;
+
+    std::string hostPath(const String& path) const { return _root + (path.startsWith("/") ? "" : "/") + path.c_str(); }
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,237 @@
+#pragma once
+// Host stand-in for the ESP32 HTTPClient: HTTP/1.x over the WiFiClient shim, with keep-alive
+// reuse, collected headers and chunked getString(). Redirects are never followed. Like the core,
+// end() keeps a reusable client attached and the destructor stops whatever client is attached.
+#include <Arduino.h>
+#include <WiFiClient.h>
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+typedef enum {
+    HTTP_CODE_OK = 200,
+    HTTP_CODE_NO_CONTENT = 204,
+    HTTP_CODE_MOVED_PERMANENTLY = 301,
+    HTTP_CODE_FOUND = 302,
+    HTTP_CODE_SEE_OTHER = 303,
+    HTTP_CODE_NOT_MODIFIED = 304,
+    HTTP_CODE_TEMPORARY_REDIRECT = 307,
+    HTTP_CODE_PERMANENT_REDIRECT = 308,
+    HTTP_CODE_BAD_REQUEST = 400,
+    HTTP_CODE_NOT_FOUND = 404,
+    HTTP_CODE_INTERNAL_SERVER_ERROR = 500,
+    HTTP_CODE_SERVICE_UNAVAILABLE = 503
+} t_http_codes;
+
+typedef enum {
+    HTTPC_DISABLE_FOLLOW_REDIRECTS,
+    HTTPC_STRICT_FOLLOW_REDIRECTS,
+    HTTPC_FORCE_FOLLOW_REDIRECTS
+} followRedirects_t;
+
+class HTTPClient {
+public:
+    ~HTTPClient() {
+        if (_client != nullptr) _client->stop();
+        if (_ownedClient != nullptr) delete _ownedClient;
+    }
+
+    bool begin(const String& url) {
+        if (_ownedClient == nullptr) _ownedClient = new WiFiClient();
+        return begin(*_ownedClient, url);
+    }
+    bool begin(WiFiClient& client, const String& url) {
+        String host = _host;
+        uint16_t port = _port;
+        if (!parseUrl(url)) return false;
+        // A different server cannot share the open connection
+        if (_client != &client || host != _host || port != _port) {
+            if (_client != nullptr && _client == _ownedClient && _client->connected()) _client->stop();
+        }
+        _client = &client;
+        _requestHeaders = "";
+        return true;
+    }
+    void end() {
+        if (_client == nullptr || !_client->connected()) return;
+        while (_client->available() > 0) _client->read();
+        if (_reuse && _canReuse) return;
+        _client->stop();
+        _client = nullptr;
+    }
+
+    void setReuse(bool reuse) { _reuse = reuse; }
+    void useHTTP10(bool useHTTP10) {
+        _useHTTP10 = useHTTP10;
+        _reuse = !useHTTP10;
+    }
+    void setTimeout(uint16_t timeoutMs) { _timeoutMs = timeoutMs; }
+    void setConnectTimeout(int32_t timeoutMs) { _connectTimeoutMs = timeoutMs; }
+    void setFollowRedirects(followRedirects_t) {}
+    void setUserAgent(const String& userAgent) { _userAgent = userAgent; }
+    void addHeader(const String& name, const String& value) { _requestHeaders += name + ": " + value + "\r\n"; }
+    void collectHeaders(const char* headerKeys[], size_t count) {
+        _collected.clear();
+        for (size_t i = 0; i < count; i++) _collected.push_back({String(headerKeys[i]), String()});
+    }
+    String header(const char* name) {
+        for (const auto& entry : _collected) {
+            if (entry.first.equalsIgnoreCase(name)) return entry.second;
+        }
+        return String();
+    }
+    bool hasHeader(const char* name) { return header(name).length() > 0; }
+    String getLocation() { return _location; }
+
+    int GET() { return sendRequest("GET", nullptr, 0); }
+    int POST(const String& payload) {
+        return sendRequest("POST", reinterpret_cast<const uint8_t*>(payload.c_str()), payload.length());
+    }
+    int POST(uint8_t* payload, size_t size) { return sendRequest("POST", payload, size); }
+    int sendRequest(const char* method, const uint8_t* payload, size_t size) {
+        if (_client == nullptr) return HTTPC_ERROR_NOT_CONNECTED;
+        if (!_client->connected() && !_client->connect(_host.c_str(), _port, _connectTimeoutMs)) {
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        }
+        while (_client->available() > 0) _client->read();
+        _client->setTimeout(_timeoutMs);
+
+        String request = String(method) + " " + _path + (_useHTTP10 ? " HTTP/1.0\r\n" : " HTTP/1.1\r\n");
+        request += "Host: " + _host + (_port != 80 && _port != 443 ? ":" + String(_port) : String()) + "\r\n";
+        request += "User-Agent: " + _userAgent + "\r\n";
+        request += String("Connection: ") + (_reuse ? "keep-alive" : "close") + "\r\n";
+        if (payload != nullptr || strcmp(method, "POST") == 0) request += "Content-Length: " + String((unsigned)size) + "\r\n";
+        request += _requestHeaders + "\r\n";
+        if (_client->write(reinterpret_cast<const uint8_t*>(request.c_str()), request.length()) != request.length()) {
+            _client->stop();
+            return HTTPC_ERROR_SEND_HEADER_FAILED;
+        }
+        if (size > 0 && _client->write(payload, size) != size) {
+            _client->stop();
+            return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+        }
+        return readResponse();
+    }
+
+    int getSize() { return _size; }
+    WiFiClient* getStreamPtr() { return _client != nullptr && _client->connected() ? _client : nullptr; }
+    WiFiClient& getStream() { return *_client; }
+    String getString() {
+        String body;
+        if (_client == nullptr) return body;
+        if (_chunked) {
+            while (true) {
+                String sizeLine = _client->readStringUntil('\n');
+                long chunk = strtol(sizeLine.c_str(), nullptr, 16);
+                if (sizeLine.length() == 0 || chunk <= 0) break;
+                readInto(body, chunk);
+                _client->readStringUntil('\n');
+            }
+            _client->readStringUntil('\n');
+        } else if (_size >= 0) {
+            readInto(body, _size);
+        } else {
+            readInto(body, -1);
+            _canReuse = false;
+        }
+        return body;
+    }
+
+private:
+    WiFiClient* _client = nullptr;
+    WiFiClient* _ownedClient = nullptr;
+    String _host;
+    uint16_t _port = 80;
+    String _path;
+    String _userAgent = "ESP32HTTPClient";
+    String _requestHeaders;
+    std::vector<std::pair<String, String>> _collected;
+    String _location;
+    bool _reuse = true;
+    bool _useHTTP10 = false;
+    bool _canReuse = false;
+    bool _chunked = false;
+    int _size = -1;
+    uint16_t _timeoutMs = 5000;
+    int32_t _connectTimeoutMs = 5000;
+
+    bool parseUrl(const String& url) {
+        int schemeEnd = url.indexOf("://");
+        if (schemeEnd < 0) return false;
+        String scheme = url.substring(0, schemeEnd);
+        _port = scheme == "https" ? 443 : 80;
+        int hostStart = schemeEnd + 3;
+        int pathStart = url.indexOf('/', hostStart);
+        String hostPort = pathStart < 0 ? url.substring(hostStart) : url.substring(hostStart, pathStart);
+        _path = pathStart < 0 ? String("/") : url.substring(pathStart);
+        int colon = hostPort.indexOf(':');
+        if (colon >= 0) {
+            _port = hostPort.substring(colon + 1).toInt();
+            hostPort = hostPort.substring(0, colon);
+        }
+        _host = hostPort;
+        return _host.length() > 0;
+    }
+
+    // Reads the status line and headers; the body is left on the socket
+    int readResponse() {
+        _size = -1;
+        _chunked = false;
+        _location = "";
+        for (auto& entry : _collected) entry.second = "";
+        unsigned long start = millis();
+        while (_client->available() <= 0) {
+            if (!_client->connected()) return HTTPC_ERROR_CONNECTION_LOST;
+            if (millis() - start > _timeoutMs) return HTTPC_ERROR_READ_TIMEOUT;
+            delay(1);
+        }
+
+        String statusLine = _client->readStringUntil('\n');
+        if (!statusLine.startsWith("HTTP/1.")) return HTTPC_ERROR_CONNECTION_LOST;
+        int code = statusLine.substring(9, 12).toInt();
+        _canReuse = _reuse && !statusLine.startsWith("HTTP/1.0");
+        while (true) {
+            String line = _client->readStringUntil('\n');
+            line.trim();
+            if (line.length() == 0) break;
+            int colon = line.indexOf(':');
+            if (colon < 0) continue;
+            String name = line.substring(0, colon);
+            String value = line.substring(colon + 1);
+            value.trim();
+            if (name.equalsIgnoreCase("Content-Length")) _size = value.toInt();
+            if (name.equalsIgnoreCase("Transfer-Encoding") && value.equalsIgnoreCase("chunked")) _chunked = true;
+            if (name.equalsIgnoreCase("Location")) _location = value;
+            if (name.equalsIgnoreCase("Connection")) {
+                if (value.equalsIgnoreCase("close")) _canReuse = false;
+                else if (value.equalsIgnoreCase("keep-alive")) _canReuse = _reuse;
+            }
+            for (auto& entry : _collected) {
+                if (entry.first.equalsIgnoreCase(name)) entry.second = value;
+            }
+        }
+        return code > 0 ? code : HTTPC_ERROR_CONNECTION_LOST;
+    }
+
+    // length < 0 reads until the server closes the connection
+    void readInto(String& body, long length) {
+        char buffer[512];
+        unsigned long last = millis();
+        while (length != 0) {
+            int got = _client->read(reinterpret_cast<uint8_t*>(buffer), length < 0 ? sizeof(buffer) : min<long>(length, sizeof(buffer)));
+            if (got > 0) {
+                body.concat(buffer, got);
+                if (length > 0) length -= got;
+                last = millis();
+            } else if (!_client->connected() || millis() - last > _timeoutMs) {
+                break;
+            } else {
+                delay(1);
+            }
+        }
+    }
+};
@@ -0,0 +1,18 @@
+#pragma once
+// Knobs for the host network shims. The test host has no multicast route and no Wi-Fi, so
+// tests point multicast traffic at loopback ports and choose what WiFi reports.
+#include <Arduino.h>
+
+namespace HostNet {
+
+// Datagrams sent to any multicast group go to 127.0.0.1 on this port; 0 drops them
+inline uint16_t multicastSendPort = 0;
+// WiFiUDP::beginMulticast() binds 127.0.0.1 on this port instead of joining the group; 0 keeps the group's port
+inline uint16_t multicastListenPort = 0;
+// SO_RCVBUF for UDP sockets; lwIP queues only a few datagrams per socket, 0 keeps the host default
+inline int udpReceiveBuffer = 0;
+
+inline bool connected = true;
+inline IPAddress localIP(127, 0, 0, 1);
+
+}  // namespace HostNet
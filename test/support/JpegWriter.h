@@ -0,0 +1,80 @@
+#pragma once
+// Builds JPEG files for host tests: baseline or progressive, 4:4:4, 4:2:0 or grayscale, at any
+// size and quality. Compression is libjpeg's.
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+// libjpeg's int boolean would clash with the Arduino shim's
+#define boolean jpeg_boolean
+#include <jpeglib.h>
+#undef boolean
+
+struct JpegSpec {
+    uint32_t width = 1;
+    uint32_t height = 1;
+    bool gray = false;
+    bool subsampled = false;  // 4:2:0 chroma, so MCUs are 16x16 instead of 8x8
+    bool progressive = false;
+    int quality = 90;
+};
+
+class JpegWriter {
+public:
+    // Top-left, top-right, bottom-left and bottom-right quadrant colours of testCard()
+    static constexpr uint8_t QUADRANTS[4][3] = {{200, 40, 40}, {40, 180, 60}, {50, 70, 210}, {230, 230, 230}};
+
+    // pixels holds spec.height rows of RGB triples, or of single gray samples for gray
+    static std::string encode(const JpegSpec& spec, const std::vector<uint8_t>& pixels) {
+        jpeg_compress_struct cinfo;
+        jpeg_error_mgr err;
+        cinfo.err = jpeg_std_error(&err);
+        jpeg_create_compress(&cinfo);
+        unsigned char* out = nullptr;
+        unsigned long size = 0;
+        jpeg_mem_dest(&cinfo, &out, &size);
+        cinfo.image_width = spec.width;
+        cinfo.image_height = spec.height;
+        cinfo.input_components = spec.gray ? 1 : 3;
+        cinfo.in_color_space = spec.gray ? JCS_GRAYSCALE : JCS_RGB;
+        jpeg_set_defaults(&cinfo);
+        jpeg_set_quality(&cinfo, spec.quality, TRUE);
+        if (!spec.gray) {
+            cinfo.comp_info[0].h_samp_factor = cinfo.comp_info[0].v_samp_factor = spec.subsampled ? 2 : 1;
+            for (int c = 1; c < 3; c++) cinfo.comp_info[c].h_samp_factor = cinfo.comp_info[c].v_samp_factor = 1;
+        }
+        if (spec.progressive) jpeg_simple_progression(&cinfo);
+        jpeg_start_compress(&cinfo, TRUE);
+        size_t rowBytes = (size_t)spec.width * cinfo.input_components;
+        while (cinfo.next_scanline < cinfo.image_height) {
+            JSAMPROW row = const_cast<uint8_t*>(&pixels[cinfo.next_scanline * rowBytes]);
+            jpeg_write_scanlines(&cinfo, &row, 1);
+        }
+        jpeg_finish_compress(&cinfo);
+        std::string jpeg(reinterpret_cast<char*>(out), size);
+        jpeg_destroy_compress(&cinfo);
+        free(out);
+        return jpeg;
+    }
+
+    // Four flat quadrants, so colours survive compression and scaling apart from their edges
+    static std::string testCard(const JpegSpec& spec) {
+        std::vector<uint8_t> pixels;
+        pixels.reserve((size_t)spec.width * spec.height * 3);
+        for (uint32_t y = 0; y < spec.height; y++) {
+            for (uint32_t x = 0; x < spec.width; x++) {
+                const uint8_t* rgb = QUADRANTS[(y * 2 / spec.height) * 2 + x * 2 / spec.width];
+                if (spec.gray) {
+                    pixels.push_back(gray(rgb));
+                } else {
+                    pixels.insert(pixels.end(), rgb, rgb + 3);
+                }
+            }
+        }
+        return encode(spec, pixels);
+    }
+
+    // The luma libjpeg keeps for a colour
+    static uint8_t gray(const uint8_t* rgb) { return (uint8_t)((rgb[0] * 299 + rgb[1] * 587 + rgb[2] * 114 + 500) / 1000); }
+};
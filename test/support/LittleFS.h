@@ -0,0 +1,27 @@
+#pragma once
+// Host stand-in for LittleFS; the partition is a scratch directory per test process
+#include <FS.h>
+
+namespace fs {
+
+class LittleFSFS : public FS {
+public:
+    bool begin(bool formatOnFail = false, const char* = "/littlefs", uint8_t = 10, const char* = "spiffs") {
+        (void)formatOnFail;
+        if (_root.empty()) _root = "/tmp/sonos-native-fs-" + std::to_string(getpid());
+        ::mkdir(_root.c_str(), 0755);
+        return true;
+    }
+    bool format() {
+        if (_root.empty()) begin();
+        std::string command = "rm -rf '" + _root + "'/*";
+        return system(command.c_str()) == 0;
+    }
+    void end() {}
+    size_t totalBytes() { return 1536 * 1024; }
+    size_t usedBytes() { return 0; }
+};
+
+}  // namespace fs
+
+inline fs::LittleFSFS LittleFS;
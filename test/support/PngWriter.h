@@ -0,0 +1,139 @@
+#pragma once
+// Builds PNG files for host tests: any colour type and bit depth, a chosen filter per row and
+// the zlib stream cut into IDAT chunks of a chosen size. Compression is zlib's.
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+struct PngSpec {
+    uint32_t width = 1;
+    uint32_t height = 1;
+    uint8_t colorType = 2;  // 0 gray, 2 RGB, 3 palette, 4 gray+alpha, 6 RGBA
+    uint8_t bitDepth = 8;
+    uint8_t interlace = 0;
+    std::vector<uint8_t> filters = {0};  // Filter type per row, repeated when shorter than the image
+    size_t idatBytes = 0;                // Split the zlib stream into IDATs of this size; 0 for one IDAT
+    std::vector<uint8_t> palette;        // RGB triples
+    std::vector<uint8_t> paletteAlpha;   // tRNS entries; empty for none
+    bool writeHeader = true;
+    bool writeEnd = true;
+
+    uint8_t channels() const {
+        switch (colorType) {
+            case 2: return 3;
+            case 4: return 2;
+            case 6: return 4;
+            default: return 1;
+        }
+    }
+    size_t rowBytes() const { return ((size_t)width * channels() * bitDepth + 7) / 8; }
+    size_t filterDistance() const {
+        size_t bits = (size_t)channels() * bitDepth;
+        return bits < 8 ? 1 : bits / 8;
+    }
+};
+
+class PngWriter {
+public:
+    // raw holds spec.height unfiltered scanlines of spec.rowBytes() each
+    static std::string encode(const PngSpec& spec, const std::vector<uint8_t>& raw) {
+        std::string png("\x89PNG\r\n\x1a\n", 8);
+        if (spec.writeHeader) {
+            std::string header;
+            put32(header, spec.width);
+            put32(header, spec.height);
+            header += (char)spec.bitDepth;
+            header += (char)spec.colorType;
+            header += '\0';
+            header += '\0';
+            header += (char)spec.interlace;
+            chunk(png, "IHDR", header);
+        }
+        if (!spec.palette.empty()) chunk(png, "PLTE", std::string(spec.palette.begin(), spec.palette.end()));
+        if (!spec.paletteAlpha.empty()) chunk(png, "tRNS", std::string(spec.paletteAlpha.begin(), spec.paletteAlpha.end()));
+
+        std::string compressed = deflate(filter(spec, raw));
+        size_t step = spec.idatBytes > 0 ? spec.idatBytes : compressed.size();
+        for (size_t at = 0; at < compressed.size(); at += step) chunk(png, "IDAT", compressed.substr(at, step));
+        if (spec.writeEnd) chunk(png, "IEND", "");
+        return png;
+    }
+
+    // Scanlines prefixed with their filter type, filtered as an encoder would
+    static std::vector<uint8_t> filter(const PngSpec& spec, const std::vector<uint8_t>& raw) {
+        size_t rowBytes = spec.rowBytes();
+        size_t bpp = spec.filterDistance();
+        std::vector<uint8_t> out;
+        std::vector<uint8_t> zero(rowBytes, 0);
+        for (uint32_t y = 0; y < spec.height; y++) {
+            uint8_t type = spec.filters[y % spec.filters.size()];
+            const uint8_t* row = &raw[y * rowBytes];
+            const uint8_t* prior = y > 0 ? &raw[(y - 1) * rowBytes] : zero.data();
+            out.push_back(type);
+            for (size_t i = 0; i < rowBytes; i++) {
+                uint8_t left = i >= bpp ? row[i - bpp] : 0;
+                uint8_t upLeft = i >= bpp ? prior[i - bpp] : 0;
+                uint8_t predictor = 0;
+                switch (type) {
+                    case 1: predictor = left; break;
+                    case 2: predictor = prior[i]; break;
+                    case 3: predictor = (left + prior[i]) >> 1; break;
+                    case 4: predictor = paeth(left, prior[i], upLeft); break;
+                    default: break;
+                }
+                out.push_back(row[i] - predictor);
+            }
+        }
+        return out;
+    }
+
+    // RGB 8-bit art with a gradient keyed by seed, so each track's cover decodes to different pixels
+    static std::string testCard(uint32_t width, uint32_t height, uint8_t seed) {
+        PngSpec spec;
+        spec.width = width;
+        spec.height = height;
+        spec.filters = {0, 1, 2, 3, 4};
+        std::vector<uint8_t> raw;
+        raw.reserve(spec.rowBytes() * height);
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                raw.push_back((uint8_t)(x * 255 / width + seed * 40));
+                raw.push_back((uint8_t)(y * 255 / height));
+                raw.push_back((uint8_t)(seed * 53 + ((x ^ y) & 0x1F)));
+            }
+        }
+        return encode(spec, raw);
+    }
+
+private:
+    static void put32(std::string& out, uint32_t value) {
+        out += (char)(value >> 24);
+        out += (char)(value >> 16);
+        out += (char)(value >> 8);
+        out += (char)value;
+    }
+
+    static void chunk(std::string& png, const char* type, const std::string& data) {
+        put32(png, data.size());
+        std::string body = std::string(type, 4) + data;
+        png += body;
+        put32(png, crc32(0, reinterpret_cast<const Bytef*>(body.data()), body.size()));
+    }
+
+    static std::string deflate(const std::vector<uint8_t>& data) {
+        uLongf size = compressBound(data.size());
+        std::string out(size, '\0');
+        compress2(reinterpret_cast<Bytef*>(&out[0]), &size, data.data(), data.size(), 6);
+        out.resize(size);
+        return out;
+    }
+
+    static uint8_t paeth(uint8_t left, uint8_t up, uint8_t upLeft) {
+        int p = (int)left + up - upLeft;
+        int pa = abs(p - left), pb = abs(p - up), pc = abs(p - upLeft);
+        if (pa <= pb && pa <= pc) return left;
+        return pb <= pc ? up : upLeft;
+    }
+};
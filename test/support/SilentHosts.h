@@ -0,0 +1,42 @@
+#pragma once
+// Loopback addresses that never answer a connect, like powered-off hosts on the LAN. Each one is
+// a listener with a backlog of one that is already taken and never accepted, so the kernel drops
+// every further SYN and the caller's connect runs into its timeout. Closed loopback ports would
+// refuse at once and make a sweep look far cheaper than it is.
+#include <Arduino.h>
+#include <lwip/sockets.h>
+
+class SilentHosts {
+public:
+    ~SilentHosts() { stop(); }
+
+    bool add(const std::string& ip, uint16_t port) {
+        int listener = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, ip.c_str(), &addr.sin_addr);
+        if (listener < 0 || bind(listener, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            ::listen(listener, 0) != 0) {
+            if (listener >= 0) ::close(listener);
+            return false;
+        }
+        int filler = socket(AF_INET, SOCK_STREAM, 0);
+        if (filler < 0 || ::connect(filler, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(listener);
+            if (filler >= 0) ::close(filler);
+            return false;
+        }
+        _fds.push_back(listener);
+        _fds.push_back(filler);
+        return true;
+    }
+
+    void stop() {
+        for (int fd : _fds) ::close(fd);
+        _fds.clear();
+    }
+
+private:
+    std::vector<int> _fds;
+};
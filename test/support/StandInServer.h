@@ -0,0 +1,204 @@
+#pragma once
+// Loopback HTTP server for host tests. One thread serves every listener and connection, so a
+// test can stand up hundreds of speakers on 127.x.y.z addresses without a thread each.
+#include <Arduino.h>
+#include <atomic>
+#include <errno.h>
+#include <mutex>
+#include <poll.h>
+#include <lwip/sockets.h>
+
+class StandInServer {
+public:
+    struct Request {
+        std::string method;
+        std::string path;
+        std::string headers;  // Raw header block, including the request line
+        std::string body;
+        std::string localIp;  // Listener address the request arrived on
+    };
+    struct Reply {
+        std::string data;     // Raw bytes written back, status line included
+        bool close = true;    // Close after this reply; otherwise wait for the next request
+        uint32_t holdMs = 0;  // With close, keep the socket open this long first (a server that never ends the body)
+        uint32_t delayMs = 0; // Wait this long before answering
+        size_t splitAt = 0;   // Send this many bytes, pause splitMs, then the rest (one reply over two reads)
+        uint32_t splitMs = 20;
+    };
+    using Handler = std::function<Reply(const Request&)>;
+
+    ~StandInServer() { stop(); }
+
+    // port 0 picks a free port; returns the bound port, 0 on failure
+    uint16_t listenOn(const char* ip, uint16_t port = 0) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return 0;
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        inet_pton(AF_INET, ip, &addr.sin_addr);
+        socklen_t len = sizeof(addr);
+        if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, 128) != 0 ||
+            getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) {
+            ::close(fd);
+            return 0;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        _listeners.push_back(fd);
+        return ntohs(addr.sin_port);
+    }
+
+    void start(Handler handler) {
+        _handler = handler;
+        _running = true;
+        _thread = std::thread([this]() { serve(); });
+    }
+
+    void stop() {
+        if (_running.exchange(false) && _thread.joinable()) _thread.join();
+        for (int fd : _listeners) ::close(fd);
+        _listeners.clear();
+    }
+
+    uint32_t connections() const { return _connections; }
+    uint32_t requests() const { return _requests; }
+    void resetCounters() {
+        _connections = 0;
+        _requests = 0;
+    }
+
+    static Reply ok(const std::string& body, const char* contentType = "text/xml", bool keepAlive = false) {
+        Reply reply;
+        reply.data = std::string("HTTP/1.1 200 OK\r\nContent-Type: ") + contentType +
+                     "\r\nContent-Length: " + std::to_string(body.size()) +
+                     (keepAlive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n") + body;
+        reply.close = !keepAlive;
+        return reply;
+    }
+    static Reply status(int code, const char* reason) {
+        Reply reply;
+        reply.data = "HTTP/1.1 " + std::to_string(code) + " " + reason + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        return reply;
+    }
+
+private:
+    struct Connection {
+        int fd;
+        std::string in;
+        std::string localIp;
+        unsigned long closeAt = 0;  // Holding a reply open; no more reads
+    };
+
+    std::vector<int> _listeners;
+    std::vector<Connection> _open;
+    Handler _handler;
+    std::thread _thread;
+    std::atomic<bool> _running{false};
+    std::atomic<uint32_t> _connections{0};
+    std::atomic<uint32_t> _requests{0};
+
+    void serve() {
+        while (_running) {
+            std::vector<struct pollfd> fds;
+            for (int fd : _listeners) fds.push_back({fd, POLLIN, 0});
+            for (const auto& c : _open) fds.push_back({c.fd, (short)(c.closeAt ? 0 : POLLIN), 0});
+            poll(fds.data(), fds.size(), 5);
+
+            for (size_t i = 0; i < _listeners.size(); i++) {
+                if (!(fds[i].revents & POLLIN)) continue;
+                while (true) {
+                    struct sockaddr_in local = {};
+                    socklen_t len = sizeof(local);
+                    int fd = accept(_listeners[i], nullptr, nullptr);
+                    if (fd < 0) break;
+                    getsockname(fd, reinterpret_cast<struct sockaddr*>(&local), &len);
+                    char ip[INET_ADDRSTRLEN];
+                    inet_ntop(AF_INET, &local.sin_addr, ip, sizeof(ip));
+                    _open.push_back({fd, std::string(), ip, 0});
+                    _connections++;
+                }
+            }
+
+            unsigned long now = millis();
+            for (size_t i = 0; i < _open.size();) {
+                Connection& c = _open[i];
+                bool drop = false;
+                if (c.closeAt != 0) {
+                    drop = (long)(now - c.closeAt) >= 0;
+                } else {
+                    char buffer[4096];
+                    ssize_t n = recv(c.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+                    if (n > 0) c.in.append(buffer, n);
+                    else if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) drop = true;
+                    while (!drop && c.closeAt == 0 && answer(c)) {
+                    }
+                    if (c.closeAt == 1) drop = true;
+                }
+                if (drop) {
+                    ::close(c.fd);
+                    _open[i] = _open.back();
+                    _open.pop_back();
+                } else {
+                    i++;
+                }
+            }
+        }
+        for (const auto& c : _open) ::close(c.fd);
+        _open.clear();
+    }
+
+    // Answers one complete request from c.in; false when none is buffered yet
+    bool answer(Connection& c) {
+        size_t headerEnd = c.in.find("\r\n\r\n");
+        if (headerEnd == std::string::npos) return false;
+        Request request;
+        request.headers = c.in.substr(0, headerEnd + 4);
+        size_t bodyLen = 0;
+        size_t lengthAt = findHeader(request.headers, "content-length:");
+        if (lengthAt != std::string::npos) bodyLen = strtoul(request.headers.c_str() + lengthAt, nullptr, 10);
+        if (c.in.size() < headerEnd + 4 + bodyLen) return false;
+        request.body = c.in.substr(headerEnd + 4, bodyLen);
+        c.in.erase(0, headerEnd + 4 + bodyLen);
+        size_t space = request.headers.find(' ');
+        request.method = request.headers.substr(0, space);
+        request.path = request.headers.substr(space + 1, request.headers.find(' ', space + 1) - space - 1);
+        request.localIp = c.localIp;
+        _requests++;
+
+        Reply reply = _handler(request);
+        if (reply.delayMs > 0) delay(reply.delayMs);
+        if (reply.splitAt > 0 && reply.splitAt < reply.data.size()) {
+            sendAll(c.fd, reply.data.substr(0, reply.splitAt));
+            delay(reply.splitMs);
+            sendAll(c.fd, reply.data.substr(reply.splitAt));
+        } else {
+            sendAll(c.fd, reply.data);
+        }
+        if (reply.close) c.closeAt = reply.holdMs > 0 ? millis() + reply.holdMs : 1;
+        return true;
+    }
+
+    static size_t findHeader(const std::string& headers, const char* lowerName) {
+        std::string lower = headers;
+        for (auto& ch : lower) ch = tolower(ch);
+        size_t at = lower.find(std::string("\r\n") + lowerName);
+        return at == std::string::npos ? at : at + 2 + strlen(lowerName);
+    }
+
+    static void sendAll(int fd, const std::string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += n;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                struct pollfd p = {fd, POLLOUT, 0};
+                poll(&p, 1, 10);
+            } else {
+                return;
+            }
+        }
+    }
+};
@@ -0,0 +1,184 @@
+#pragma once
+// Simulated Sonos speakers for host tests. Speaker i lives at 127.0.(1 + i / 250).(1 + i % 250),
+// serves a device description on port 1400, answers M-SEARCH and can announce itself by NOTIFY.
+// Multicast traffic goes through the loopback ports in HostNetwork.h.
+#include <Arduino.h>
+#include <random>
+#include "HostNetwork.h"
+#include "StandInServer.h"
+
+class StandInSpeakers {
+public:
+    static const uint16_t DESCRIPTION_PORT = 1400;
+
+    ~StandInSpeakers() { stop(); }
+
+    // Starts count speakers. M-SEARCH answers are spread over replySpreadMs, as speakers
+    // spread theirs over MX; 0 answers at once.
+    bool start(size_t count, uint32_t replySpreadMs = 0, uint32_t descriptionDelayMs = 0) {
+        _count = count;
+        _replySpreadMs = replySpreadMs;
+        _descriptionDelayMs = descriptionDelayMs;
+        for (size_t i = 0; i < count; i++) {
+            if (_server.listenOn(ip(i).c_str(), DESCRIPTION_PORT) == 0) return false;
+        }
+        _server.start([this](const StandInServer::Request& request) { return describe(request); });
+
+        _ssdpFd = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len = sizeof(addr);
+        if (bind(_ssdpFd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            getsockname(_ssdpFd, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) {
+            return false;
+        }
+        HostNet::multicastSendPort = ntohs(addr.sin_port);
+        _running = true;
+        _ssdpThread = std::thread([this]() { answerSearches(); });
+        return true;
+    }
+
+    void stop() {
+        if (_running.exchange(false) && _ssdpThread.joinable()) _ssdpThread.join();
+        if (_ssdpFd >= 0) ::close(_ssdpFd);
+        _ssdpFd = -1;
+        _server.stop();
+        HostNet::multicastSendPort = 0;
+    }
+
+    static std::string ip(size_t index) {
+        return "127.0." + std::to_string(1 + index / 250) + "." + std::to_string(1 + index % 250);
+    }
+    static std::string uuid(size_t index) {
+        char id[40];
+        snprintf(id, sizeof(id), "uuid:RINCON_%012zX01400", index + 1);
+        return id;
+    }
+    static std::string roomName(size_t index) { return "Room " + std::to_string(index + 1); }
+
+    // ssdp:alive or ssdp:byebye to the NOTIFY listener port
+    void notify(size_t index, bool alive, uint32_t maxAgeSeconds = 1800, int bootId = 1) {
+        std::string packet = "NOTIFY * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\n";
+        if (alive) {
+            packet += "CACHE-CONTROL: max-age = " + std::to_string(maxAgeSeconds) + "\r\n" + "LOCATION: " + location(index) + "\r\n";
+        }
+        packet += "NT: urn:schemas-upnp-org:device:ZonePlayer:1\r\n";
+        packet += std::string("NTS: ") + (alive ? "ssdp:alive" : "ssdp:byebye") + "\r\n";
+        packet += "USN: " + uuid(index) + "::urn:schemas-upnp-org:device:ZonePlayer:1\r\n";
+        packet += "BOOTID.UPNP.ORG: " + std::to_string(bootId) + "\r\nCONFIGID.UPNP.ORG: 1\r\n\r\n";
+        sendTo(packet, htonl(INADDR_LOOPBACK), HostNet::multicastListenPort);
+    }
+
+    uint32_t searchesReceived() const { return _searches; }
+    uint32_t datagramsSent() const { return _datagramsSent; }
+    uint32_t descriptionRequests() const { return _server.requests(); }
+    void resetCounters() {
+        _searches = 0;
+        _datagramsSent = 0;
+        _server.resetCounters();
+    }
+
+private:
+    StandInServer _server;
+    size_t _count = 0;
+    uint32_t _replySpreadMs = 0;
+    uint32_t _descriptionDelayMs = 0;
+    int _ssdpFd = -1;
+    std::thread _ssdpThread;
+    std::atomic<bool> _running{false};
+    std::atomic<uint32_t> _searches{0};
+    std::atomic<uint32_t> _datagramsSent{0};
+
+    static std::string location(size_t index) {
+        return "http://" + ip(index) + ":" + std::to_string(DESCRIPTION_PORT) + "/xml/device_description.xml";
+    }
+
+    // Real descriptions run to several KB; the fields discovery needs come first
+    StandInServer::Reply describe(const StandInServer::Request& request) {
+        size_t index = indexOf(request.localIp);
+        if (request.path != "/xml/device_description.xml" || index >= _count) return StandInServer::status(404, "Not Found");
+        std::string xml = "<?xml version=\"1.0\" encoding=\"utf-8\"?><root xmlns=\"urn:schemas-upnp-org:device-1-0\">"
+                          "<device><deviceType>urn:schemas-upnp-org:device:ZonePlayer:1</deviceType>"
+                          "<roomName>" + roomName(index) + "</roomName><UDN>" + uuid(index) + "</UDN>"
+                          "<internalSpeakerSize>3</internalSpeakerSize><serviceList>";
+        for (int s = 0; s < 40; s++) {
+            xml += "<service><serviceType>urn:schemas-upnp-org:service:Service" + std::to_string(s) +
+                   ":1</serviceType><controlURL>/MediaRenderer/Service" + std::to_string(s) + "/Control</controlURL></service>";
+        }
+        xml += "</serviceList></device></root>";
+        StandInServer::Reply reply = StandInServer::ok(xml);
+        reply.delayMs = _descriptionDelayMs;
+        return reply;
+    }
+
+    static size_t indexOf(const std::string& address) {
+        unsigned a, b, c, d;
+        if (sscanf(address.c_str(), "%u.%u.%u.%u", &a, &b, &c, &d) != 4 || a != 127 || b != 0 || c == 0 || d == 0) return SIZE_MAX;
+        return (c - 1) * 250 + (d - 1);
+    }
+
+    void answerSearches() {
+        struct Pending {
+            unsigned long dueMs;
+            std::string packet;
+            struct sockaddr_in to;
+        };
+        std::vector<Pending> pending;
+        std::mt19937 random(1234);
+        while (_running) {
+            struct pollfd p = {_ssdpFd, POLLIN, 0};
+            poll(&p, 1, 1);
+            char buffer[1024];
+            struct sockaddr_in from = {};
+            socklen_t len = sizeof(from);
+            ssize_t n = recvfrom(_ssdpFd, buffer, sizeof(buffer) - 1, MSG_DONTWAIT, reinterpret_cast<struct sockaddr*>(&from), &len);
+            if (n > 0) {
+                buffer[n] = '\0';
+                std::string search(buffer);
+                if (search.rfind("M-SEARCH", 0) == 0) {
+                    _searches++;
+                    std::string st = headerValue(search, "ST:");
+                    for (size_t i = 0; i < _count; i++) {
+                        if (st.rfind("uuid:", 0) == 0 && st != uuid(i)) continue;
+                        std::string packet = "HTTP/1.1 200 OK\r\nCACHE-CONTROL: max-age = 1800\r\nEXT:\r\nLOCATION: " + location(i) +
+                                             "\r\nSERVER: Linux UPnP/1.0 Sonos/70.3-88200 (ZPS9)\r\nST: " + st + "\r\nUSN: " + uuid(i) +
+                                             (st.rfind("uuid:", 0) == 0 ? "" : "::" + st) +
+                                             "\r\nBOOTID.UPNP.ORG: 1\r\nCONFIGID.UPNP.ORG: 1\r\n\r\n";
+                        unsigned long due = millis() + (_replySpreadMs > 0 ? random() % _replySpreadMs : 0);
+                        pending.push_back({due, packet, from});
+                    }
+                }
+            }
+            unsigned long now = millis();
+            for (size_t i = 0; i < pending.size();) {
+                if ((long)(now - pending[i].dueMs) >= 0) {
+                    sendTo(pending[i].packet, pending[i].to.sin_addr.s_addr, ntohs(pending[i].to.sin_port));
+                    pending[i] = pending.back();
+                    pending.pop_back();
+                } else {
+                    i++;
+                }
+            }
+        }
+    }
+
+    static std::string headerValue(const std::string& packet, const char* name) {
+        size_t at = packet.find(std::string("\r\n") + name);
+        if (at == std::string::npos) return std::string();
+        at += 2 + strlen(name);
+        while (at < packet.size() && packet[at] == ' ') at++;
+        return packet.substr(at, packet.find("\r\n", at) - at);
+    }
+
+    void sendTo(const std::string& packet, uint32_t address, uint16_t port) {
+        if (port == 0) return;
+        int fd = _ssdpFd >= 0 ? _ssdpFd : socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in to = {};
+        to.sin_family = AF_INET;
+        to.sin_addr.s_addr = address;
+        to.sin_port = htons(port);
+        if (sendto(fd, packet.data(), packet.size(), 0, reinterpret_cast<struct sockaddr*>(&to), sizeof(to)) > 0) _datagramsSent++;
+        if (fd != _ssdpFd) ::close(fd);
+    }
+};
@@ -0,0 +1,9 @@
+#pragma once
+// Host stand-in for TJpg_Decoder. The library's Arduino front end needs SD and SPIFFS, so host
+// builds compile only its tjpgd core (see native_decoders.py) and take the workspace size from here.
+#include <Arduino.h>
+extern "C" {
+#include <tjpgd.h>
+}
+
+#define TJPGD_WORKSPACE_SIZE 3100
@@ -0,0 +1,28 @@
+#pragma once
+// Host stand-in for the WiFi singleton; tests choose the link state in HostNetwork.h
+#include <Arduino.h>
+#include <WiFiClient.h>
+#include <WiFiServer.h>
+#include <WiFiUdp.h>
+#include "HostNetwork.h"
+
+typedef enum {
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+class WiFiClass {
+public:
+    wl_status_t status() { return HostNet::connected ? WL_CONNECTED : WL_DISCONNECTED; }
+    bool isConnected() { return HostNet::connected; }
+    IPAddress localIP() { return HostNet::localIP; }
+    IPAddress subnetMask() { return IPAddress(255, 0, 0, 0); }
+    IPAddress gatewayIP() { return IPAddress(127, 0, 0, 1); }
+    int8_t RSSI() { return -50; }
+};
+
+inline WiFiClass WiFi;
@@ -0,0 +1,152 @@
+#pragma once
+// Host stand-in for WiFiClient on a blocking-connect, non-blocking-read TCP socket. Copies share
+// the socket, as they do on the device.
+#include <Arduino.h>
+#include <Client.h>
+#include <errno.h>
+#include <memory>
+#include <netdb.h>
+#include <poll.h>
+#include <lwip/sockets.h>
+
+class WiFiClient : public Client {
+public:
+    WiFiClient() {}
+    explicit WiFiClient(int fd) : _socket(std::make_shared<Socket>(fd)) {}
+    virtual ~WiFiClient() {}
+
+    int connect(IPAddress ip, uint16_t port) override { return connect(ip, port, _connectTimeoutMs); }
+    int connect(const char* host, uint16_t port) override { return connect(host, port, _connectTimeoutMs); }
+    int connect(const char* host, uint16_t port, int32_t timeoutMs) {
+        IPAddress ip;
+        if (!ip.fromString(host)) {
+            struct addrinfo hints = {}, *found = nullptr;
+            hints.ai_family = AF_INET;
+            if (getaddrinfo(host, nullptr, &hints, &found) != 0 || found == nullptr) return 0;
+            ip = IPAddress(reinterpret_cast<struct sockaddr_in*>(found->ai_addr)->sin_addr.s_addr);
+            freeaddrinfo(found);
+        }
+        return connect(ip, port, timeoutMs);
+    }
+    virtual int connect(IPAddress ip, uint16_t port, int32_t timeoutMs) {
+        stop();
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return 0;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = (uint32_t)ip;
+        int res = ::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+        if (res < 0 && errno == EINPROGRESS) {
+            struct pollfd pfd = {fd, POLLOUT, 0};
+            int err = 0;
+            socklen_t len = sizeof(err);
+            if (poll(&pfd, 1, timeoutMs) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0) res = 0;
+        }
+        if (res < 0) {
+            ::close(fd);
+            return 0;
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        _socket = std::make_shared<Socket>(fd);
+        return 1;
+    }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        if (!_socket) return 0;
+        size_t sent = 0;
+        unsigned long start = millis();
+        while (sent < size && millis() - start < _timeoutMs) {
+            ssize_t n = ::send(_socket->fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                sent += n;
+            } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                struct pollfd pfd = {_socket->fd, POLLOUT, 0};
+                poll(&pfd, 1, 10);
+            } else {
+                break;
+            }
+        }
+        return sent;
+    }
+    using Print::write;
+
+    int available() override {
+        if (!_socket) return 0;
+        int pending = 0;
+        if (ioctl(_socket->fd, FIONREAD, &pending) < 0) return 0;
+        return pending;
+    }
+    int read() override {
+        uint8_t c;
+        return read(&c, 1) == 1 ? c : -1;
+    }
+    int read(uint8_t* buffer, size_t size) override {
+        if (!_socket) return -1;
+        ssize_t n = ::recv(_socket->fd, buffer, size, MSG_DONTWAIT);
+        if (n == 0) _socket->peerClosed = true;
+        return n > 0 ? (int)n : (n == 0 ? 0 : -1);
+    }
+    int peek() override {
+        if (!_socket) return -1;
+        uint8_t c;
+        return ::recv(_socket->fd, &c, 1, MSG_DONTWAIT | MSG_PEEK) == 1 ? c : -1;
+    }
+    void flush() override {}
+
+    void stop() override {
+        if (_socket) _socket->close();
+        _socket.reset();
+    }
+    // True while the socket is open and either has data or the peer has not closed it
+    uint8_t connected() override {
+        if (!_socket || _socket->fd < 0) return 0;
+        uint8_t c;
+        ssize_t n = ::recv(_socket->fd, &c, 1, MSG_DONTWAIT | MSG_PEEK);
+        if (n > 0) return 1;
+        if (n == 0) return 0;
+        return errno == EAGAIN || errno == EWOULDBLOCK ? 1 : 0;
+    }
+    operator bool() override { return connected(); }
+
+    IPAddress remoteIP() const {
+        struct sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+        if (!_socket || getpeername(_socket->fd, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) return IPAddress();
+        return IPAddress(addr.sin_addr.s_addr);
+    }
+    uint16_t remotePort() const {
+        struct sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+        if (!_socket || getpeername(_socket->fd, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) return 0;
+        return ntohs(addr.sin_port);
+    }
+    IPAddress localIP() const {
+        struct sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+        if (!_socket || getsockname(_socket->fd, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) return IPAddress();
+        return IPAddress(addr.sin_addr.s_addr);
+    }
+    int setNoDelay(bool) { return 0; }
+    void setConnectionTimeout(uint32_t ms) { _connectTimeoutMs = ms; }
+    int fd() const { return _socket ? _socket->fd : -1; }
+
+    bool operator==(const WiFiClient& other) const { return _socket == other._socket; }
+
+protected:
+    struct Socket {
+        int fd;
+        bool peerClosed = false;
+        explicit Socket(int f) : fd(f) {}
+        ~Socket() { close(); }
+        void close() {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+    };
+    std::shared_ptr<Socket> _socket;
+    int32_t _connectTimeoutMs = 3000;
+};
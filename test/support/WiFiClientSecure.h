@@ -0,0 +1,15 @@
+#pragma once
+// Host stand-in for WiFiClientSecure. There is no TLS on the host: connections are plain TCP,
+// so a test server can count them, and each one is where the device would pay for a handshake.
+#include <WiFiClient.h>
+
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setInsecure() { _insecure = true; }
+    void setCACert(const char*) {}
+    void setHandshakeTimeout(unsigned long) {}
+    bool insecure() const { return _insecure; }
+
+private:
+    bool _insecure = false;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include <WiFiClient.h>
+
+class WiFiServer {
+public:
+    explicit WiFiServer(uint16_t port = 80, uint8_t = 4) : _port(port) {}
+    ~WiFiServer() { end(); }
+
+    void begin(uint16_t port = 0) {
+        if (port != 0) _port = port;
+        end();
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(_port);
+        addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        if (bind(_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0 || listen(_fd, 16) != 0) {
+            end();
+            return;
+        }
+        fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+    }
+    void end() {
+        if (_fd >= 0) ::close(_fd);
+        _fd = -1;
+    }
+    void stop() { end(); }
+    WiFiClient available() { return accept(); }
+    WiFiClient accept() {
+        if (_fd < 0) return WiFiClient();
+        int fd = ::accept(_fd, nullptr, nullptr);
+        return fd >= 0 ? WiFiClient(fd) : WiFiClient();
+    }
+    bool hasClient() {
+        struct pollfd pfd = {_fd, POLLIN, 0};
+        return _fd >= 0 && poll(&pfd, 1, 0) == 1;
+    }
+    void setNoDelay(bool) {}
+    operator bool() const { return _fd >= 0; }
+
+private:
+    uint16_t _port;
+    int _fd = -1;
+};
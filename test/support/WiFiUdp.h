@@ -0,0 +1,130 @@
+#pragma once
+// Host stand-in for WiFiUDP on a non-blocking datagram socket. Multicast is redirected to
+// loopback as configured in HostNetwork.h.
+#include <Arduino.h>
+#include <errno.h>
+#include <lwip/sockets.h>
+#include "HostNetwork.h"
+
+class WiFiUDP : public Stream {
+public:
+    ~WiFiUDP() { stop(); }
+
+    uint8_t begin(uint16_t port) { return open(htonl(INADDR_ANY), port); }
+    uint8_t beginMulticast(IPAddress, uint16_t port) {
+        return open(htonl(INADDR_LOOPBACK), HostNet::multicastListenPort != 0 ? HostNet::multicastListenPort : port);
+    }
+    void stop() {
+        if (_fd >= 0) ::close(_fd);
+        _fd = -1;
+        _rx.clear();
+        _rxPos = 0;
+    }
+
+    int beginPacket(IPAddress ip, uint16_t port) {
+        _tx.clear();
+        _txIp = ip;
+        _txPort = port;
+        if ((ip[0] & 0xF0) == 0xE0) {
+            if (HostNet::multicastSendPort == 0) return 0;
+            _txIp = IPAddress(127, 0, 0, 1);
+            _txPort = HostNet::multicastSendPort;
+        }
+        return 1;
+    }
+    int beginPacket(const char* host, uint16_t port) {
+        IPAddress ip;
+        return ip.fromString(host) ? beginPacket(ip, port) : 0;
+    }
+    size_t write(uint8_t c) override {
+        _tx.push_back(c);
+        return 1;
+    }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        _tx.insert(_tx.end(), buffer, buffer + size);
+        return size;
+    }
+    using Print::write;
+    int endPacket() {
+        if (_fd < 0 && !open(htonl(INADDR_ANY), 0)) return 0;
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(_txPort);
+        addr.sin_addr.s_addr = (uint32_t)_txIp;
+        ssize_t sent = ::sendto(_fd, _tx.data(), _tx.size(), 0, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+        _tx.clear();
+        return sent >= 0 ? 1 : 0;
+    }
+
+    int parsePacket() {
+        if (_fd < 0) return 0;
+        _rx.resize(65536);
+        struct sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+        ssize_t n = ::recvfrom(_fd, _rx.data(), _rx.size(), MSG_DONTWAIT, reinterpret_cast<struct sockaddr*>(&addr), &len);
+        if (n <= 0) {
+            _rx.clear();
+            _rxPos = 0;
+            return 0;
+        }
+        _rx.resize(n);
+        _rxPos = 0;
+        _remoteIp = IPAddress(addr.sin_addr.s_addr);
+        _remotePort = ntohs(addr.sin_port);
+        return (int)n;
+    }
+    int available() override { return (int)(_rx.size() - _rxPos); }
+    int read() override { return _rxPos < _rx.size() ? _rx[_rxPos++] : -1; }
+    int read(unsigned char* buffer, size_t len) {
+        size_t n = min(len, _rx.size() - _rxPos);
+        memcpy(buffer, _rx.data() + _rxPos, n);
+        _rxPos += n;
+        return (int)n;
+    }
+    int read(char* buffer, size_t len) { return read(reinterpret_cast<unsigned char*>(buffer), len); }
+    int peek() override { return _rxPos < _rx.size() ? _rx[_rxPos] : -1; }
+    void flush() override {
+        _rx.clear();
+        _rxPos = 0;
+    }
+    IPAddress remoteIP() const { return _remoteIp; }
+    uint16_t remotePort() const { return _remotePort; }
+
+    // Host only: the bound port, for sockets opened on port 0
+    uint16_t localPort() const {
+        struct sockaddr_in addr = {};
+        socklen_t len = sizeof(addr);
+        if (_fd < 0 || getsockname(_fd, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) return 0;
+        return ntohs(addr.sin_port);
+    }
+
+private:
+    int _fd = -1;
+    std::vector<uint8_t> _tx;
+    IPAddress _txIp;
+    uint16_t _txPort = 0;
+    std::vector<uint8_t> _rx;
+    size_t _rxPos = 0;
+    IPAddress _remoteIp;
+    uint16_t _remotePort = 0;
+
+    uint8_t open(uint32_t address, uint16_t port) {
+        stop();
+        _fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (_fd < 0) return 0;
+        int one = 1;
+        setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (HostNet::udpReceiveBuffer > 0) {
+            setsockopt(_fd, SOL_SOCKET, SO_RCVBUF, &HostNet::udpReceiveBuffer, sizeof(HostNet::udpReceiveBuffer));
+        }
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = address;
+        if (bind(_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) != 0) {
+            stop();
+            return 0;
+        }
+        return 1;
+    }
+};
@@ -0,0 +1,29 @@
+#pragma once
+// Host stand-in for ESP-IDF's capability-based allocator; every capability maps to malloc
+#include <stdlib.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_8BIT (1 << 2)
+#define MALLOC_CAP_INTERNAL (1 << 11)
+#define MALLOC_CAP_SPIRAM (1 << 10)
+#define MALLOC_CAP_DEFAULT (1 << 12)
+
+inline void* heap_caps_malloc(size_t size, uint32_t) {
+    return malloc(size);
+}
+
+inline void* heap_caps_calloc(size_t count, size_t size, uint32_t) {
+    return calloc(count, size);
+}
+
+inline void heap_caps_free(void* memory) {
+    free(memory);
+}
+
+inline size_t heap_caps_get_free_size(uint32_t) {
+    return 8 * 1024 * 1024;
+}
+
+inline size_t heap_caps_get_largest_free_block(uint32_t) {
+    return 4 * 1024 * 1024;
+}
@@ -0,0 +1,14 @@
+#pragma once
+// Host stand-in for the ROM CRC routines. esp_rom_crc32_le is the zlib/IEEE CRC-32, so files
+// written on the host verify on the device and the other way round.
+#include <stdint.h>
+#include <stddef.h>
+
+inline uint32_t esp_rom_crc32_le(uint32_t crc, const uint8_t* buf, uint32_t len) {
+    crc = ~crc;
+    for (uint32_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int bit = 0; bit < 8; bit++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
@@ -0,0 +1,20 @@
+#pragma once
+// Host stand-in for the deep-sleep API. Tests set hostWakeupCause to simulate a wake.
+#include <stdint.h>
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED = 0,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+    ESP_SLEEP_WAKEUP_GPIO,
+} esp_sleep_wakeup_cause_t;
+
+inline esp_sleep_wakeup_cause_t hostWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+
+inline esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause() {
+    return hostWakeupCause;
+}
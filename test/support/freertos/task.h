@@ -0,0 +1,56 @@
+#pragma once
+#include "FreeRTOS.h"
+
+// Tasks run on detached threads and live until the process exits, like tasks that never return
+inline BaseType_t xTaskCreatePinnedToCore(TaskFunction_t entry, const char*, uint32_t, void* arg, UBaseType_t,
+                                          TaskHandle_t* handle, BaseType_t) {
+    HostTask* task = new HostTask();
+    if (handle != nullptr) *handle = task;
+    std::thread([entry, arg, task]() {
+        hostCurrentTask = task;
+        entry(arg);
+    }).detach();
+    return pdPASS;
+}
+
+inline BaseType_t xTaskCreate(TaskFunction_t entry, const char* name, uint32_t stack, void* arg, UBaseType_t priority,
+                              TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(entry, name, stack, arg, priority, handle, tskNO_AFFINITY);
+}
+
+inline BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+    {
+        std::lock_guard<std::mutex> lock(task->mutex);
+        task->notifications++;
+    }
+    task->wake.notify_one();
+    return pdPASS;
+}
+
+inline uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait) {
+    HostTask* task = hostCurrentTask;
+    if (task == nullptr) return 0;
+    std::unique_lock<std::mutex> lock(task->mutex);
+    auto hasNotification = [task]() { return task->notifications > 0; };
+    if (ticksToWait == portMAX_DELAY) {
+        task->wake.wait(lock, hasNotification);
+    } else {
+        task->wake.wait_for(lock, std::chrono::milliseconds(ticksToWait), hasNotification);
+    }
+    uint32_t count = task->notifications;
+    if (count > 0) task->notifications = clearOnExit ? 0 : count - 1;
+    return count;
+}
+
+inline void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+inline TickType_t xTaskGetTickCount() {
+    static const auto start = std::chrono::steady_clock::now();
+    return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+inline BaseType_t xPortGetCoreID() {
+    return hostCurrentTask != nullptr ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+# Host tests decode with the device's own decoder code: tjpgd.c from the TJpg_Decoder package
+# (the library itself is ignored, its Arduino front end needs SD and SPIFFS) and tinfl from
+# miniz, standing in for the copy in the ESP32 ROM.
+import os
+
+Import("env")
+
+libdeps = os.path.join(env.subst("$PROJECT_LIBDEPS_DIR"), env.subst("$PIOENV"))
+for package, subdir, source in (("TJpg_Decoder", "src", "tjpgd.c"), ("miniz", "", "miniz.c")):
+    source_dir = os.path.join(libdeps, package, subdir)
+    env.Append(CPPPATH=[source_dir])
+    env.BuildSources(os.path.join("$BUILD_DIR", package), source_dir, "-<*> +<%s>" % source)
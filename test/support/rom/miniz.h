@@ -0,0 +1,6 @@
+#pragma once
+// Host stand-in for the ROM tinfl inflater: the same tinfl from the miniz library (see
+// native_decoders.py), so output wraps through the caller's 32 KB window just as on the device.
+// zlib-compatible names stay off so tests can build PNGs with zlib alongside it.
+#define MINIZ_NO_ZLIB_COMPATIBLE_NAMES
+#include <miniz.h>
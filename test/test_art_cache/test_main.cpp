@@ -0,0 +1,199 @@
+// Art cache robustness: damaged entries are dropped rather than shown, and files the index no
+// longer accounts for are cleared so they cannot sit outside the byte budget.
+#include <unity.h>
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include <vector>
+#include "ArtCache.h"
+
+namespace {
+
+const size_t HEADER_BYTES = 20;  // ArtHeader on flash
+
+struct Loaded {
+    bool ok = false;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    uint16_t rows = 0;
+};
+
+Loaded load(ArtCache& cache, const String& url) {
+    Loaded out;
+    out.ok = cache.load(url,
+        [&out](uint16_t w, uint16_t h) {
+            out.width = w;
+            out.height = h;
+            return true;
+        },
+        [&out](uint16_t, const uint16_t*) { out.rows++; });
+    return out;
+}
+
+std::vector<uint16_t> solidImage(uint16_t w, uint16_t h) {
+    return std::vector<uint16_t>((size_t)w * h, 0x1234);
+}
+
+// Distinct neighbours, so the entry is stored raw
+std::vector<uint16_t> noisyImage(uint16_t w, uint16_t h) {
+    std::vector<uint16_t> pixels((size_t)w * h);
+    for (size_t i = 0; i < pixels.size(); i++) pixels[i] = (uint16_t)(i * 2654435761u >> 7);
+    return pixels;
+}
+
+String entryPath(const String& url) {
+    char path[20];
+    snprintf(path, sizeof(path), "/art/%08lx.bin", (unsigned long)ArtCache::hashUrl(url));
+    return String(path);
+}
+
+std::vector<uint8_t> readFile(const String& path) {
+    File file = LittleFS.open(path, "r");
+    std::vector<uint8_t> bytes(file.size());
+    file.read(bytes.data(), bytes.size());
+    file.close();
+    return bytes;
+}
+
+void writeFile(const String& path, const std::vector<uint8_t>& bytes) {
+    File file = LittleFS.open(path, "w");
+    file.write(bytes.data(), bytes.size());
+    file.close();
+}
+
+// Rewrites the payload CRC, so only the deliberate damage is left for the cache to find
+void resealPayload(std::vector<uint8_t>& entry) {
+    uint32_t crc = esp_rom_crc32_le(0, &entry[HEADER_BYTES], entry.size() - HEADER_BYTES);
+    memcpy(&entry[16], &crc, sizeof(crc));
+}
+
+size_t artFiles() {
+    size_t count = 0;
+    File dir = LittleFS.open("/art");
+    for (File file = dir.openNextFile(); file; file = dir.openNextFile()) count++;
+    return count;
+}
+
+}  // namespace
+
+void setUp() {
+    LittleFS.format();
+}
+
+void tearDown() {}
+
+void test_entries_round_trip() {
+    ArtCache cache;
+    TEST_ASSERT_TRUE(cache.begin());
+    std::vector<uint16_t> solid = solidImage(94, 94), noisy = noisyImage(94, 94);
+    TEST_ASSERT_TRUE(cache.store("http://art/solid.jpg", solid.data(), 94, 94));
+    TEST_ASSERT_TRUE(cache.store("http://art/noisy.jpg", noisy.data(), 94, 94));
+    Loaded loaded = load(cache, "http://art/solid.jpg");
+    TEST_ASSERT_TRUE(loaded.ok);
+    TEST_ASSERT_EQUAL(94, loaded.rows);
+    TEST_ASSERT_TRUE(load(cache, "http://art/noisy.jpg").ok);
+    TEST_ASSERT_EQUAL(2, cache.hits());
+}
+
+void test_undecodable_rle_entry_is_dropped() {
+    ArtCache cache;
+    cache.begin();
+    std::vector<uint16_t> solid = solidImage(94, 94);
+    TEST_ASSERT_TRUE(cache.store("http://art/solid.jpg", solid.data(), 94, 94));
+
+    // A run longer than the row, with a valid CRC over the damaged payload
+    String path = entryPath("http://art/solid.jpg");
+    std::vector<uint8_t> entry = readFile(path);
+    TEST_ASSERT_EQUAL(1, entry[8]);  // RLE
+    entry[HEADER_BYTES + 3 * 40] = 0xFF;
+    resealPayload(entry);
+    writeFile(path, entry);
+
+    Loaded loaded = load(cache, "http://art/solid.jpg");
+    TEST_ASSERT_FALSE(loaded.ok);
+    TEST_ASSERT_LESS_THAN(94, loaded.rows);
+    TEST_ASSERT_EQUAL(0, cache.hits());
+    TEST_ASSERT_FALSE(LittleFS.exists(path));
+    TEST_ASSERT_FALSE(load(cache, "http://art/solid.jpg").ok);
+}
+
+void test_raw_entry_with_wrong_size_is_dropped() {
+    ArtCache cache;
+    cache.begin();
+    std::vector<uint16_t> noisy = noisyImage(94, 94);
+    TEST_ASSERT_TRUE(cache.store("http://art/noisy.jpg", noisy.data(), 94, 94));
+
+    // The header is outside the CRC; a bigger height would read past the payload
+    String path = entryPath("http://art/noisy.jpg");
+    std::vector<uint8_t> entry = readFile(path);
+    TEST_ASSERT_EQUAL(0, entry[8]);  // Raw
+    entry[6] = 120;
+    writeFile(path, entry);
+
+    Loaded loaded = load(cache, "http://art/noisy.jpg");
+    TEST_ASSERT_FALSE(loaded.ok);
+    TEST_ASSERT_EQUAL(0, loaded.rows);
+    TEST_ASSERT_FALSE(LittleFS.exists(path));
+}
+
+void test_invalid_index_clears_orphaned_art() {
+    {
+        ArtCache cache;
+        cache.begin();
+        for (int i = 0; i < 5; i++) {
+            std::vector<uint16_t> noisy = noisyImage(94, 94);
+            noisy[0] = i;
+            TEST_ASSERT_TRUE(cache.store("http://art/" + String(i) + ".jpg", noisy.data(), 94, 94));
+        }
+    }
+    TEST_ASSERT_EQUAL(6, artFiles());
+
+    std::vector<uint8_t> index = readFile("/art/index.bin");
+    index[20] ^= 0xFF;
+    writeFile("/art/index.bin", index);
+
+    ArtCache cache;
+    TEST_ASSERT_TRUE(cache.begin());
+    TEST_ASSERT_EQUAL(0, artFiles());
+    TEST_ASSERT_FALSE(load(cache, "http://art/0.jpg").ok);
+}
+
+void test_missing_index_clears_orphaned_art() {
+    {
+        ArtCache cache;
+        cache.begin();
+        std::vector<uint16_t> noisy = noisyImage(94, 94);
+        TEST_ASSERT_TRUE(cache.store("http://art/a.jpg", noisy.data(), 94, 94));
+    }
+    LittleFS.remove("/art/index.bin");
+
+    ArtCache cache;
+    TEST_ASSERT_TRUE(cache.begin());
+    TEST_ASSERT_EQUAL(0, artFiles());
+}
+
+void test_index_is_written_through_a_rename() {
+    ArtCache cache;
+    cache.begin();
+    HostFs::resetCounters();
+    std::vector<uint16_t> noisy = noisyImage(94, 94);
+    TEST_ASSERT_TRUE(cache.store("http://art/a.jpg", noisy.data(), 94, 94));
+    TEST_ASSERT_EQUAL(1, HostFs::renames);
+    TEST_ASSERT_FALSE(LittleFS.exists("/art/index.tmp"));
+
+    ArtCache reopened;
+    reopened.begin();
+    TEST_ASSERT_TRUE(load(reopened, "http://art/a.jpg").ok);
+}
+
+int main() {
+    LittleFS.begin(true);
+    UNITY_BEGIN();
+    RUN_TEST(test_entries_round_trip);
+    RUN_TEST(test_undecodable_rle_entry_is_dropped);
+    RUN_TEST(test_raw_entry_with_wrong_size_is_dropped);
+    RUN_TEST(test_invalid_index_clears_orphaned_art);
+    RUN_TEST(test_missing_index_clears_orphaned_art);
+    RUN_TEST(test_index_is_written_through_a_rename);
+    return UNITY_END();
+}
@@ -0,0 +1,150 @@
+// Skipping quickly through tracks fires a burst of art requests. Only the cover of the track
+// that is finally left playing may be fetched to the end, decoded and published; the rest must
+// be dropped before they cost a download or a decode.
+#include <unity.h>
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <mutex>
+#include "ArtCache.h"
+#include "ArtWorker.h"
+#include "PngWriter.h"
+#include "StandInServer.h"
+
+namespace {
+
+const char* const ART_HOST = "127.0.4.3";
+const int COVERS = 12;
+const uint32_t SERVER_DELAY_MS = 150;  // Keeps the first fetch of a burst in flight while the rest arrive
+const unsigned long SKIP_INTERVAL_MS = 40;
+// Longer than the worker's debounce between back-to-back track changes
+const unsigned long SETTLED_MS = 400;
+
+StandInServer server;
+uint16_t port = 0;
+std::vector<std::string> covers;
+std::mutex pathsLock;
+std::vector<std::string> served;
+ArtCache* artCache = nullptr;
+ArtWorker* worker = nullptr;
+
+String coverUrl(int index) {
+    return String("http://") + ART_HOST + ":" + String(port) + "/cover" + String(index) + ".png";
+}
+
+std::vector<std::string> servedPaths() {
+    std::lock_guard<std::mutex> guard(pathsLock);
+    return served;
+}
+
+// Skips through covers [first, last] one per interval, then collects whatever the worker publishes
+std::vector<ArtWorker::Result*> skipThrough(int first, int last, unsigned long settleMs) {
+    for (int i = first; i <= last; i++) {
+        worker->request(coverUrl(i), ArtWorker::Purpose::Display);
+        if (i < last) delay(SKIP_INTERVAL_MS);
+    }
+    std::vector<ArtWorker::Result*> results;
+    unsigned long start = millis();
+    while (millis() - start < settleMs) {
+        ArtWorker::Result* result = worker->takeResult();
+        if (result != nullptr) results.push_back(result);
+        delay(1);
+    }
+    return results;
+}
+
+void releaseAll(std::vector<ArtWorker::Result*>& results) {
+    for (ArtWorker::Result* result : results) ArtWorker::release(result);
+    results.clear();
+}
+
+}  // namespace
+
+void setUp() {
+    std::lock_guard<std::mutex> guard(pathsLock);
+    served.clear();
+}
+
+void tearDown() {}
+
+void test_only_the_last_cover_of_a_burst_is_decoded() {
+    uint32_t cancelledBefore = worker->cancelled();
+    std::vector<ArtWorker::Result*> results = skipThrough(0, 4, 2000);
+
+    TEST_ASSERT_EQUAL(1, results.size());
+    TEST_ASSERT_TRUE(results[0]->ok);
+    TEST_ASSERT_EQUAL_STRING(coverUrl(4).c_str(), results[0]->image.url.c_str());
+    TEST_ASSERT_EQUAL_STRING("network", results[0]->source);
+
+    // The first skip was already in flight and is dropped once its headers arrive; the middle
+    // ones are replaced while they wait to settle and never reach the server
+    std::vector<std::string> paths = servedPaths();
+    printf("\nBurst of 5: %u fetched (", (unsigned)paths.size());
+    for (const std::string& path : paths) printf(" %s", path.c_str());
+    printf(" ), %u cancelled, last cover after %lu ms\n", worker->cancelled() - cancelledBefore,
+           results[0]->finishedMs - results[0]->requestedMs);
+    TEST_ASSERT_EQUAL(2, paths.size());
+    TEST_ASSERT_EQUAL_STRING("/cover0.png", paths[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("/cover4.png", paths[1].c_str());
+    TEST_ASSERT_EQUAL(1, worker->cancelled() - cancelledBefore);
+    releaseAll(results);
+}
+
+void test_burst_right_after_a_change_fetches_only_the_last_cover() {
+    // Wait out anything left from the previous test, then change track once and take its art
+    delay(SETTLED_MS);
+    worker->request(coverUrl(5), ArtWorker::Purpose::Display);
+    ArtWorker::Result* first = nullptr;
+    unsigned long start = millis();
+    while (first == nullptr && millis() - start < 1000) {
+        first = worker->takeResult();
+        delay(1);
+    }
+    TEST_ASSERT_NOT_NULL(first);
+    ArtWorker::release(first);
+    {
+        std::lock_guard<std::mutex> guard(pathsLock);
+        served.clear();
+    }
+
+    // Every request of this burst lands inside the settle window of the one before it
+    std::vector<ArtWorker::Result*> results = skipThrough(6, 11, 2000);
+    TEST_ASSERT_EQUAL(1, results.size());
+    TEST_ASSERT_TRUE(results[0]->ok);
+    TEST_ASSERT_EQUAL_STRING(coverUrl(11).c_str(), results[0]->image.url.c_str());
+    std::vector<std::string> paths = servedPaths();
+    TEST_ASSERT_EQUAL(1, paths.size());
+    TEST_ASSERT_EQUAL_STRING("/cover11.png", paths[0].c_str());
+    releaseAll(results);
+}
+
+int main() {
+    for (int i = 0; i < COVERS; i++) covers.push_back(PngWriter::testCard(300, 300, i));
+    port = server.listenOn(ART_HOST);
+    server.start([](const StandInServer::Request& request) {
+        {
+            std::lock_guard<std::mutex> guard(pathsLock);
+            served.push_back(request.path);
+        }
+        int index = -1;
+        if (sscanf(request.path.c_str(), "/cover%d.png", &index) != 1 || index < 0 || index >= COVERS) {
+            return StandInServer::status(404, "Not Found");
+        }
+        StandInServer::Reply reply = StandInServer::ok(covers[index], "image/png", true);
+        reply.delayMs = SERVER_DELAY_MS;
+        return reply;
+    });
+    LittleFS.begin(true);
+    LittleFS.format();
+    artCache = new ArtCache();
+    artCache->begin();
+    worker = new ArtWorker(*artCache);
+    worker->begin(0);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_only_the_last_cover_of_a_burst_is_decoded);
+    RUN_TEST(test_burst_right_after_a_change_fetches_only_the_last_cover);
+    int failures = UNITY_END();
+    // The worker task never returns; leave without running destructors under it
+    fflush(stdout);
+    _exit(failures);
+}
@@ -0,0 +1,171 @@
+// JPEG art through the art worker and tjpgd: chroma layouts, sizes off the MCU grid, every
+// decode scale, files tjpgd cannot take, and the preview of a slow download followed by the
+// full-quality pass replayed from the spool. Each image is four flat quadrants, so the decoded
+// colours can be checked after compression, power-of-two scaling and area averaging.
+#include <unity.h>
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <map>
+#include "ArtCache.h"
+#include "ArtResampler.h"
+#include "ArtWorker.h"
+#include "JpegWriter.h"
+#include "StandInServer.h"
+
+namespace {
+
+const char* const ART_HOST = "127.0.4.4";
+const int MAX_CHANNEL_ERROR = 24;  // JPEG and RGB565 rounding at the centre of a flat quadrant
+
+StandInServer server;
+uint16_t port = 0;
+std::map<std::string, std::string> files;  // Path to JPEG bytes
+std::map<std::string, size_t> stalls;      // Path to body bytes sent before the download stalls
+const uint32_t STALL_MS = 400;             // Well past the worker's preview budget
+ArtCache* artCache = nullptr;
+ArtWorker* worker = nullptr;
+
+String artUrl(const std::string& path) {
+    return String("http://") + ART_HOST + ":" + String(port) + path.c_str();
+}
+
+// Waits out any preview for the final result; a preview taken on the way is handed to *preview
+ArtWorker::Result* fetchArt(const std::string& path, const std::string& jpeg, ArtWorker::Result** preview = nullptr) {
+    files[path] = jpeg;
+    worker->request(artUrl(path), ArtWorker::Purpose::Display);
+    unsigned long start = millis();
+    while (millis() - start < 5000) {
+        ArtWorker::Result* result = worker->takeResult();
+        if (result != nullptr && !result->preview) return result;
+        if (result != nullptr && preview != nullptr && *preview == nullptr) {
+            *preview = result;
+        } else if (result != nullptr) {
+            ArtWorker::release(result);
+        }
+        delay(1);
+    }
+    return nullptr;
+}
+
+void checkQuadrants(const ArtWorker::Result* result, bool gray, const char* label) {
+    const ArtImage& image = result->image;
+    for (int q = 0; q < 4; q++) {
+        uint16_t x = image.width / 4 + (q % 2) * (image.width / 2);
+        uint16_t y = image.height / 4 + (q / 2) * (image.height / 2);
+        uint16_t pixel = image.pixels[y * image.width + x];
+        int got[3] = {(pixel >> 11) << 3, ((pixel >> 5) & 0x3F) << 2, (pixel & 0x1F) << 3};
+        const uint8_t* want = JpegWriter::QUADRANTS[q];
+        for (int c = 0; c < 3; c++) {
+            int expected = gray ? JpegWriter::gray(want) : want[c];
+            char message[96];
+            snprintf(message, sizeof(message), "%s: quadrant %d channel %d is %d, expected %d", label, q, c, got[c],
+                     expected);
+            TEST_ASSERT_TRUE_MESSAGE(abs(got[c] - expected) <= MAX_CHANNEL_ERROR, message);
+        }
+    }
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_layouts_sizes_and_scales() {
+    struct Case {
+        const char* label;
+        JpegSpec spec;
+    };
+    const Case cases[] = {
+        {"4:4:4 600x600", {600, 600, false, false}},
+        {"4:2:0 600x600", {600, 600, false, true}},
+        {"gray 600x600", {600, 600, true, false}},
+        {"4:2:0 601x449, partial MCUs", {601, 449, false, true}},
+        {"4:4:4 333x97, partial blocks", {333, 97, false, false}},
+        {"4:2:0 200x80, full scale", {200, 80, false, true}},
+        {"4:2:0 1500x1500, 1/8 scale", {1500, 1500, false, true}},
+    };
+    int index = 0;
+    for (const Case& c : cases) {
+        uint16_t width, height;
+        ArtResampler::fitToBox(c.spec.width, c.spec.height, ArtWorker::BOX_WIDTH, ArtWorker::BOX_HEIGHT, width, height);
+        ArtWorker::Result* result = fetchArt("/layout" + std::to_string(index++) + ".jpg", JpegWriter::testCard(c.spec));
+        TEST_ASSERT_TRUE_MESSAGE(result != nullptr, c.label);
+        TEST_ASSERT_TRUE_MESSAGE(result->ok, c.label);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE("network", result->source, c.label);
+        TEST_ASSERT_EQUAL_MESSAGE(width, result->image.width, c.label);
+        TEST_ASSERT_EQUAL_MESSAGE(height, result->image.height, c.label);
+        checkQuadrants(result, c.spec.gray, c.label);
+        ArtWorker::release(result);
+    }
+}
+
+void test_progressive_jpeg_is_refused() {
+    // tjpgd only decodes baseline
+    JpegSpec spec = {300, 300, false, true, true};
+    ArtWorker::Result* result = fetchArt("/progressive.jpg", JpegWriter::testCard(spec));
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_FALSE(result->ok);
+    TEST_ASSERT_NULL(result->image.pixels);
+    ArtWorker::release(result);
+}
+
+void test_truncated_jpeg_fails() {
+    std::string jpeg = JpegWriter::testCard({400, 400, false, true});
+    ArtWorker::Result* result = fetchArt("/truncated.jpg", jpeg.substr(0, jpeg.size() / 2));
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_FALSE(result->ok);
+    ArtWorker::release(result);
+}
+
+void test_slow_download_previews_then_replays_the_spool() {
+    // tjpgd reads 512 bytes at a time, so a body of any other length ends in a short read, which
+    // must land in the spool like the rest for the full-quality pass to replay it
+    JpegSpec spec = {600, 600, false, true};
+    std::string jpeg = JpegWriter::testCard(spec);
+    if (jpeg.size() % 512 == 0) jpeg = JpegWriter::testCard({600, 600, false, true, false, 89});
+    TEST_ASSERT_NOT_EQUAL(0, jpeg.size() % 512);
+    stalls["/slow.jpg"] = jpeg.size() / 3;
+    ArtWorker::Result* preview = nullptr;
+    ArtWorker::Result* result = fetchArt("/slow.jpg", jpeg, &preview);
+    TEST_ASSERT_NOT_NULL(preview);
+    TEST_ASSERT_TRUE(preview->ok);
+    checkQuadrants(preview, false, "preview");
+    ArtWorker::release(preview);
+    TEST_ASSERT_NOT_NULL(result);
+    TEST_ASSERT_TRUE(result->ok);
+    TEST_ASSERT_FALSE(result->preview);
+    TEST_ASSERT_GREATER_OR_EQUAL(STALL_MS, result->finishedMs - result->requestedMs);
+    checkQuadrants(result, false, "full quality");
+    ArtWorker::release(result);
+}
+
+int main() {
+    port = server.listenOn(ART_HOST);
+    server.start([](const StandInServer::Request& request) {
+        auto file = files.find(request.path);
+        if (file == files.end()) return StandInServer::status(404, "Not Found");
+        StandInServer::Reply reply = StandInServer::ok(file->second, "image/jpeg", true);
+        auto stall = stalls.find(request.path);
+        if (stall != stalls.end()) {
+            reply.splitAt = reply.data.size() - file->second.size() + stall->second;
+            reply.splitMs = STALL_MS;
+        }
+        return reply;
+    });
+    LittleFS.begin(true);
+    LittleFS.format();
+    artCache = new ArtCache();
+    artCache->begin();
+    worker = new ArtWorker(*artCache);
+    worker->begin(0);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_layouts_sizes_and_scales);
+    RUN_TEST(test_progressive_jpeg_is_refused);
+    RUN_TEST(test_truncated_jpeg_fails);
+    RUN_TEST(test_slow_download_previews_then_replays_the_spool);
+    int failures = UNITY_END();
+    // The worker task never returns; leave without running destructors under it
+    fflush(stdout);
+    _exit(failures);
+}
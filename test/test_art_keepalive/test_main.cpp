@@ -0,0 +1,147 @@
+// Connection reuse for art hosts. The host shims have no TLS, so every TCP connection the
+// stand-in CDN accepts is a connection that would have cost a full TLS handshake on the device.
+#include <unity.h>
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "ArtCache.h"
+#include "ArtWorker.h"
+#include "ConnectionPool.h"
+#include <HTTPClient.h>
+#include "PngWriter.h"
+#include "StandInServer.h"
+
+namespace {
+
+const char* const CDN_HOST = "127.0.4.2";
+const int TRACKS = 6;
+
+StandInServer cdn;
+uint16_t port = 0;
+std::vector<std::string> covers;
+ArtCache* artCache = nullptr;
+ArtWorker* worker = nullptr;
+
+String coverUrl(int track) {
+    return String("https://") + CDN_HOST + ":" + String(port) + "/cover" + String(track) + ".png";
+}
+
+StandInServer::Reply serveCover(const StandInServer::Request& request) {
+    int track = -1;
+    if (sscanf(request.path.c_str(), "/cover%d.png", &track) != 1 || track < 0 || track >= TRACKS) {
+        return StandInServer::status(404, "Not Found");
+    }
+    return StandInServer::ok(covers[track], "image/png", request.headers.find("Connection: close") == std::string::npos);
+}
+
+ArtWorker::Result* waitForArt(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (millis() - start < timeoutMs) {
+        ArtWorker::Result* result = worker->takeResult();
+        if (result != nullptr) return result;
+        delay(1);
+    }
+    return nullptr;
+}
+
+}  // namespace
+
+void setUp() {
+    cdn.resetCounters();
+}
+
+void tearDown() {}
+
+void test_consecutive_tracks_share_one_connection() {
+    printf("\n%6s %10s %12s\n", "track", "art ms", "connections");
+    for (int track = 0; track < TRACKS; track++) {
+        worker->request(coverUrl(track), ArtWorker::Purpose::Display);
+        ArtWorker::Result* result = waitForArt(3000);
+        TEST_ASSERT_NOT_NULL(result);
+        TEST_ASSERT_TRUE(result->ok);
+        TEST_ASSERT_EQUAL_STRING("network", result->source);
+        printf("%6d %10lu %12u\n", track + 1, result->finishedMs - result->requestedMs, cdn.connections());
+        ArtWorker::release(result);
+        // Tracks change further apart than the skip debounce
+        delay(350);
+    }
+    TEST_ASSERT_EQUAL(TRACKS, cdn.requests());
+    TEST_ASSERT_EQUAL(1, cdn.connections());
+}
+
+void test_pool_counts_handshakes_and_reuses() {
+    ConnectionPool pool;
+    for (int track = 0; track < 3; track++) {
+        ConnectionPool::Connection* connection = pool.acquire(coverUrl(track));
+        TEST_ASSERT_NOT_NULL(connection);
+        HTTPClient& http = *connection->http;
+        http.setReuse(true);
+        TEST_ASSERT_TRUE(http.begin(*connection->client, coverUrl(track)));
+        TEST_ASSERT_EQUAL(200, http.GET());
+        String body = http.getString();
+        TEST_ASSERT_EQUAL(covers[track].size(), body.length());
+        http.end();
+        pool.release(connection, true);
+    }
+    TEST_ASSERT_EQUAL(1, pool.handshakes());
+    TEST_ASSERT_EQUAL(2, pool.reuses());
+    TEST_ASSERT_EQUAL(1, cdn.connections());
+
+    // A response that was not read to its end cannot carry the next request
+    ConnectionPool::Connection* connection = pool.acquire(coverUrl(0));
+    connection->http->setReuse(true);
+    connection->http->begin(*connection->client, coverUrl(0));
+    TEST_ASSERT_EQUAL(200, connection->http->GET());
+    pool.release(connection, false);
+    connection = pool.acquire(coverUrl(1));
+    TEST_ASSERT_FALSE(connection->client->connected());
+    TEST_ASSERT_EQUAL(2, pool.handshakes());
+}
+
+void test_throwaway_http_client_closes_the_connection() {
+    // Why the pool owns the HTTPClient: one that goes out of scope stops its client
+    ConnectionPool pool;
+    ConnectionPool::Connection* connection = pool.acquire(coverUrl(0));
+    {
+        HTTPClient http;
+        http.setReuse(true);
+        TEST_ASSERT_TRUE(http.begin(*connection->client, coverUrl(0)));
+        TEST_ASSERT_EQUAL(200, http.GET());
+        http.getString();
+        http.end();
+        TEST_ASSERT_TRUE(connection->client->connected());
+    }
+    TEST_ASSERT_FALSE(connection->client->connected());
+    pool.release(connection, true);
+}
+
+void test_pool_keys_by_origin() {
+    ConnectionPool pool;
+    ConnectionPool::Connection* a = pool.acquire("https://Art.Example.com/a.jpg");
+    ConnectionPool::Connection* b = pool.acquire("https://art.example.com:443/b.jpg");
+    ConnectionPool::Connection* c = pool.acquire("http://art.example.com/c.jpg");
+    TEST_ASSERT_TRUE(a == b);
+    TEST_ASSERT_TRUE(a != c);
+    TEST_ASSERT_NULL(pool.acquire("ftp://art.example.com/c.jpg"));
+}
+
+int main() {
+    for (int track = 0; track < TRACKS; track++) covers.push_back(PngWriter::testCard(300, 300, track));
+    port = cdn.listenOn(CDN_HOST);
+    cdn.start(serveCover);
+    LittleFS.begin(true);
+    LittleFS.format();
+    artCache = new ArtCache();
+    artCache->begin();
+    worker = new ArtWorker(*artCache);
+    worker->begin(0);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_consecutive_tracks_share_one_connection);
+    RUN_TEST(test_pool_counts_handshakes_and_reuses);
+    RUN_TEST(test_throwaway_http_client_closes_the_connection);
+    RUN_TEST(test_pool_keys_by_origin);
+    int failures = UNITY_END();
+    // The worker task never returns; leave without running destructors under it
+    fflush(stdout);
+    _exit(failures);
+}
@@ -0,0 +1,234 @@
+// ArtResampler: output geometry and row order, colour preservation, the 2:1 fast path against the
+// general area average, and the size limits of fitToBox, decodeScale and begin.
+#include <unity.h>
+#include <Arduino.h>
+#include <vector>
+#include "ArtResampler.h"
+
+namespace {
+
+struct Image {
+    uint16_t width = 0;
+    uint16_t height = 0;
+    std::vector<uint16_t> pixels;
+    std::vector<uint16_t> rowOrder;  // Destination rows in the order the sink saw them
+};
+
+uint32_t nextRandom(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+std::vector<uint16_t> randomImage(uint16_t w, uint16_t h, uint32_t seed) {
+    std::vector<uint16_t> pixels(w * h);
+    for (uint16_t& pixel : pixels) pixel = nextRandom(seed);
+    return pixels;
+}
+
+// Runs the resampler over a whole source image; an empty result means begin() refused the sizes
+Image resample(const std::vector<uint16_t>& src, uint16_t srcW, uint16_t srcH, uint16_t dstW, uint16_t dstH) {
+    Image out;
+    ArtResampler resampler;
+    bool started = resampler.begin(srcW, srcH, dstW, dstH, [&out](uint16_t row, const uint16_t* pixels) {
+        out.rowOrder.push_back(row);
+        memcpy(&out.pixels[row * out.width], pixels, out.width * sizeof(uint16_t));
+    });
+    if (!started) return out;
+    out.width = dstW;
+    out.height = dstH;
+    out.pixels.assign(dstW * dstH, 0);
+    for (uint16_t y = 0; y < srcH; y++) resampler.pushRow(&src[y * srcW]);
+    TEST_ASSERT_TRUE(resampler.finished());
+    return out;
+}
+
+// The general area average written out pixel by pixel: each destination pixel takes every source
+// pixel it overlaps, weighted by the overlap, with the resampler's 16.16 steps and 8.8 sums
+std::vector<uint16_t> areaAverage(const std::vector<uint16_t>& src, uint16_t srcW, uint16_t srcH, uint16_t dstW,
+                                  uint16_t dstH) {
+    uint32_t stepX = ((uint32_t)srcW << 16) / dstW;
+    uint32_t stepY = ((uint32_t)srcH << 16) / dstH;
+    std::vector<uint16_t> out(dstW * dstH);
+    for (uint16_t dy = 0; dy < dstH; dy++) {
+        uint32_t top = dy * stepY, bottom = (dy + 1) * stepY;
+        for (uint16_t dx = 0; dx < dstW; dx++) {
+            uint32_t left = dx * stepX, right = left + stepX;
+            uint32_t columns[3] = {0, 0, 0};
+            uint32_t columnWeight = 0;
+            for (uint32_t sy = top >> 16; sy < srcH && (sy << 16) < bottom; sy++) {
+                uint32_t rowWeight = (min(bottom, (sy + 1) << 16) >> 8) - (max(top, sy << 16) >> 8);
+                uint32_t sums[3] = {0, 0, 0};
+                for (uint32_t sx = left >> 16; sx <= min<uint32_t>((right - 1) >> 16, srcW - 1); sx++) {
+                    uint32_t weight = min(right, (sx + 1) << 16) - max(left, sx << 16);
+                    uint16_t pixel = src[sy * srcW + sx];
+                    sums[0] += (pixel >> 11) * weight;
+                    sums[1] += ((pixel >> 5) & 0x3F) * weight;
+                    sums[2] += (pixel & 0x1F) * weight;
+                }
+                for (int c = 0; c < 3; c++) columns[c] += (uint16_t)(sums[c] / (stepX >> 8)) * rowWeight;
+                columnWeight += rowWeight;
+            }
+            uint32_t half = columnWeight * 128;
+            uint32_t r = min<uint32_t>((columns[0] + half) / columnWeight >> 8, 0x1F);
+            uint32_t g = min<uint32_t>((columns[1] + half) / columnWeight >> 8, 0x3F);
+            uint32_t b = min<uint32_t>((columns[2] + half) / columnWeight >> 8, 0x1F);
+            out[dy * dstW + dx] = (r << 11) | (g << 5) | b;
+        }
+    }
+    return out;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_output_size_and_row_order() {
+    const uint16_t sizes[][4] = {{600, 600, 94, 94}, {640, 480, 240, 180}, {1000, 1, 240, 1}, {300, 300, 150, 150},
+                                 {97, 53, 31, 17}, {94, 94, 94, 94}};
+    for (const auto& size : sizes) {
+        Image out = resample(randomImage(size[0], size[1], 1), size[0], size[1], size[2], size[3]);
+        TEST_ASSERT_EQUAL(size[2], out.width);
+        TEST_ASSERT_EQUAL(size[3], out.height);
+        TEST_ASSERT_EQUAL(size[3], out.rowOrder.size());
+        for (uint16_t row = 0; row < out.rowOrder.size(); row++) TEST_ASSERT_EQUAL(row, out.rowOrder[row]);
+    }
+}
+
+void test_solid_colours_are_preserved() {
+    const uint16_t colours[] = {0x0000, 0xFFFF, 0xF800, 0x07E0, 0x001F, 0x7BEF, 0x8410, 0xF81F};
+    const uint16_t sizes[][4] = {{600, 600, 94, 94}, {200, 100, 100, 50}, {301, 97, 240, 77}, {5, 5, 2, 2}};
+    for (uint16_t colour : colours) {
+        for (const auto& size : sizes) {
+            std::vector<uint16_t> src(size[0] * size[1], colour);
+            Image out = resample(src, size[0], size[1], size[2], size[3]);
+            for (uint16_t pixel : out.pixels) TEST_ASSERT_EQUAL_HEX16(colour, pixel);
+        }
+    }
+}
+
+void test_general_path_matches_area_average() {
+    const uint16_t sizes[][4] = {{600, 600, 94, 94}, {640, 480, 240, 180}, {300, 300, 100, 100},
+                                 {97, 53, 31, 17}, {10, 7, 3, 7}, {1000, 1, 240, 1}};
+    for (const auto& size : sizes) {
+        std::vector<uint16_t> src = randomImage(size[0], size[1], size[0] + size[2]);
+        Image out = resample(src, size[0], size[1], size[2], size[3]);
+        std::vector<uint16_t> expected = areaAverage(src, size[0], size[1], size[2], size[3]);
+        TEST_ASSERT_EQUAL_HEX16_ARRAY(expected.data(), out.pixels.data(), expected.size());
+    }
+}
+
+void test_halving_is_bit_identical_to_area_average() {
+    const uint16_t sizes[][2] = {{188, 188}, {480, 188}, {2, 2}, {6, 4}, {250, 2}};
+    for (const auto& size : sizes) {
+        for (uint32_t seed = 1; seed <= 4; seed++) {
+            std::vector<uint16_t> src = randomImage(size[0], size[1], seed);
+            Image out = resample(src, size[0], size[1], size[0] / 2, size[1] / 2);
+            std::vector<uint16_t> expected = areaAverage(src, size[0], size[1], size[0] / 2, size[1] / 2);
+            TEST_ASSERT_EQUAL_HEX16_ARRAY(expected.data(), out.pixels.data(), expected.size());
+        }
+    }
+    // Channel extremes, where a carry between channels would show
+    std::vector<uint16_t> src = {0xFFFF, 0xFFFF, 0xFFFF, 0xFFFE, 0x0000, 0x0001, 0x07E0, 0xF81F};
+    Image out = resample(src, 4, 2, 2, 1);
+    std::vector<uint16_t> expected = areaAverage(src, 4, 2, 2, 1);
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected.data(), out.pixels.data(), expected.size());
+}
+
+void test_fit_to_box_edges() {
+    uint16_t w, h;
+    ArtResampler::fitToBox(600, 600, 240, 94, w, h);
+    TEST_ASSERT_EQUAL(94, w);
+    TEST_ASSERT_EQUAL(94, h);
+    ArtResampler::fitToBox(640, 480, 240, 94, w, h);
+    TEST_ASSERT_EQUAL(125, w);
+    TEST_ASSERT_EQUAL(94, h);
+    // A 1-px-high strip keeps at least one row
+    ArtResampler::fitToBox(600, 1, 240, 94, w, h);
+    TEST_ASSERT_EQUAL(240, w);
+    TEST_ASSERT_EQUAL(1, h);
+    ArtResampler::fitToBox(4000, 1, 240, 94, w, h);
+    TEST_ASSERT_EQUAL(240, w);
+    TEST_ASSERT_EQUAL(1, h);
+    ArtResampler::fitToBox(1, 4000, 240, 94, w, h);
+    TEST_ASSERT_EQUAL(1, w);
+    TEST_ASSERT_EQUAL(94, h);
+    // Smaller than the box scales up to fill it
+    ArtResampler::fitToBox(50, 50, 240, 94, w, h);
+    TEST_ASSERT_EQUAL(94, w);
+    TEST_ASSERT_EQUAL(94, h);
+}
+
+void test_decode_scale_edges() {
+    TEST_ASSERT_EQUAL(2, ArtResampler::decodeScale(600, 600, 94, 94));
+    TEST_ASSERT_EQUAL(3, ArtResampler::decodeScale(4000, 4000, 94, 94));
+    TEST_ASSERT_EQUAL(1, ArtResampler::decodeScale(4000, 4000, 94, 94, 1));
+    TEST_ASSERT_EQUAL(0, ArtResampler::decodeScale(188, 187, 94, 94));
+    TEST_ASSERT_EQUAL(1, ArtResampler::decodeScale(188, 188, 94, 94));
+    // A 1-px-high source can never be reduced
+    TEST_ASSERT_EQUAL(0, ArtResampler::decodeScale(2000, 1, 240, 1));
+    TEST_ASSERT_EQUAL(0, ArtResampler::decodeScale(50, 50, 94, 94));
+}
+
+void test_begin_rejects_out_of_range_steps() {
+    ArtResampler resampler;
+    auto sink = [](uint16_t, const uint16_t*) {};
+    TEST_ASSERT_FALSE(resampler.begin(0, 10, 5, 5, sink));
+    TEST_ASSERT_FALSE(resampler.begin(10, 10, 0, 5, sink));
+    // MAX_STEP is a 64:1 reduction per axis
+    TEST_ASSERT_TRUE(resampler.begin(64, 1, 1, 1, sink));
+    TEST_ASSERT_FALSE(resampler.begin(65, 1, 1, 1, sink));
+    TEST_ASSERT_TRUE(resampler.begin(1, 64, 1, 1, sink));
+    TEST_ASSERT_FALSE(resampler.begin(1, 65, 1, 1, sink));
+    TEST_ASSERT_FALSE(resampler.begin(4000, 1, 1, 1, sink));
+    // Steps below 1/256 of a pixel are refused too
+    TEST_ASSERT_TRUE(resampler.begin(1, 1, 256, 256, sink));
+    TEST_ASSERT_FALSE(resampler.begin(1, 1, 257, 1, sink));
+    TEST_ASSERT_FALSE(resampler.begin(1, 1, 1, 257, sink));
+}
+
+void test_extreme_steps_resample() {
+    // At MAX_STEP every source pixel goes into one, without the accumulators overflowing
+    std::vector<uint16_t> white(64 * 64, 0xFFFF);
+    Image out = resample(white, 64, 64, 1, 1);
+    TEST_ASSERT_EQUAL(1, out.pixels.size());
+    TEST_ASSERT_EQUAL_HEX16(0xFFFF, out.pixels[0]);
+
+    std::vector<uint16_t> src = randomImage(64, 64, 9);
+    out = resample(src, 64, 64, 1, 1);
+    TEST_ASSERT_EQUAL_HEX16(areaAverage(src, 64, 64, 1, 1)[0], out.pixels[0]);
+
+    // A 1-px-high source still produces its one row
+    src = randomImage(1000, 1, 3);
+    out = resample(src, 1000, 1, 240, 1);
+    TEST_ASSERT_EQUAL(1, out.rowOrder.size());
+
+    // Upscaling repeats source pixels
+    std::vector<uint16_t> one = {0x1234};
+    out = resample(one, 1, 1, 4, 3);
+    for (uint16_t pixel : out.pixels) TEST_ASSERT_EQUAL_HEX16(0x1234, pixel);
+}
+
+void test_rows_after_the_last_are_ignored() {
+    int rows = 0;
+    ArtResampler resampler;
+    TEST_ASSERT_TRUE(resampler.begin(4, 4, 2, 2, [&rows](uint16_t, const uint16_t*) { rows++; }));
+    std::vector<uint16_t> row(4, 0xFFFF);
+    for (int i = 0; i < 8; i++) resampler.pushRow(row.data());
+    TEST_ASSERT_EQUAL(2, rows);
+    TEST_ASSERT_TRUE(resampler.finished());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_output_size_and_row_order);
+    RUN_TEST(test_solid_colours_are_preserved);
+    RUN_TEST(test_general_path_matches_area_average);
+    RUN_TEST(test_halving_is_bit_identical_to_area_average);
+    RUN_TEST(test_fit_to_box_edges);
+    RUN_TEST(test_decode_scale_edges);
+    RUN_TEST(test_begin_rejects_out_of_range_steps);
+    RUN_TEST(test_extreme_steps_resample);
+    RUN_TEST(test_rows_after_the_last_are_ignored);
+    return UNITY_END();
+}
@@ -0,0 +1,164 @@
+// Device cache: load time of the binary cache against the JSON file it replaced, the one-time
+// migration between them, and how many flash writes repeated scans cost.
+#include <unity.h>
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include "DeviceCache.h"
+
+namespace {
+
+const size_t SITE_SIZES[] = {10, 60, 200, 500};
+const int LOAD_ROUNDS = 20;
+const int SCANS = 50;
+
+std::vector<SonosDevice> makeDevices(size_t count) {
+    std::vector<SonosDevice> devices(count);
+    for (size_t i = 0; i < count; i++) {
+        char text[48];
+        snprintf(text, sizeof(text), "Living Room %zu", i + 1);
+        devices[i].name = text;
+        snprintf(text, sizeof(text), "192.168.%zu.%zu", 1 + i / 250, 1 + i % 250);
+        devices[i].ip = text;
+        snprintf(text, sizeof(text), "RINCON_%012zX01400", i + 1);
+        devices[i].uuid = text;
+    }
+    return devices;
+}
+
+// The cache format before the binary one; returns the file size
+size_t writeLegacyJson(const std::vector<SonosDevice>& devices) {
+    String json = "[";
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (i > 0) json += ",";
+        json += "{\"name\":\"" + devices[i].name + "\",\"ip\":\"" + devices[i].ip + "\",\"uuid\":\"" + devices[i].uuid + "\"}";
+    }
+    json += "]";
+    File file = LittleFS.open("/sonos_devices.json", "w");
+    file.write(reinterpret_cast<const uint8_t*>(json.c_str()), json.length());
+    file.close();
+    return json.length();
+}
+
+// The JSON loader the binary cache replaced
+std::vector<CachedDevice> loadLegacyJson() {
+    std::vector<CachedDevice> devices;
+    File file = LittleFS.open("/sonos_devices.json", "r");
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, file);
+    file.close();
+    if (error) return devices;
+    for (JsonObject obj : doc.as<JsonArray>()) {
+        devices.push_back(CachedDevice(obj["name"].as<String>(), obj["ip"].as<String>(), obj["uuid"].as<String>()));
+    }
+    return devices;
+}
+
+void assertSameDevices(const std::vector<SonosDevice>& expected, const std::vector<CachedDevice>& actual) {
+    TEST_ASSERT_EQUAL(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        TEST_ASSERT_EQUAL_STRING(expected[i].name.c_str(), actual[i].name.c_str());
+        TEST_ASSERT_EQUAL_STRING(expected[i].ip.c_str(), actual[i].ip.c_str());
+        TEST_ASSERT_EQUAL_STRING(expected[i].uuid.c_str(), actual[i].uuid.c_str());
+    }
+}
+
+}  // namespace
+
+void setUp() {
+    LittleFS.begin(true);
+    LittleFS.format();
+    HostFs::resetCounters();
+}
+
+void tearDown() {}
+
+void test_legacy_json_migrates_once() {
+    std::vector<SonosDevice> devices = makeDevices(12);
+    writeLegacyJson(devices);
+    DeviceCache cache;
+    cache.begin();
+    assertSameDevices(devices, cache.loadDevices());
+    TEST_ASSERT_FALSE(LittleFS.exists("/sonos_devices.json"));
+    TEST_ASSERT_TRUE(LittleFS.exists("/sonos_devices.bin"));
+
+    DeviceCache reloaded;
+    reloaded.begin();
+    assertSameDevices(devices, reloaded.loadDevices());
+}
+
+void test_corrupt_cache_is_ignored() {
+    std::vector<SonosDevice> devices = makeDevices(5);
+    DeviceCache cache;
+    cache.begin();
+    TEST_ASSERT_TRUE(cache.saveDevices(devices));
+
+    File file = LittleFS.open("/sonos_devices.bin", "r+");
+    file.seek(40);
+    file.write('X');
+    file.close();
+    DeviceCache reloaded;
+    reloaded.begin();
+    TEST_ASSERT_EQUAL(0, reloaded.loadDevices().size());
+}
+
+void test_load_time_binary_vs_json() {
+    printf("\n%8s %10s %10s %12s %12s\n", "devices", "json bytes", "bin bytes", "json us/load", "bin us/load");
+    for (size_t count : SITE_SIZES) {
+        LittleFS.format();
+        std::vector<SonosDevice> devices = makeDevices(count);
+        size_t jsonBytes = writeLegacyJson(devices);
+
+        unsigned long start = micros();
+        for (int i = 0; i < LOAD_ROUNDS; i++) assertSameDevices(devices, loadLegacyJson());
+        unsigned long jsonUs = (micros() - start) / LOAD_ROUNDS;
+
+        DeviceCache cache;
+        cache.begin();
+        TEST_ASSERT_TRUE(cache.saveDevices(devices));
+        File file = LittleFS.open("/sonos_devices.bin", "r");
+        size_t binBytes = file.size();
+        file.close();
+        start = micros();
+        for (int i = 0; i < LOAD_ROUNDS; i++) assertSameDevices(devices, cache.loadDevices());
+        unsigned long binUs = (micros() - start) / LOAD_ROUNDS;
+
+        printf("%8zu %10zu %10zu %12lu %12lu\n", count, jsonBytes, binBytes, jsonUs, binUs);
+    }
+}
+
+void test_repeated_scans_write_flash_once() {
+    std::vector<SonosDevice> devices = makeDevices(60);
+    DeviceCache cache;
+    cache.begin();
+
+    // Every scan re-saves the list; only real changes may reach flash
+    for (int scan = 0; scan < SCANS; scan++) TEST_ASSERT_TRUE(cache.saveDevices(devices));
+    TEST_ASSERT_EQUAL(1, HostFs::filesWritten);
+    TEST_ASSERT_EQUAL(1, HostFs::renames);
+    uint32_t unchangedFiles = HostFs::filesWritten;
+    uint64_t unchangedBytes = HostFs::bytesWritten;
+
+    devices[7].ip = "192.168.1.250";
+    TEST_ASSERT_TRUE(cache.saveDevices(devices));
+    TEST_ASSERT_EQUAL(2, HostFs::filesWritten);
+
+    // A fresh boot starts from the file on flash and still skips the unchanged save
+    DeviceCache rebooted;
+    rebooted.begin();
+    rebooted.loadDevices();
+    TEST_ASSERT_TRUE(rebooted.saveDevices(devices));
+    TEST_ASSERT_EQUAL(2, HostFs::filesWritten);
+
+    printf("\n%d scans of 60 unchanged devices: %u file writes, %llu bytes (a write per scan would be %d files)\n",
+           SCANS, unchangedFiles, (unsigned long long)unchangedBytes, SCANS);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_legacy_json_migrates_once);
+    RUN_TEST(test_corrupt_cache_is_ignored);
+    RUN_TEST(test_load_time_binary_vs_json);
+    RUN_TEST(test_repeated_scans_write_flash_once);
+    return UNITY_END();
+}
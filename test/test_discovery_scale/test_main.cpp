@@ -0,0 +1,105 @@
+// Discovery at sites with many speakers. N stand-in speakers on 127.0.x.y answer M-SEARCH and
+// serve descriptions; DiscoveryManager runs a scan from an empty cache as it does at first boot.
+// Reports time to the full list, SSDP responses that never got read, heap peak and list refreshes.
+// Set DISCOVERY_SCALE_MAX to stop at a smaller site.
+#include <unity.h>
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Sonos.h>
+#include "DeviceCache.h"
+#include "DiscoveryManager.h"
+#include "StandInSpeakers.h"
+
+namespace {
+
+const size_t SITE_SIZES[] = {10, 60, 200, 500};
+// lwIP keeps only a few datagrams per UDP socket; a small host buffer makes overruns show up the same way
+const int UDP_RECEIVE_BUFFER = 16 * 1024;
+
+struct ScaleRun {
+    unsigned long fullListMs = 0;  // 0 if the list never filled
+    size_t listed = 0;
+    int refreshes = 0;
+    uint32_t responsesSent = 0;
+    uint32_t heapPeak = 0;
+    SonosDiscoveryStats stats;
+};
+
+ScaleRun discover(size_t count) {
+    ScaleRun run;
+    StandInSpeakers speakers;
+    // Speakers spread their answers over MX (1 s), which is what makes the socket queue fill
+    TEST_ASSERT_TRUE(speakers.start(count, 1000));
+
+    LittleFS.format();
+    DeviceCache cache;
+    cache.begin();
+    SonosConfig config;
+    config.discoveryPort = 0;
+    config.enablePresenceListener = false;
+    Sonos sonos(config);
+    DiscoveryManager manager(sonos, cache);
+    unsigned long start = 0;
+    manager.setDiscoveryCallback([&](const std::vector<SonosDevice>& devices) {
+        run.refreshes++;
+        run.listed = devices.size();
+        if (run.fullListMs == 0 && devices.size() == count) run.fullListMs = millis() - start;
+    });
+    TEST_ASSERT_TRUE(sonos.begin() == SonosResult::SUCCESS);
+    manager.begin();
+
+    uint32_t freeAtStart = ESP.getFreeHeap();
+    start = millis();
+    manager.update();
+    TEST_ASSERT_TRUE(sonos.isDiscovering());
+    while (sonos.isDiscovering() && millis() - start < 20000) {
+        manager.update();
+        delay(1);
+    }
+    run.stats = sonos.getLastDiscoveryStats();
+    run.responsesSent = speakers.datagramsSent();
+    run.heapPeak = freeAtStart > run.stats.minFreeHeap ? freeAtStart - run.stats.minFreeHeap : 0;
+    sonos.end();
+    speakers.stop();
+    return run;
+}
+
+}  // namespace
+
+void setUp() {
+    HostNet::udpReceiveBuffer = UDP_RECEIVE_BUFFER;
+}
+
+void tearDown() {
+    HostNet::udpReceiveBuffer = 0;
+}
+
+void test_discovery_scale() {
+    const char* maxEnv = getenv("DISCOVERY_SCALE_MAX");
+    size_t maxCount = maxEnv != nullptr ? strtoul(maxEnv, nullptr, 10) : SIZE_MAX;
+    LittleFS.begin(true);
+
+    printf("\n%8s %12s %8s %10s %8s %12s %10s %10s\n", "speakers", "full list ms", "listed", "responses", "dropped",
+           "drain limit", "heap peak", "refreshes");
+    for (size_t count : SITE_SIZES) {
+        if (count > maxCount) break;
+        ScaleRun run = discover(count);
+        // Every answer either got read or was lost in the socket queue
+        uint32_t dropped = run.responsesSent > run.stats.packets ? run.responsesSent - run.stats.packets : 0;
+        printf("%8zu %12lu %8zu %10u %8u %12u %10u %10d\n", count, run.fullListMs, run.listed, run.responsesSent, dropped,
+               run.stats.drainLimitHits, run.heapPeak, run.refreshes);
+        fflush(stdout);
+
+        TEST_ASSERT_EQUAL(count, run.listed);
+        TEST_ASSERT_NOT_EQUAL(0, run.fullListMs);
+        TEST_ASSERT_EQUAL(0, run.stats.packetsTruncated);
+        // Refreshes are coalesced; a site this size must not redraw the list per speaker
+        TEST_ASSERT_LESS_OR_EQUAL(count / 4 + 8, run.refreshes);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_discovery_scale);
+    return UNITY_END();
+}
@@ -0,0 +1,104 @@
+// SonosParallelHttp response parsing against a loopback server that can split a reply across reads.
+#include <unity.h>
+#include <Arduino.h>
+#include <SonosParallelHttp.h>
+#include "StandInServer.h"
+
+namespace {
+
+StandInServer* server = nullptr;
+uint16_t port = 0;
+StandInServer::Reply nextReply;
+
+void serve(const StandInServer::Reply& reply) {
+    nextReply = reply;
+    server = new StandInServer();
+    port = server->listenOn("127.0.0.1");
+    TEST_ASSERT_NOT_EQUAL(0, port);
+    server->start([](const StandInServer::Request&) { return nextReply; });
+}
+
+SonosParallelHttp::Request get(std::string* body) {
+    SonosParallelHttp::Request request;
+    request.ip = IPAddress(127, 0, 0, 1);
+    request.port = port;
+    request.request = SonosParallelHttp::buildGet(request.ip, port, "/xml/device_description.xml");
+    if (body != nullptr) {
+        request.onBody = [body](const char* data, size_t len) {
+            body->append(data, len);
+            return true;
+        };
+    }
+    return request;
+}
+
+const char* OK_HELLO = "HTTP/1.1 200 OK\r\nContent-Length: 5\r\nConnection: close\r\n\r\nhello";
+
+}  // namespace
+
+void setUp() {}
+
+void tearDown() {
+    delete server;
+    server = nullptr;
+}
+
+void test_status_line_split_across_reads() {
+    StandInServer::Reply reply;
+    reply.data = OK_HELLO;
+    reply.splitAt = 10;  // "HTTP/1.1 2" | "00 OK..."
+    serve(reply);
+
+    std::string body;
+    std::vector<SonosParallelHttp::Request> requests{get(&body)};
+    TEST_ASSERT_EQUAL(1, SonosParallelHttp::run(requests, 2000, 2000));
+    TEST_ASSERT_EQUAL(200, requests[0].statusCode);
+    TEST_ASSERT_EQUAL(5, requests[0].contentLength);
+    TEST_ASSERT_EQUAL_STRING("hello", body.c_str());
+}
+
+void test_header_terminator_split_across_reads() {
+    StandInServer::Reply reply;
+    reply.data = OK_HELLO;
+    reply.splitAt = strlen(OK_HELLO) - 7;  // Between the two CRLFs that end the headers
+    serve(reply);
+
+    std::string body;
+    std::vector<SonosParallelHttp::Request> requests{get(&body)};
+    TEST_ASSERT_EQUAL(1, SonosParallelHttp::run(requests, 2000, 2000));
+    TEST_ASSERT_EQUAL_STRING("hello", body.c_str());
+}
+
+void test_error_body_not_passed_to_on_body() {
+    StandInServer::Reply reply;
+    reply.data = "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\nConnection: close\r\n\r\nnot found";
+    serve(reply);
+
+    std::string body;
+    std::vector<SonosParallelHttp::Request> requests{get(&body)};
+    SonosParallelHttp::run(requests, 2000, 2000);
+    TEST_ASSERT_EQUAL(404, requests[0].statusCode);
+    TEST_ASSERT_TRUE(requests[0].complete);
+    TEST_ASSERT_TRUE(body.empty());
+}
+
+void test_status_check_waits_for_whole_status_line() {
+    StandInServer::Reply reply;
+    reply.data = OK_HELLO;
+    reply.splitAt = 5;
+    serve(reply);
+
+    std::vector<SonosParallelHttp::Request> requests{get(nullptr)};
+    requests[0].maxResponseBytes = 4;  // Reached by the first read, before the code
+    TEST_ASSERT_EQUAL(1, SonosParallelHttp::run(requests, 2000, 2000));
+    TEST_ASSERT_EQUAL(200, requests[0].statusCode);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_status_line_split_across_reads);
+    RUN_TEST(test_header_terminator_split_across_reads);
+    RUN_TEST(test_error_body_not_passed_to_on_body);
+    RUN_TEST(test_status_check_waits_for_whole_status_line);
+    return UNITY_END();
+}
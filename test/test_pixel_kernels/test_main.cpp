@@ -0,0 +1,175 @@
+// PixelKernels: the SWAR versions must match the scalar ones bit for bit, on every input a
+// channel can hold and at every tail length, and never write past the end of the output. The
+// timings at the end are for comparison only; the host compiler may vectorise the scalar loops.
+#include <unity.h>
+#include <Arduino.h>
+#include <vector>
+#include "PixelKernels.h"
+
+namespace {
+
+const uint16_t GUARD = 0xA5A5;
+const size_t ROW_PIXELS = 240;  // One art box row
+const int TIMING_ROUNDS = 20000;
+
+uint32_t nextRandom(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+std::vector<uint8_t> randomBytes(size_t count, uint32_t seed) {
+    std::vector<uint8_t> bytes(count);
+    for (uint8_t& byte : bytes) byte = nextRandom(seed);
+    return bytes;
+}
+
+std::vector<uint16_t> randomPixels(size_t count, uint32_t seed) {
+    std::vector<uint16_t> pixels(count);
+    for (uint16_t& pixel : pixels) pixel = nextRandom(seed);
+    return pixels;
+}
+
+// Compares both pack kernels on count pixels starting at a byte offset, with guards past the end
+void checkPack(const uint8_t* rgb, size_t count, size_t outOffset) {
+    std::vector<uint16_t> scalar(count + outOffset + 2, GUARD), swar(count + outOffset + 2, GUARD);
+    packRgb565Scalar(rgb, &scalar[outOffset], count);
+    packRgb565Swar(rgb, &swar[outOffset], count);
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(scalar.data(), swar.data(), scalar.size());
+    TEST_ASSERT_EQUAL_HEX16(GUARD, swar[count + outOffset]);
+    TEST_ASSERT_EQUAL_HEX16(GUARD, swar[count + outOffset + 1]);
+}
+
+void checkHalve(const uint16_t* row0, const uint16_t* row1, size_t outCount) {
+    std::vector<uint16_t> scalar(outCount + 2, GUARD), swar(outCount + 2, GUARD);
+    halveRgb565Scalar(row0, row1, scalar.data(), outCount);
+    halveRgb565Swar(row0, row1, swar.data(), outCount);
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(scalar.data(), swar.data(), scalar.size());
+    TEST_ASSERT_EQUAL_HEX16(GUARD, swar[outCount]);
+}
+
+template <typename Kernel>
+double nanosPerPixel(Kernel kernel) {
+    unsigned long start = micros();
+    for (int i = 0; i < TIMING_ROUNDS; i++) kernel();
+    return (micros() - start) * 1000.0 / ((double)TIMING_ROUNDS * ROW_PIXELS);
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_pack_matches_scalar_for_every_colour() {
+    // All 2^24 RGB triplets, a block at a time
+    const size_t BLOCK = 4096;
+    std::vector<uint8_t> rgb(BLOCK * 3);
+    for (uint32_t first = 0; first < (1u << 24); first += BLOCK) {
+        for (size_t i = 0; i < BLOCK; i++) {
+            uint32_t colour = first + i;
+            rgb[i * 3] = colour >> 16;
+            rgb[i * 3 + 1] = colour >> 8;
+            rgb[i * 3 + 2] = colour;
+        }
+        checkPack(rgb.data(), BLOCK, 0);
+    }
+}
+
+void test_pack_matches_scalar_at_every_tail() {
+    std::vector<uint8_t> rgb = randomBytes(3 * 64 + 3, 1);
+    for (size_t count = 0; count <= 64; count++) {
+        // Unaligned input and output as well, since rows come out of the inflate window at any offset
+        for (size_t inOffset = 0; inOffset < 3; inOffset++) {
+            for (size_t outOffset = 0; outOffset < 2; outOffset++) checkPack(&rgb[inOffset], count, outOffset);
+        }
+    }
+}
+
+void test_pack_matches_scalar_on_random_rows() {
+    for (uint32_t seed = 1; seed <= 200; seed++) {
+        uint32_t state = seed;
+        size_t count = nextRandom(state) % 1000;
+        std::vector<uint8_t> rgb = randomBytes(count * 3, seed);
+        checkPack(rgb.data(), count, 0);
+    }
+}
+
+void test_halve_matches_scalar_for_every_channel_quad() {
+    // Every combination of four values in one channel, with the others held at zero and at full
+    // scale, where a carry out of one channel into the next would show
+    struct Channel {
+        int shift;
+        uint16_t levels;
+    };
+    const Channel channels[] = {{11, 32}, {5, 64}, {0, 32}};
+    for (const Channel& channel : channels) {
+        uint16_t mask = (channel.levels - 1) << channel.shift;
+        for (uint16_t others : {(uint16_t)0x0000, (uint16_t)0xFFFF}) {
+            uint16_t rest = others & ~mask;
+            uint32_t combos = (uint32_t)channel.levels * channel.levels * channel.levels * channel.levels;
+            const uint32_t BLOCK = 4096;
+            std::vector<uint16_t> row0(BLOCK * 2), row1(BLOCK * 2);
+            for (uint32_t first = 0; first < combos; first += BLOCK) {
+                for (uint32_t i = 0; i < BLOCK; i++) {
+                    uint32_t v = first + i;
+                    uint16_t quad[4];
+                    for (uint16_t& value : quad) {
+                        value = rest | ((v % channel.levels) << channel.shift);
+                        v /= channel.levels;
+                    }
+                    row0[i * 2] = quad[0];
+                    row0[i * 2 + 1] = quad[1];
+                    row1[i * 2] = quad[2];
+                    row1[i * 2 + 1] = quad[3];
+                }
+                checkHalve(row0.data(), row1.data(), BLOCK);
+            }
+        }
+    }
+}
+
+void test_halve_matches_scalar_at_every_tail() {
+    std::vector<uint16_t> row0 = randomPixels(2 * 64 + 1, 2), row1 = randomPixels(2 * 64 + 1, 3);
+    for (size_t outCount = 0; outCount <= 64; outCount++) {
+        checkHalve(row0.data(), row1.data(), outCount);
+        // Odd source offsets put the word loads on 2-byte boundaries
+        checkHalve(&row0[1], &row1[1], outCount);
+    }
+}
+
+void test_halve_matches_scalar_on_random_rows() {
+    for (uint32_t seed = 1; seed <= 200; seed++) {
+        uint32_t state = seed;
+        size_t outCount = nextRandom(state) % 1000;
+        std::vector<uint16_t> row0 = randomPixels(outCount * 2, seed), row1 = randomPixels(outCount * 2, seed + 7);
+        checkHalve(row0.data(), row1.data(), outCount);
+    }
+}
+
+void test_kernel_timings() {
+    std::vector<uint8_t> rgb = randomBytes(ROW_PIXELS * 3, 4);
+    std::vector<uint16_t> row0 = randomPixels(ROW_PIXELS * 2, 5), row1 = randomPixels(ROW_PIXELS * 2, 6);
+    std::vector<uint16_t> out(ROW_PIXELS);
+    volatile uint16_t sink = 0;
+
+    double packScalar = nanosPerPixel([&] { packRgb565Scalar(rgb.data(), out.data(), ROW_PIXELS); sink = sink + out[7]; });
+    double packSwar = nanosPerPixel([&] { packRgb565Swar(rgb.data(), out.data(), ROW_PIXELS); sink = sink + out[7]; });
+    double halveScalar = nanosPerPixel([&] { halveRgb565Scalar(row0.data(), row1.data(), out.data(), ROW_PIXELS); sink = sink + out[7]; });
+    double halveSwar = nanosPerPixel([&] { halveRgb565Swar(row0.data(), row1.data(), out.data(), ROW_PIXELS); sink = sink + out[7]; });
+
+    printf("\n%-8s %12s %12s\n", "kernel", "scalar ns/px", "SWAR ns/px");
+    printf("%-8s %12.2f %12.2f\n", "pack", packScalar, packSwar);
+    printf("%-8s %12.2f %12.2f\n", "halve", halveScalar, halveSwar);
+    TEST_ASSERT_TRUE(packScalar > 0 && packSwar > 0 && halveScalar > 0 && halveSwar > 0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pack_matches_scalar_for_every_colour);
+    RUN_TEST(test_pack_matches_scalar_at_every_tail);
+    RUN_TEST(test_pack_matches_scalar_on_random_rows);
+    RUN_TEST(test_halve_matches_scalar_for_every_channel_quad);
+    RUN_TEST(test_halve_matches_scalar_at_every_tail);
+    RUN_TEST(test_halve_matches_scalar_on_random_rows);
+    RUN_TEST(test_kernel_timings);
+    return UNITY_END();
+}
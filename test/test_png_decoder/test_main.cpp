@@ -0,0 +1,339 @@
+// PngDecoder against PNGs built on the host: every colour type and bit depth it accepts, all
+// five scanline filters, IDAT split across chunks and across input reads, and damaged or
+// unsupported files. Inflation is miniz's tinfl writing through the decoder's 32 KB window, as in ROM.
+#include <unity.h>
+#include <Arduino.h>
+#include <string>
+#include <vector>
+#include "PngDecoder.h"
+#include "PngWriter.h"
+
+namespace {
+
+struct Decoded {
+    bool ok = false;
+    std::string error;
+    uint16_t width = 0;
+    uint16_t height = 0;
+    std::vector<uint16_t> pixels;
+    uint16_t rows = 0;
+    std::vector<size_t> reads;  // Sizes the decoder asked for, in order
+};
+
+Decoded decode(const std::string& png) {
+    Decoded out;
+    size_t pos = 0;
+    PngDecoder decoder([&](uint8_t* dest, size_t len) {
+        out.reads.push_back(len);
+        size_t n = std::min(len, png.size() - pos);
+        if (dest != nullptr) memcpy(dest, png.data() + pos, n);
+        pos += n;
+        return n;
+    });
+    out.ok = decoder.decode(
+        [&out](uint16_t w, uint16_t h) {
+            out.width = w;
+            out.height = h;
+            out.pixels.assign((size_t)w * h, 0);
+            return true;
+        },
+        [&out](uint16_t row, const uint16_t* pixels) {
+            TEST_ASSERT_EQUAL(out.rows, row);
+            memcpy(&out.pixels[(size_t)row * out.width], pixels, out.width * sizeof(uint16_t));
+            out.rows++;
+        });
+    if (decoder.error() != nullptr) out.error = decoder.error();
+    return out;
+}
+
+uint32_t nextRandom(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+std::vector<uint8_t> randomBytes(size_t count, uint32_t seed) {
+    std::vector<uint8_t> bytes(count);
+    for (uint8_t& byte : bytes) byte = nextRandom(seed);
+    return bytes;
+}
+
+// Sample index of a scanline, most significant bits first below 8 bits and the high byte at 16
+uint8_t sampleAt(const PngSpec& spec, const uint8_t* row, size_t index) {
+    if (spec.bitDepth == 16) return row[index * 2];
+    if (spec.bitDepth == 8) return row[index];
+    size_t bit = index * spec.bitDepth;
+    return (row[bit / 8] >> (8 - spec.bitDepth - bit % 8)) & ((1 << spec.bitDepth) - 1);
+}
+
+uint16_t rgb565(uint8_t r, uint8_t g, uint8_t b) {
+    return ((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3);
+}
+
+// What the image should look like on the panel: straight from the PNG spec, alpha over black
+std::vector<uint16_t> expectedPixels(const PngSpec& spec, const std::vector<uint8_t>& raw) {
+    std::vector<uint16_t> out;
+    for (uint32_t y = 0; y < spec.height; y++) {
+        const uint8_t* row = &raw[y * spec.rowBytes()];
+        for (uint32_t x = 0; x < spec.width; x++) {
+            uint8_t r, g, b, a = 0xFF;
+            switch (spec.colorType) {
+                case 0: {
+                    uint8_t v = sampleAt(spec, row, x);
+                    r = g = b = spec.bitDepth < 8 ? v * 255 / ((1 << spec.bitDepth) - 1) : v;
+                    break;
+                }
+                case 3: {
+                    uint8_t index = sampleAt(spec, row, x);
+                    r = spec.palette[index * 3];
+                    g = spec.palette[index * 3 + 1];
+                    b = spec.palette[index * 3 + 2];
+                    if (index < spec.paletteAlpha.size()) a = spec.paletteAlpha[index];
+                    break;
+                }
+                case 2:
+                    r = sampleAt(spec, row, x * 3);
+                    g = sampleAt(spec, row, x * 3 + 1);
+                    b = sampleAt(spec, row, x * 3 + 2);
+                    break;
+                case 4:
+                    r = g = b = sampleAt(spec, row, x * 2);
+                    a = sampleAt(spec, row, x * 2 + 1);
+                    break;
+                default:
+                    r = sampleAt(spec, row, x * 4);
+                    g = sampleAt(spec, row, x * 4 + 1);
+                    b = sampleAt(spec, row, x * 4 + 2);
+                    a = sampleAt(spec, row, x * 4 + 3);
+                    break;
+            }
+            r = (r * a + 127) / 255;
+            g = (g * a + 127) / 255;
+            b = (b * a + 127) / 255;
+            out.push_back(rgb565(r, g, b));
+        }
+    }
+    return out;
+}
+
+// Random scanlines for the spec; palette images get a random palette covering every index in use
+std::vector<uint8_t> randomImage(PngSpec& spec, uint32_t seed) {
+    if (spec.colorType == 3) {
+        size_t entries = 1u << spec.bitDepth;
+        spec.palette = randomBytes(entries * 3, seed + 100);
+        spec.paletteAlpha = randomBytes(entries / 2 + 1, seed + 200);
+    }
+    return randomBytes(spec.rowBytes() * spec.height, seed);
+}
+
+Decoded checkRoundTrip(PngSpec spec, uint32_t seed) {
+    std::vector<uint8_t> raw = randomImage(spec, seed);
+    Decoded out = decode(PngWriter::encode(spec, raw));
+    char label[64];
+    snprintf(label, sizeof(label), "type %u depth %u width %u", spec.colorType, spec.bitDepth, spec.width);
+    TEST_ASSERT_TRUE_MESSAGE(out.ok, (std::string(label) + ": " + out.error).c_str());
+    TEST_ASSERT_EQUAL_MESSAGE(spec.width, out.width, label);
+    TEST_ASSERT_EQUAL_MESSAGE(spec.height, out.rows, label);
+    std::vector<uint16_t> expected = expectedPixels(spec, raw);
+    TEST_ASSERT_EQUAL_HEX16_ARRAY_MESSAGE(expected.data(), out.pixels.data(), expected.size(), label);
+    return out;
+}
+
+PngSpec rgbSpec(uint32_t width, uint32_t height) {
+    PngSpec spec;
+    spec.width = width;
+    spec.height = height;
+    spec.filters = {0, 1, 2, 3, 4};
+    return spec;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_every_colour_type_and_depth() {
+    const uint8_t formats[][2] = {{0, 1}, {0, 2}, {0, 4}, {0, 8}, {0, 16}, {3, 1}, {3, 2}, {3, 4}, {3, 8},
+                                  {2, 8}, {2, 16}, {4, 8}, {4, 16}, {6, 8}, {6, 16}};
+    // Odd widths leave a partly used last byte at the small depths
+    const uint32_t widths[] = {1, 7, 13, 64};
+    for (const auto& format : formats) {
+        for (uint32_t width : widths) {
+            PngSpec spec = rgbSpec(width, 11);
+            spec.colorType = format[0];
+            spec.bitDepth = format[1];
+            checkRoundTrip(spec, width * 31 + format[0] * 7 + format[1]);
+        }
+    }
+}
+
+void test_every_filter() {
+    const uint8_t formats[][2] = {{2, 8}, {6, 16}, {0, 1}, {4, 8}, {3, 4}};
+    for (const auto& format : formats) {
+        for (uint8_t filter = 0; filter <= 4; filter++) {
+            PngSpec spec = rgbSpec(29, 9);
+            spec.colorType = format[0];
+            spec.bitDepth = format[1];
+            spec.filters = {filter};
+            checkRoundTrip(spec, filter + 1);
+        }
+    }
+}
+
+void test_idat_split_across_chunks() {
+    // Random pixels barely compress, so the stream is well over one 1 KB input read
+    PngSpec spec = rgbSpec(80, 40);
+    for (size_t idatBytes : {0, 1, 2, 7, 1000, 1023, 1024, 1025, 4096}) {
+        spec.idatBytes = idatBytes;
+        checkRoundTrip(spec, 5);
+    }
+}
+
+void test_idat_split_across_input_reads() {
+    // IDAT data is read 1 KB at a time; chunk sizes around and across that boundary
+    PngSpec spec = rgbSpec(80, 40);
+    for (size_t idatBytes : {0, 1025, 1500, 2047, 2048, 2049, 3000}) {
+        spec.idatBytes = idatBytes;
+        Decoded out = checkRoundTrip(spec, 6);
+        size_t fullReads = 0, largest = 0;
+        for (size_t len : out.reads) {
+            largest = std::max(largest, len);
+            if (len == 1024) fullReads++;
+        }
+        TEST_ASSERT_EQUAL(1024, largest);
+        TEST_ASSERT_GREATER_OR_EQUAL(2, fullReads);
+    }
+}
+
+void test_test_card_decodes() {
+    std::string png = PngWriter::testCard(600, 600, 2);
+    Decoded out = decode(png);
+    TEST_ASSERT_TRUE(out.ok);
+    TEST_ASSERT_EQUAL(600, out.width);
+    TEST_ASSERT_EQUAL(600, out.rows);
+}
+
+void test_back_references_across_the_window_wrap() {
+    // Ten random rows repeated: everything after the first ten is copies from about 30 KB back,
+    // so most matches reach across the point where the 32 KB window wraps
+    PngSpec spec = rgbSpec(1000, 120);
+    spec.filters = {0};
+    std::vector<uint8_t> tile = randomBytes(spec.rowBytes() * 10, 9);
+    std::vector<uint8_t> raw;
+    for (uint32_t y = 0; y < spec.height; y++) {
+        raw.insert(raw.end(), tile.begin() + (y % 10) * spec.rowBytes(), tile.begin() + (y % 10 + 1) * spec.rowBytes());
+    }
+    std::string png = PngWriter::encode(spec, raw);
+    TEST_ASSERT_LESS_THAN(raw.size() / 5, png.size());
+    Decoded out = decode(png);
+    TEST_ASSERT_TRUE_MESSAGE(out.ok, out.error.c_str());
+    TEST_ASSERT_EQUAL(spec.height, out.rows);
+    std::vector<uint16_t> expected = expectedPixels(spec, raw);
+    TEST_ASSERT_EQUAL_HEX16_ARRAY(expected.data(), out.pixels.data(), expected.size());
+}
+
+void test_rejects_truncated_files() {
+    PngSpec spec = rgbSpec(20, 10);
+    spec.idatBytes = 100;
+    std::string png = PngWriter::encode(spec, randomImage(spec, 7));
+    // Every cut short of the IEND chunk's own bytes has to fail cleanly
+    for (size_t cut = 0; cut + 12 < png.size(); cut++) {
+        Decoded out = decode(png.substr(0, cut));
+        TEST_ASSERT_FALSE(out.ok);
+        TEST_ASSERT_FALSE(out.error.empty());
+    }
+    TEST_ASSERT_EQUAL_STRING("not a PNG", decode(png.substr(0, 5)).error.c_str());
+    TEST_ASSERT_EQUAL_STRING("truncated before IEND", decode(png.substr(0, png.size() - 12)).error.c_str());
+
+    spec.writeEnd = false;
+    TEST_ASSERT_EQUAL_STRING("truncated before IEND", decode(PngWriter::encode(spec, randomImage(spec, 7))).error.c_str());
+}
+
+void test_rejects_short_image_data() {
+    // A complete zlib stream holding fewer rows than IHDR promises
+    PngSpec spec = rgbSpec(20, 10);
+    std::vector<uint8_t> raw = randomImage(spec, 8);
+    PngSpec shortSpec = spec;
+    shortSpec.height = 6;
+    std::string png = PngWriter::encode(shortSpec, raw);
+    std::string full = PngWriter::encode(spec, raw);
+    // Splice the taller IHDR (bytes 8..32 with its CRC) onto the shorter image
+    png.replace(8, 25, full.substr(8, 25));
+    Decoded out = decode(png);
+    TEST_ASSERT_FALSE(out.ok);
+    TEST_ASSERT_EQUAL_STRING("image data ended early", out.error.c_str());
+    TEST_ASSERT_EQUAL(6, out.rows);
+}
+
+void test_rejects_interlaced() {
+    PngSpec spec = rgbSpec(16, 16);
+    spec.interlace = 1;
+    Decoded out = decode(PngWriter::encode(spec, randomImage(spec, 9)));
+    TEST_ASSERT_FALSE(out.ok);
+    TEST_ASSERT_EQUAL_STRING("interlaced PNG not supported", out.error.c_str());
+}
+
+void test_rejects_bad_filter() {
+    PngSpec spec = rgbSpec(16, 6);
+    spec.filters = {0, 1, 2, 5};
+    Decoded out = decode(PngWriter::encode(spec, randomImage(spec, 10)));
+    TEST_ASSERT_FALSE(out.ok);
+    TEST_ASSERT_EQUAL_STRING("bad filter type", out.error.c_str());
+    TEST_ASSERT_EQUAL(3, out.rows);
+}
+
+void test_rejects_missing_header() {
+    PngSpec spec = rgbSpec(16, 6);
+    spec.writeHeader = false;
+    Decoded out = decode(PngWriter::encode(spec, randomImage(spec, 11)));
+    TEST_ASSERT_FALSE(out.ok);
+    TEST_ASSERT_EQUAL_STRING("missing IHDR", out.error.c_str());
+    TEST_ASSERT_EQUAL(0, out.rows);
+}
+
+void test_rejects_unsupported_formats() {
+    PngSpec spec = rgbSpec(4, 4);
+    spec.bitDepth = 4;
+    TEST_ASSERT_EQUAL_STRING("bad bit depth", decode(PngWriter::encode(spec, randomImage(spec, 12))).error.c_str());
+    spec.colorType = 3;
+    spec.bitDepth = 16;
+    TEST_ASSERT_EQUAL_STRING("bad bit depth", decode(PngWriter::encode(spec, randomImage(spec, 12))).error.c_str());
+    spec.colorType = 5;
+    spec.bitDepth = 8;
+    TEST_ASSERT_EQUAL_STRING("unknown color type", decode(PngWriter::encode(spec, randomImage(spec, 12))).error.c_str());
+    spec = rgbSpec(5000, 1);
+    TEST_ASSERT_EQUAL_STRING("unsupported size", decode(PngWriter::encode(spec, randomImage(spec, 12))).error.c_str());
+}
+
+void test_header_callback_can_refuse() {
+    PngSpec spec = rgbSpec(8, 8);
+    std::string png = PngWriter::encode(spec, randomImage(spec, 13));
+    size_t pos = 0;
+    PngDecoder decoder([&](uint8_t* dest, size_t len) {
+        size_t n = std::min(len, png.size() - pos);
+        if (dest != nullptr) memcpy(dest, png.data() + pos, n);
+        pos += n;
+        return n;
+    });
+    int rows = 0;
+    TEST_ASSERT_FALSE(decoder.decode([](uint16_t, uint16_t) { return false; }, [&rows](uint16_t, const uint16_t*) { rows++; }));
+    TEST_ASSERT_EQUAL_STRING("size rejected", decoder.error());
+    TEST_ASSERT_EQUAL(0, rows);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_colour_type_and_depth);
+    RUN_TEST(test_every_filter);
+    RUN_TEST(test_idat_split_across_chunks);
+    RUN_TEST(test_idat_split_across_input_reads);
+    RUN_TEST(test_test_card_decodes);
+    RUN_TEST(test_back_references_across_the_window_wrap);
+    RUN_TEST(test_rejects_truncated_files);
+    RUN_TEST(test_rejects_short_image_data);
+    RUN_TEST(test_rejects_interlaced);
+    RUN_TEST(test_rejects_bad_filter);
+    RUN_TEST(test_rejects_missing_header);
+    RUN_TEST(test_rejects_unsupported_formats);
+    RUN_TEST(test_header_callback_can_refuse);
+    return UNITY_END();
+}
@@ -0,0 +1,174 @@
+// RtcState pack/unpack: the RTC snapshot must come back exactly, reject anything corrupt and drop
+// subscriptions that lapsed while the remote slept.
+#include <unity.h>
+#include <Arduino.h>
+#include <esp_sleep.h>
+#include "RtcState.h"
+
+namespace {
+
+const int64_t SAVED_AT = 1760000000;
+
+RuntimeState sampleState() {
+    RuntimeState state;
+    state.deviceUuid = "RINCON_000E58A0B1C201400";
+    state.deviceName = "Living Room";
+    state.deviceIP = "192.168.1.31";
+    state.coordinatorUuid = "RINCON_000E58A0B1C301400";
+    state.coordinatorIP = "192.168.1.32";
+    state.localIP = "192.168.1.50";
+    state.track.title = "Song Title";
+    state.track.artist = "Artist";
+    state.track.album = "Album";
+    state.track.albumArtUrl = "/getaa?s=1&u=x-sonos-spotify";
+    state.track.playbackState = "PLAYING";
+    state.track.position = 83;
+    state.track.duration = 241;
+    state.track.volume = 27;
+    state.subscriptions.push_back({"192.168.1.32", "AVTransport", "uuid:RINCON_000E58A0B1C301400_sub0000000123", 3600});
+    state.subscriptions.push_back({"192.168.1.31", "RenderingControl", "uuid:RINCON_000E58A0B1C201400_sub0000000456", 600});
+    return state;
+}
+
+}  // namespace
+
+void setUp() {
+    hostWakeupCause = ESP_SLEEP_WAKEUP_UNDEFINED;
+    RtcState::clear();
+}
+
+void tearDown() {}
+
+void test_round_trip_keeps_every_field() {
+    RuntimeState state = sampleState();
+    RtcSnapshot snapshot;
+    RtcState::pack(state, SAVED_AT, snapshot);
+
+    RuntimeState restored;
+    TEST_ASSERT_TRUE(RtcState::unpack(snapshot, SAVED_AT + 10, restored));
+    TEST_ASSERT_EQUAL_STRING(state.deviceUuid.c_str(), restored.deviceUuid.c_str());
+    TEST_ASSERT_EQUAL_STRING(state.deviceName.c_str(), restored.deviceName.c_str());
+    TEST_ASSERT_EQUAL_STRING(state.deviceIP.c_str(), restored.deviceIP.c_str());
+    TEST_ASSERT_EQUAL_STRING(state.coordinatorUuid.c_str(), restored.coordinatorUuid.c_str());
+    TEST_ASSERT_EQUAL_STRING(state.coordinatorIP.c_str(), restored.coordinatorIP.c_str());
+    TEST_ASSERT_EQUAL_STRING(state.localIP.c_str(), restored.localIP.c_str());
+    TEST_ASSERT_EQUAL_STRING(state.track.title.c_str(), restored.track.title.c_str());
+    TEST_ASSERT_EQUAL_STRING(state.track.artist.c_str(), restored.track.artist.c_str());
+    TEST_ASSERT_EQUAL_STRING(state.track.album.c_str(), restored.track.album.c_str());
+    TEST_ASSERT_EQUAL_STRING(state.track.playbackState.c_str(), restored.track.playbackState.c_str());
+    // Art URLs expire; the art is refetched after a wake
+    TEST_ASSERT_EQUAL_STRING("", restored.track.albumArtUrl.c_str());
+    TEST_ASSERT_EQUAL(83, restored.track.position);
+    TEST_ASSERT_EQUAL(241, restored.track.duration);
+    TEST_ASSERT_EQUAL(27, restored.track.volume);
+
+    TEST_ASSERT_EQUAL(2, restored.subscriptions.size());
+    for (size_t i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL_STRING(state.subscriptions[i].ip.c_str(), restored.subscriptions[i].ip.c_str());
+        TEST_ASSERT_EQUAL_STRING(state.subscriptions[i].service.c_str(), restored.subscriptions[i].service.c_str());
+        TEST_ASSERT_EQUAL_STRING(state.subscriptions[i].sid.c_str(), restored.subscriptions[i].sid.c_str());
+        TEST_ASSERT_EQUAL(state.subscriptions[i].secondsLeft - 10, restored.subscriptions[i].secondsLeft);
+    }
+}
+
+void test_long_strings_are_cut_and_terminated() {
+    RuntimeState state = sampleState();
+    state.track.title = String(std::string(200, 'T').c_str());
+    RtcSnapshot snapshot;
+    RtcState::pack(state, SAVED_AT, snapshot);
+
+    RuntimeState restored;
+    TEST_ASSERT_TRUE(RtcState::unpack(snapshot, SAVED_AT, restored));
+    TEST_ASSERT_EQUAL(sizeof(snapshot.title) - 1, restored.track.title.length());
+}
+
+void test_crc_mismatch_is_rejected() {
+    RtcSnapshot snapshot;
+    RtcState::pack(sampleState(), SAVED_AT, snapshot);
+    RuntimeState restored;
+
+    RtcSnapshot corrupt = snapshot;
+    corrupt.title[0] ^= 0x20;
+    TEST_ASSERT_FALSE(RtcState::unpack(corrupt, SAVED_AT, restored));
+
+    corrupt = snapshot;
+    corrupt.subscriptions[1].expiresAt += 1;
+    TEST_ASSERT_FALSE(RtcState::unpack(corrupt, SAVED_AT, restored));
+
+    corrupt = snapshot;
+    corrupt.crc ^= 1;
+    TEST_ASSERT_FALSE(RtcState::unpack(corrupt, SAVED_AT, restored));
+
+    TEST_ASSERT_TRUE(RtcState::unpack(snapshot, SAVED_AT, restored));
+}
+
+void test_uninitialised_memory_is_rejected() {
+    RtcSnapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    RuntimeState restored;
+    TEST_ASSERT_FALSE(RtcState::unpack(snapshot, SAVED_AT, restored));
+
+    // Power-on garbage that happens to carry the magic still fails the CRC
+    RtcState::pack(sampleState(), SAVED_AT, snapshot);
+    memset(snapshot.deviceName, 0xA5, sizeof(snapshot.deviceName));
+    TEST_ASSERT_FALSE(RtcState::unpack(snapshot, SAVED_AT, restored));
+}
+
+void test_expired_subscriptions_are_dropped() {
+    RuntimeState state = sampleState();
+    state.subscriptions.push_back({"192.168.1.33", "ZoneGroupTopology", "uuid:RINCON_000E58A0B1C401400_sub0000000789", 100});
+    RtcSnapshot snapshot;
+    RtcState::pack(state, SAVED_AT, snapshot);
+    TEST_ASSERT_EQUAL(3, snapshot.subscriptionCount);
+
+    // 80 s later the third has 20 s left, inside the renewal margin, so it is resubscribed instead
+    RuntimeState restored;
+    TEST_ASSERT_TRUE(RtcState::unpack(snapshot, SAVED_AT + 80, restored));
+    TEST_ASSERT_EQUAL(2, restored.subscriptions.size());
+    TEST_ASSERT_EQUAL(3520, restored.subscriptions[0].secondsLeft);
+    TEST_ASSERT_EQUAL(520, restored.subscriptions[1].secondsLeft);
+
+    // After an hour asleep every SID has lapsed; the rest of the state is still good
+    TEST_ASSERT_TRUE(RtcState::unpack(snapshot, SAVED_AT + 3600, restored));
+    TEST_ASSERT_EQUAL(0, restored.subscriptions.size());
+    TEST_ASSERT_EQUAL_STRING("Living Room", restored.deviceName.c_str());
+}
+
+void test_subscriptions_that_do_not_fit_are_left_out() {
+    RuntimeState state = sampleState();
+    state.subscriptions[0].sid = String(std::string(60, 'S').c_str());
+    for (int i = 0; i < 5; i++) state.subscriptions.push_back({"192.168.1.40", "Queue", "uuid:sid" + String(i), 900});
+    RtcSnapshot snapshot;
+    RtcState::pack(state, SAVED_AT, snapshot);
+
+    RuntimeState restored;
+    TEST_ASSERT_TRUE(RtcState::unpack(snapshot, SAVED_AT, restored));
+    TEST_ASSERT_EQUAL(RtcSnapshot::MAX_SUBSCRIPTIONS, restored.subscriptions.size());
+    TEST_ASSERT_EQUAL_STRING("RenderingControl", restored.subscriptions[0].service.c_str());
+    TEST_ASSERT_EQUAL_STRING("uuid:sid2", restored.subscriptions[3].sid.c_str());
+}
+
+void test_restore_only_after_deep_sleep_wake() {
+    RtcState::save(sampleState());
+    RuntimeState restored;
+    TEST_ASSERT_FALSE(RtcState::restore(restored));
+
+    hostWakeupCause = ESP_SLEEP_WAKEUP_EXT0;
+    TEST_ASSERT_TRUE(RtcState::restore(restored));
+    TEST_ASSERT_EQUAL_STRING("Living Room", restored.deviceName.c_str());
+
+    RtcState::clear();
+    TEST_ASSERT_FALSE(RtcState::restore(restored));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_keeps_every_field);
+    RUN_TEST(test_long_strings_are_cut_and_terminated);
+    RUN_TEST(test_crc_mismatch_is_rejected);
+    RUN_TEST(test_uninitialised_memory_is_rejected);
+    RUN_TEST(test_expired_subscriptions_are_dropped);
+    RUN_TEST(test_subscriptions_that_do_not_fit_are_left_out);
+    RUN_TEST(test_restore_only_after_deep_sleep_wake);
+    return UNITY_END();
+}
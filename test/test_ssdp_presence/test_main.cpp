@@ -0,0 +1,257 @@
+// Presence tracking against a local SSDP announcer: NOTIFYs go to the listener over loopback and
+// descriptions come from stand-in speakers on 127.0.1.x:1400.
+#include <unity.h>
+#include <Arduino.h>
+#include <LittleFS.h>
+#include <Sonos.h>
+#include "DeviceCache.h"
+#include "DiscoveryManager.h"
+#include "SilentHosts.h"
+#include "StandInSpeakers.h"
+
+namespace {
+
+const uint16_t NOTIFY_PORT = 41900;
+
+StandInSpeakers* speakers = nullptr;
+Sonos* sonos = nullptr;
+std::vector<SonosDevice> found;
+std::vector<SonosDevice> lost;
+
+SonosConfig presenceConfig() {
+    SonosConfig config;
+    config.discoveryPort = 0;
+    config.descriptionTimeoutMs = 2000;
+    return config;
+}
+
+void startSonos() {
+    sonos = new Sonos(presenceConfig());
+    sonos->setDeviceFoundCallback([](const SonosDevice& device) { found.push_back(device); });
+    sonos->setDeviceLostCallback([](const SonosDevice& device) { lost.push_back(device); });
+    TEST_ASSERT_TRUE(sonos->begin() == SonosResult::SUCCESS);
+    TEST_ASSERT_TRUE(sonos->isPresenceActive());
+}
+
+// Runs updatePresence() like loop() does until done() or timeoutMs; returns the slowest single call
+unsigned long pumpPresence(const std::function<bool()>& done, unsigned long timeoutMs) {
+    unsigned long start = millis();
+    unsigned long slowest = 0;
+    while (!done() && millis() - start < timeoutMs) {
+        unsigned long callStart = millis();
+        sonos->updatePresence();
+        slowest = max(slowest, millis() - callStart);
+        delay(1);
+    }
+    return slowest;
+}
+
+}  // namespace
+
+void setUp() {
+    HostNet::multicastListenPort = NOTIFY_PORT;
+    found.clear();
+    lost.clear();
+}
+
+void tearDown() {
+    if (sonos != nullptr) {
+        sonos->end();
+        delete sonos;
+        sonos = nullptr;
+    }
+    if (speakers != nullptr) {
+        speakers->stop();
+        delete speakers;
+        speakers = nullptr;
+    }
+}
+
+void test_alive_from_new_speaker_is_fetched_without_blocking() {
+    speakers = new StandInSpeakers();
+    // A slow description server; the fetch must not hold up the UI loop
+    TEST_ASSERT_TRUE(speakers->start(1, 0, 300));
+    startSonos();
+
+    speakers->notify(0, true);
+    unsigned long slowest = pumpPresence([]() { return !found.empty(); }, 3000);
+
+    TEST_ASSERT_EQUAL(1, found.size());
+    TEST_ASSERT_EQUAL_STRING(StandInSpeakers::roomName(0).c_str(), found[0].name.c_str());
+    TEST_ASSERT_EQUAL_STRING(StandInSpeakers::ip(0).c_str(), found[0].ip.c_str());
+    TEST_ASSERT_EQUAL_STRING(StandInSpeakers::uuid(0).c_str(), found[0].uuid.c_str());
+    TEST_ASSERT_EQUAL(1800000, found[0].maxAgeMs);
+    TEST_ASSERT_LESS_THAN(100, slowest);
+    TEST_ASSERT_EQUAL(1, sonos->getDeviceCount());
+}
+
+void test_repeated_alive_does_not_refetch() {
+    speakers = new StandInSpeakers();
+    TEST_ASSERT_TRUE(speakers->start(1));
+    startSonos();
+
+    // Each speaker announces several NTs at once; one description fetch covers them
+    for (int i = 0; i < 3; i++) speakers->notify(0, true);
+    pumpPresence([]() { return !found.empty(); }, 2000);
+    TEST_ASSERT_EQUAL(1, speakers->descriptionRequests());
+
+    unsigned long firstSeen = sonos->getDeviceByUuid(StandInSpeakers::uuid(0).c_str())->lastSeenMs;
+    delay(20);
+    speakers->notify(0, true);
+    pumpPresence([]() { return false; }, 200);
+    TEST_ASSERT_EQUAL(1, speakers->descriptionRequests());
+    TEST_ASSERT_GREATER_THAN(firstSeen, sonos->getDeviceByUuid(StandInSpeakers::uuid(0).c_str())->lastSeenMs);
+
+    // A new BOOTID means the speaker restarted and may have changed; fetch again
+    speakers->notify(0, true, 1800, 2);
+    pumpPresence([]() { return false; }, 300);
+    TEST_ASSERT_EQUAL(2, speakers->descriptionRequests());
+    TEST_ASSERT_EQUAL(1, sonos->getDeviceCount());
+}
+
+void test_byebye_removes_speaker() {
+    speakers = new StandInSpeakers();
+    TEST_ASSERT_TRUE(speakers->start(2));
+    startSonos();
+
+    speakers->notify(0, true);
+    speakers->notify(1, true);
+    pumpPresence([]() { return found.size() == 2; }, 2000);
+    TEST_ASSERT_EQUAL(2, sonos->getDeviceCount());
+
+    speakers->notify(1, false);
+    pumpPresence([]() { return !lost.empty(); }, 1000);
+    TEST_ASSERT_EQUAL(1, lost.size());
+    TEST_ASSERT_EQUAL_STRING(StandInSpeakers::uuid(1).c_str(), lost[0].uuid.c_str());
+    TEST_ASSERT_EQUAL(1, sonos->getDeviceCount());
+}
+
+void test_byebye_cancels_queued_fetch() {
+    speakers = new StandInSpeakers();
+    TEST_ASSERT_TRUE(speakers->start(1));
+    startSonos();
+
+    // Both datagrams land in the same drain pass, before any fetch starts
+    speakers->notify(0, true);
+    speakers->notify(0, false);
+    delay(20);
+    pumpPresence([]() { return false; }, 300);
+    TEST_ASSERT_EQUAL(0, speakers->descriptionRequests());
+    TEST_ASSERT_EQUAL(0, sonos->getDeviceCount());
+}
+
+void test_lease_expires_without_renewal() {
+    speakers = new StandInSpeakers();
+    TEST_ASSERT_TRUE(speakers->start(1));
+    startSonos();
+
+    speakers->notify(0, true, 1);
+    pumpPresence([]() { return !found.empty(); }, 2000);
+    TEST_ASSERT_EQUAL(1, sonos->getDeviceCount());
+
+    pumpPresence([]() { return !lost.empty(); }, 3500);
+    TEST_ASSERT_EQUAL(1, lost.size());
+    TEST_ASSERT_EQUAL(0, sonos->getDeviceCount());
+}
+
+void test_discovery_manager_coalesces_list_refreshes() {
+    const size_t count = 30;
+    speakers = new StandInSpeakers();
+    TEST_ASSERT_TRUE(speakers->start(count));
+
+    LittleFS.begin(true);
+    LittleFS.format();
+    DeviceCache cache;
+    cache.begin();
+    sonos = new Sonos(presenceConfig());
+    DiscoveryManager manager(*sonos, cache);
+    int refreshes = 0;
+    size_t listed = 0;
+    manager.setDiscoveryCallback([&](const std::vector<SonosDevice>& devices) {
+        refreshes++;
+        listed = devices.size();
+    });
+    TEST_ASSERT_TRUE(sonos->begin() == SonosResult::SUCCESS);
+    // With devices already cached, presence alone keeps the list current; no scan starts
+    std::vector<SonosDevice> seed(1);
+    seed[0].name = StandInSpeakers::roomName(0).c_str();
+    seed[0].ip = StandInSpeakers::ip(0).c_str();
+    seed[0].uuid = StandInSpeakers::uuid(0).c_str();
+    cache.saveDevices(seed);
+    manager.begin();
+    manager.update();
+    refreshes = 0;
+
+    for (size_t i = 1; i < count; i++) speakers->notify(i, true);
+    unsigned long start = millis();
+    while (listed < count && millis() - start < 5000) {
+        manager.update();
+        delay(1);
+    }
+    delay(300);
+    manager.update();
+
+    TEST_ASSERT_EQUAL(count, manager.getDevices().size());
+    TEST_ASSERT_EQUAL(count, listed);
+    TEST_ASSERT_FALSE(sonos->isDiscovering());
+    TEST_ASSERT_LESS_THAN((int)count / 3, refreshes);
+    sonos->end();
+}
+
+void test_presence_only_update_never_blocks() {
+    speakers = new StandInSpeakers();
+    TEST_ASSERT_TRUE(speakers->start(2));
+    // A cached speaker that is switched off: validating it runs into the probe deadline
+    SilentHosts silent;
+    TEST_ASSERT_TRUE(silent.add("127.0.5.1", 1400));
+
+    LittleFS.begin(true);
+    LittleFS.format();
+    DeviceCache cache;
+    cache.begin();
+    std::vector<SonosDevice> seed(2);
+    seed[0].name = StandInSpeakers::roomName(0).c_str();
+    seed[0].ip = StandInSpeakers::ip(0).c_str();
+    seed[0].uuid = StandInSpeakers::uuid(0).c_str();
+    seed[1].name = "Garage";
+    seed[1].ip = "127.0.5.1";
+    seed[1].uuid = "RINCON_0000000005A101400";
+    cache.saveDevices(seed);
+    sonos = new Sonos(presenceConfig());
+    DiscoveryManager manager(*sonos, cache);
+    TEST_ASSERT_TRUE(sonos->begin() == SonosResult::SUCCESS);
+    manager.begin();
+
+    // Now Playing: a new speaker still shows up, and no pass waits on the network
+    speakers->notify(1, true);
+    unsigned long start = millis(), slowest = 0;
+    while (manager.getDevices().size() < 3 && millis() - start < 3000) {
+        unsigned long callStart = millis();
+        manager.updatePresence();
+        slowest = max(slowest, millis() - callStart);
+        delay(1);
+    }
+    TEST_ASSERT_EQUAL(3, manager.getDevices().size());
+    TEST_ASSERT_FALSE(sonos->isDiscovering());
+    TEST_ASSERT_LESS_THAN(20, slowest);
+
+    // Back on the speaker list, the deferred validation runs and takes its time there
+    unsigned long validateStart = millis();
+    manager.update();
+    unsigned long validateMs = millis() - validateStart;
+    printf("\nPresence-only pass: slowest %lu ms; deferred validation: %lu ms\n", slowest, validateMs);
+    TEST_ASSERT_GREATER_OR_EQUAL(100, validateMs);
+    sonos->end();
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_alive_from_new_speaker_is_fetched_without_blocking);
+    RUN_TEST(test_repeated_alive_does_not_refetch);
+    RUN_TEST(test_byebye_removes_speaker);
+    RUN_TEST(test_byebye_cancels_queued_fetch);
+    RUN_TEST(test_lease_expires_without_renewal);
+    RUN_TEST(test_discovery_manager_coalesces_list_refreshes);
+    RUN_TEST(test_presence_only_update_never_blocks);
+    return UNITY_END();
+}
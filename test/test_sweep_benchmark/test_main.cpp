@@ -0,0 +1,79 @@
+// Subnet sweep time against sweepConcurrency. A /26 of loopback addresses holds a few stand-in
+// speakers; every other address is silent, so each empty host costs a full connect timeout as
+// it does on a real LAN.
+#include <unity.h>
+#include <Arduino.h>
+#include <Sonos.h>
+#include "SilentHosts.h"
+#include "StandInSpeakers.h"
+
+namespace {
+
+const size_t SPEAKERS = 6;
+const char* const SWEEP_CIDR = "127.0.1.0/26";
+const uint32_t HOSTS = 62;
+const uint16_t CONNECT_TIMEOUT_MS = 250;
+
+StandInSpeakers speakers;
+SilentHosts silent;
+
+struct SweepRun {
+    unsigned long elapsedMs;
+    size_t found;
+    SonosDiscoveryStats stats;
+};
+
+SweepRun sweep(uint8_t concurrency) {
+    SonosConfig config;
+    config.discoveryPort = 0;
+    config.sweepCidr = SWEEP_CIDR;
+    config.sweepConcurrency = concurrency;
+    config.sweepConnectTimeoutMs = CONNECT_TIMEOUT_MS;
+    Sonos sonos(config);
+    TEST_ASSERT_TRUE(sonos.begin() == SonosResult::SUCCESS);
+
+    unsigned long start = millis();
+    TEST_ASSERT_TRUE(sonos.sweepSubnet() == SonosResult::SUCCESS);
+    while (sonos.isDiscovering()) sonos.updateDiscovery();
+    SweepRun run{millis() - start, sonos.getDiscoveredDevices().size(), sonos.getLastDiscoveryStats()};
+    sonos.end();
+    return run;
+}
+
+}  // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_sweep_time_by_concurrency() {
+    static const uint8_t kConcurrency[] = {1, 4, 8, 16, 32};
+    unsigned long elapsed[sizeof(kConcurrency)];
+
+    printf("\nSweep of %s: %u hosts, %u speakers, %u ms connect timeout\n", SWEEP_CIDR, (unsigned)HOSTS,
+           (unsigned)SPEAKERS, CONNECT_TIMEOUT_MS);
+    printf("%12s %10s %8s %8s %8s\n", "concurrency", "ms", "probed", "hits", "found");
+    for (size_t i = 0; i < sizeof(kConcurrency); i++) {
+        SweepRun run = sweep(kConcurrency[i]);
+        elapsed[i] = run.elapsedMs;
+        printf("%12u %10lu %8u %8u %8u\n", kConcurrency[i], run.elapsedMs, run.stats.hostsProbed, run.stats.sweepHits,
+               (unsigned)run.found);
+        TEST_ASSERT_EQUAL(HOSTS, run.stats.hostsProbed);
+        TEST_ASSERT_EQUAL(SPEAKERS, run.stats.sweepHits);
+        TEST_ASSERT_EQUAL(SPEAKERS, run.found);
+    }
+    // Empty hosts dominate, so the sweep should scale close to linearly until the batch covers the range
+    TEST_ASSERT_LESS_THAN(elapsed[0] / 4, elapsed[2]);
+}
+
+int main() {
+    TEST_ASSERT_TRUE(speakers.start(SPEAKERS));
+    for (size_t i = SPEAKERS; i < HOSTS; i++) {
+        if (!silent.add(StandInSpeakers::ip(i), StandInSpeakers::DESCRIPTION_PORT)) return 1;
+    }
+    UNITY_BEGIN();
+    RUN_TEST(test_sweep_time_by_concurrency);
+    int failures = UNITY_END();
+    silent.stop();
+    speakers.stop();
+    return failures;
+}
@@ -0,0 +1,168 @@
+// GetZoneGroupState over the streaming SOAP path against a stand-in speaker that can frame its
+// reply several ways, cut it short or stall halfway.
+#include <unity.h>
+#include <Arduino.h>
+#include <Sonos.h>
+#include "StandInServer.h"
+
+namespace {
+
+const char* const SPEAKER_IP = "127.0.3.1";
+const char* const MEMBER_IP = "127.0.3.2";
+const uint16_t SOAP_TIMEOUT_MS = 1500;
+
+enum class Framing { CONTENT_LENGTH, DYNAMIC, TRUNCATED, STALLED };
+
+Framing framing = Framing::CONTENT_LENGTH;
+bool grouped = true;
+std::string lastRequestLine;
+StandInServer* server = nullptr;
+Sonos* sonos = nullptr;
+
+std::string member(const char* uuid, const char* ip) {
+    return std::string("&lt;ZoneGroupMember UUID=&quot;") + uuid + "&quot; Location=&quot;http://" + ip +
+           ":1400/xml/device_description.xml&quot; ZoneName=&quot;" + uuid + "&quot;/&gt;";
+}
+
+// Two members; grouped puts both under the first speaker, otherwise each leads its own group
+std::string zoneGroupState() {
+    std::string state = "&lt;ZoneGroupState&gt;&lt;ZoneGroups&gt;";
+    if (grouped) {
+        state += "&lt;ZoneGroup Coordinator=&quot;RINCON_A&quot; ID=&quot;RINCON_A:1&quot;&gt;" + member("RINCON_A", SPEAKER_IP) +
+                 member("RINCON_B", MEMBER_IP) + "&lt;/ZoneGroup&gt;";
+    } else {
+        state += "&lt;ZoneGroup Coordinator=&quot;RINCON_A&quot; ID=&quot;RINCON_A:2&quot;&gt;" + member("RINCON_A", SPEAKER_IP) +
+                 "&lt;/ZoneGroup&gt;&lt;ZoneGroup Coordinator=&quot;RINCON_B&quot; ID=&quot;RINCON_B:2&quot;&gt;" +
+                 member("RINCON_B", MEMBER_IP) + "&lt;/ZoneGroup&gt;";
+    }
+    state += "&lt;/ZoneGroups&gt;&lt;/ZoneGroupState&gt;";
+    // Real replies carry kilobytes of vanished devices and attributes; pad so the body spans many reads
+    std::string padding(4096, ' ');
+    return "<s:Envelope xmlns:s=\"http://schemas.xmlsoap.org/soap/envelope/\"><s:Body>"
+           "<u:GetZoneGroupStateResponse xmlns:u=\"urn:schemas-upnp-org:service:ZoneGroupTopology:1\"><ZoneGroupState>" +
+           padding + state + "</ZoneGroupState></u:GetZoneGroupStateResponse></s:Body></s:Envelope>";
+}
+
+std::string chunked(const std::string& body) {
+    std::string out;
+    for (size_t at = 0; at < body.size(); at += 1000) {
+        std::string piece = body.substr(at, 1000);
+        char size[16];
+        snprintf(size, sizeof(size), "%zx\r\n", piece.size());
+        out += size + piece + "\r\n";
+    }
+    return out + "0\r\n\r\n";
+}
+
+StandInServer::Reply respond(const StandInServer::Request& request) {
+    lastRequestLine = request.headers.substr(0, request.headers.find("\r\n"));
+    bool http10 = lastRequestLine.find("HTTP/1.0") != std::string::npos;
+    std::string body = zoneGroupState();
+    std::string lengthHeader = "Content-Length: " + std::to_string(body.size()) + "\r\n";
+    StandInServer::Reply reply;
+    switch (framing) {
+        case Framing::CONTENT_LENGTH:
+            return StandInServer::ok(body, "text/xml", !http10);
+        case Framing::DYNAMIC:
+            // What an HTTP/1.1 server does with a generated body: chunked and kept alive, unless the client spoke 1.0
+            if (http10) {
+                reply.data = "HTTP/1.1 200 OK\r\nContent-Type: text/xml\r\nConnection: close\r\n\r\n" + body;
+            } else {
+                reply.data = "HTTP/1.1 200 OK\r\nContent-Type: text/xml\r\nTransfer-Encoding: chunked\r\n\r\n" + chunked(body);
+                reply.close = false;
+            }
+            return reply;
+        case Framing::TRUNCATED:
+            reply.data = "HTTP/1.1 200 OK\r\nContent-Type: text/xml\r\n" + lengthHeader + "\r\n" + body.substr(0, body.size() - 200);
+            return reply;
+        case Framing::STALLED:
+            reply.data = "HTTP/1.1 200 OK\r\nContent-Type: text/xml\r\n" + lengthHeader + "\r\n" + body.substr(0, body.size() - 200);
+            reply.holdMs = SOAP_TIMEOUT_MS * 3;
+            return reply;
+    }
+    return reply;
+}
+
+// Refreshes once with the given framing; returns the result and how long it took
+SonosResult refresh(Framing mode, bool groupedState, unsigned long& elapsedMs) {
+    framing = mode;
+    grouped = groupedState;
+    unsigned long start = millis();
+    SonosResult result = sonos->refreshTopology(SPEAKER_IP);
+    elapsedMs = millis() - start;
+    return result;
+}
+
+}  // namespace
+
+void setUp() {
+    server = new StandInServer();
+    TEST_ASSERT_NOT_EQUAL(0, server->listenOn(SPEAKER_IP, 1400));
+    server->start(respond);
+    SonosConfig config;
+    config.discoveryPort = 0;
+    config.enablePresenceListener = false;
+    config.soapTimeoutMs = SOAP_TIMEOUT_MS;
+    config.maxRetries = 1;
+    sonos = new Sonos(config);
+    TEST_ASSERT_TRUE(sonos->begin() == SonosResult::SUCCESS);
+}
+
+void tearDown() {
+    sonos->end();
+    delete sonos;
+    sonos = nullptr;
+    delete server;
+    server = nullptr;
+}
+
+void test_content_length_reply_applies_topology() {
+    unsigned long elapsed;
+    TEST_ASSERT_TRUE(refresh(Framing::CONTENT_LENGTH, true, elapsed) == SonosResult::SUCCESS);
+    TEST_ASSERT_EQUAL_STRING(SPEAKER_IP, sonos->getCoordinatorIP(MEMBER_IP).c_str());
+    TEST_ASSERT_TRUE(sonos->isGrouped(MEMBER_IP));
+    TEST_ASSERT_LESS_THAN(SOAP_TIMEOUT_MS / 3, elapsed);
+}
+
+void test_reply_without_length_is_neither_chunked_nor_waited_out() {
+    unsigned long elapsed;
+    TEST_ASSERT_TRUE(refresh(Framing::DYNAMIC, true, elapsed) == SonosResult::SUCCESS);
+    // Asking for HTTP/1.0 is what keeps chunk framing out of the XML and ends the body at the close
+    TEST_ASSERT_TRUE(lastRequestLine.find("HTTP/1.0") != std::string::npos);
+    TEST_ASSERT_EQUAL_STRING(SPEAKER_IP, sonos->getCoordinatorIP(MEMBER_IP).c_str());
+    TEST_ASSERT_LESS_THAN(SOAP_TIMEOUT_MS / 3, elapsed);
+}
+
+void test_truncated_reply_keeps_previous_topology() {
+    unsigned long elapsed;
+    TEST_ASSERT_TRUE(refresh(Framing::CONTENT_LENGTH, true, elapsed) == SonosResult::SUCCESS);
+    TEST_ASSERT_TRUE(refresh(Framing::TRUNCATED, false, elapsed) == SonosResult::ERROR_NETWORK);
+    TEST_ASSERT_EQUAL_STRING(SPEAKER_IP, sonos->getCoordinatorIP(MEMBER_IP).c_str());
+}
+
+void test_stalled_reply_times_out_and_keeps_previous_topology() {
+    unsigned long elapsed;
+    TEST_ASSERT_TRUE(refresh(Framing::CONTENT_LENGTH, true, elapsed) == SonosResult::SUCCESS);
+    TEST_ASSERT_TRUE(refresh(Framing::STALLED, false, elapsed) == SonosResult::ERROR_NETWORK);
+    TEST_ASSERT_EQUAL_STRING(SPEAKER_IP, sonos->getCoordinatorIP(MEMBER_IP).c_str());
+    TEST_ASSERT_GREATER_OR_EQUAL(SOAP_TIMEOUT_MS, elapsed);
+    TEST_ASSERT_LESS_THAN(SOAP_TIMEOUT_MS * 2, elapsed);
+}
+
+void test_ungrouping_is_applied_when_complete() {
+    unsigned long elapsed;
+    TEST_ASSERT_TRUE(refresh(Framing::CONTENT_LENGTH, true, elapsed) == SonosResult::SUCCESS);
+    TEST_ASSERT_TRUE(refresh(Framing::DYNAMIC, false, elapsed) == SonosResult::SUCCESS);
+    TEST_ASSERT_EQUAL_STRING(MEMBER_IP, sonos->getCoordinatorIP(MEMBER_IP).c_str());
+    TEST_ASSERT_FALSE(sonos->isGrouped(MEMBER_IP));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_content_length_reply_applies_topology);
+    RUN_TEST(test_reply_without_length_is_neither_chunked_nor_waited_out);
+    RUN_TEST(test_truncated_reply_keeps_previous_topology);
+    RUN_TEST(test_stalled_reply_times_out_and_keeps_previous_topology);
+    RUN_TEST(test_ungrouping_is_applied_when_complete);
+    return UNITY_END();
+}